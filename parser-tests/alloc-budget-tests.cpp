@@ -0,0 +1,146 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <string>
+#include <vector>
+#include "alloc-counter.h"
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using alloc_counter::scoped_alloc_counter;
+
+namespace alloc_budget_tests
+{
+#if defined(_ITERATOR_DEBUG_LEVEL) && _ITERATOR_DEBUG_LEVEL > 0
+    // checked iterators allocate a container proxy next to every string and vector buffer
+    constexpr size_t ALLOCATIONS_PER_COPY = 2;
+#else
+    constexpr size_t ALLOCATIONS_PER_COPY = 1;
+#endif
+
+    // Every token may be copied at most twice: once into the token store and once into the
+    // values of the flag that consumes it. Anything above that is a per-probe or per-call copy.
+    size_t parse_budget(int argc)
+    {
+        return ALLOCATIONS_PER_COPY * (2 * size_t(argc - 1) + 1);
+    }
+
+    TEST_CLASS(AllocBudgetTests)
+    {
+    public:
+        TEST_METHOD(TEST_STAT_PARSE_BUDGET)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"inst_spec,vfp_spec,ase_spec,dp_spec,ld_spec,st_spec,br_immed_spec,crypto_spec", L"-c", L"0", L"--timeout", L"5", L"--json", L"--output", L"_output_02.json" };
+            int argc = 11;
+            arg_parser parser;
+
+            scoped_alloc_counter counter;
+            parser.parse(argc, argv);
+            Assert::IsTrue(counter.allocations() <= parse_budget(argc));
+        }
+
+        TEST_METHOD(TEST_RECORD_PARSE_BUDGET)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"-e", L"ld_spec:100000", L"-c", L"1", L"--timeout", L"30", L"--", L"python_d.exe", L"-c", L"10**10**100" };
+            int argc = 12;
+            arg_parser parser;
+
+            scoped_alloc_counter counter;
+            parser.parse(argc, argv);
+            Assert::IsTrue(counter.allocations() <= parse_budget(argc));
+        }
+
+        TEST_METHOD(TEST_PASSTHROUGH_IS_NOT_COPIED)
+        {
+            // tokens after `--` are only stored once; the child command line and argv add a constant
+            std::vector<std::wstring> storage;
+            for (int i = 0; i < 1000; ++i) storage.push_back(L"child_argument_" + std::to_wstring(i));
+            std::vector<const wchar_t*> argv = { L"wperf", L"record", L"--" };
+            for (auto& arg : storage) argv.push_back(arg.c_str());
+            arg_parser parser;
+
+            scoped_alloc_counter counter;
+            parser.parse(static_cast<int>(argv.size()), argv.data());
+            Assert::IsTrue(counter.allocations() <= ALLOCATIONS_PER_COPY * (argv.size() + 8));
+        }
+
+        TEST_METHOD(TEST_FLAG_PROBING_DOES_NOT_ALLOCATE)
+        {
+            // boolean flags have no values, so only the token store may allocate
+            std::vector<const wchar_t*> argv = { L"wperf", L"stat" };
+            for (int i = 0; i < 200; ++i) argv.push_back(L"--sample-display-long");
+            arg_parser parser;
+
+            scoped_alloc_counter counter;
+            parser.parse(static_cast<int>(argv.size()), argv.data());
+            Assert::IsTrue(counter.allocations() <= ALLOCATIONS_PER_COPY * argv.size());
+        }
+
+        TEST_METHOD(TEST_GET_VALUES_DOES_NOT_ALLOCATE)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"inst_spec,vfp_spec,ase_spec,dp_spec,ld_spec,st_spec,br_immed_spec,crypto_spec" };
+            int argc = 4;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            scoped_alloc_counter counter;
+            size_t total = 0;
+            for (int i = 0; i < 100; ++i)
+                total += parser.events_arg.get_values().front().size();
+            Assert::AreEqual(size_t(0), counter.allocations());
+            Assert::IsTrue(total > 0);
+        }
+
+        TEST_METHOD(TEST_ARG_PARSE_DOES_NOT_COPY_INPUT)
+        {
+            std::vector<std::wstring> tokens = { L"stat", L"--annotate-this-is-a-long-unmatched-token", L"--json" };
+            arg_parser_arg_opt arg(L"--json", {}, L"Define output type as JSON.");
+
+            scoped_alloc_counter counter;
+            Assert::IsFalse(arg.parse(tokens, 1));
+            Assert::IsTrue(arg.parse(tokens, 2));
+            Assert::AreEqual(size_t(0), counter.allocations());
+        }
+
+        TEST_METHOD(TEST_SNIFF_COMMAND_DOES_NOT_ALLOCATE)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"-c", L"1", L"--", L"notepad.exe" };
+            int argc = 6;
+
+            scoped_alloc_counter counter;
+            Assert::IsTrue(COMMAND_CLASS::RECORD == arg_parser::sniff_command(argc, argv));
+            Assert::AreEqual(size_t(0), counter.allocations());
+        }
+    };
+}
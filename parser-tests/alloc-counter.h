@@ -0,0 +1,59 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cstddef>
+
+// Counts heap allocations made through the global operator new on the calling thread.
+// The replacement operators live in alloc-counter.cpp and apply to the whole test module,
+// which also links the parser objects, so parser code is counted as well.
+namespace alloc_counter {
+    struct alloc_snapshot {
+        size_t m_allocations;
+        size_t m_deallocations;
+        size_t m_bytes;
+    };
+
+    alloc_snapshot get_thread_snapshot();
+
+    class scoped_alloc_counter {
+    public:
+        scoped_alloc_counter() : m_start(get_thread_snapshot()) {}
+
+        size_t allocations() const { return get_thread_snapshot().m_allocations - m_start.m_allocations; }
+        size_t deallocations() const { return get_thread_snapshot().m_deallocations - m_start.m_deallocations; }
+        size_t bytes() const { return get_thread_snapshot().m_bytes - m_start.m_bytes; }
+
+    private:
+        alloc_snapshot m_start;
+    };
+}
@@ -31,6 +31,7 @@
 #include "pch.h"
 #include "CppUnitTest.h"
 #include <unordered_map>
+#include "parser/arg-parser.h"
 #include "parser/arg-parser-arg.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -174,5 +175,64 @@ namespace argparser_arg_tests
             // Ensure that the main flag name is returned without extra formatting
             Assert::AreEqual(std::wstring(L"--quiet"), flags);
         }
+
+        TEST_METHOD(TestPassthroughIsAView)
+        {
+            arg_parser_arg_passthrough arg(L"--", {}, L"Child process.");
+            std::vector<std::wstring> tokens = { L"record", L"--", L"app.exe", L"--input", L"data.bin" };
+            Assert::IsTrue(arg.parse(tokens, 1));
+
+            Assert::AreEqual(3, arg.get_arg_count());
+            Assert::AreEqual(size_t(3), arg.get_value_count());
+            Assert::IsTrue(&arg.get_value(0) == &tokens[2]);
+            Assert::IsTrue(arg.get_values() == std::vector<std::wstring>({ L"app.exe", L"--input", L"data.bin" }));
+        }
+
+        TEST_METHOD(TestPassthroughIsSet)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"--", L"notepad.exe", L"test_arg" };
+            ArgParser::arg_parser parser;
+            parser.parse(5, argv);
+            Assert::AreEqual(size_t(2), parser.extra_args_arg.get_value_count());
+            Assert::IsTrue(parser.extra_args_arg.is_set());
+        }
+
+        TEST_METHOD(TestPassthroughCommandLineQuoting)
+        {
+            arg_parser_arg_passthrough arg(L"--", {}, L"Child process.");
+            std::vector<std::wstring> tokens = { L"--", L"C:\\Program Files\\app.exe", L"plain", L"", L"say \"hi\"", L"C:\\dir with space\\", L"a\\\\b" };
+            Assert::IsTrue(arg.parse(tokens, 0));
+
+            Assert::AreEqual(std::wstring(L"\"C:\\Program Files\\app.exe\" plain \"\" \"say \\\"hi\\\"\" \"C:\\dir with space\\\\\" a\\\\b"), arg.get_command_line());
+        }
+
+        TEST_METHOD(TestPassthroughArgv)
+        {
+            arg_parser_arg_passthrough arg(L"--", {}, L"Child process.");
+            std::vector<std::wstring> tokens = { L"--", L"python3", L"caf\u00e9.py" };
+            Assert::IsTrue(arg.parse(tokens, 0));
+
+            char* const* argv = arg.get_argv();
+            Assert::AreEqual(std::string("python3"), std::string(argv[0]));
+            Assert::AreEqual(std::string("caf\xC3\xA9.py"), std::string(argv[1]));
+            Assert::IsNull(argv[2]);
+        }
+
+        TEST_METHOD(TestPassthroughLongArgumentList)
+        {
+            arg_parser_arg_passthrough arg(L"--", {}, L"Child process.");
+            std::vector<std::wstring> tokens = { L"--" };
+            for (size_t i = 0; i < 100000; ++i)
+                tokens.push_back(i % 2 ? L"file " + std::to_wstring(i) : std::to_wstring(i));
+            Assert::IsTrue(arg.parse(tokens, 0));
+
+            char* const* argv = arg.get_argv();
+            Assert::AreEqual(size_t(100000), arg.get_value_count());
+            Assert::AreEqual(std::string("file 99999"), std::string(argv[99999]));
+            Assert::IsNull(argv[100000]);
+            const std::wstring& command_line = arg.get_command_line();
+            Assert::IsTrue(command_line.compare(0, 11, L"0 \"file 1\" ") == 0);
+            Assert::IsTrue(command_line.compare(command_line.size() - 12, 12, L"\"file 99999\"") == 0);
+        }
     };
 }
\ No newline at end of file
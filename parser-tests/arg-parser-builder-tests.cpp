@@ -0,0 +1,138 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using namespace ArgParserArg;
+
+namespace arg_parser_builder_tests
+{
+    TEST_CLASS(ArgParserBuilderTests)
+    {
+    public:
+        TEST_METHOD(TEST_BUILD_FLAG)
+        {
+            arg_parser_arg_pos arg = arg_builder<arg_parser_arg_pos>(L"--timeout")
+                .alias(L"sleep")
+                .alias(L"-t")
+                .description(L"Counting duration.")
+                .default_value(L"1")
+                .build();
+
+            Assert::AreEqual(std::wstring(L"--timeout"), arg.m_name);
+            Assert::AreEqual(std::wstring(L"sleep, -t"), arg.get_alias_string());
+            Assert::AreEqual(std::wstring(L"Counting duration."), arg.m_description);
+            Assert::AreEqual(1, arg.get_arg_count());
+            Assert::AreEqual(size_t(1), arg.get_values().size());
+            Assert::IsTrue(arg.is_match(L"-t"));
+        }
+
+        TEST_METHOD(TEST_BUILD_FLAG_WITH_CHECKS)
+        {
+            arg_parser_arg_pos arg = arg_builder<arg_parser_arg_pos>(L"-n")
+                .validator<validators::is_uint>()
+                .check_func([](const std::wstring& value) { return value != L"13"; })
+                .build();
+
+            Assert::IsTrue(arg.parse({ L"-n", L"12" }));
+            Assert::ExpectException<std::invalid_argument>([&arg]() { arg.parse({ L"-n", L"x" }); });
+            Assert::ExpectException<std::invalid_argument>([&arg]() { arg.parse({ L"-n", L"13" }); });
+        }
+
+        TEST_METHOD(TEST_BUILD_COMMAND)
+        {
+            arg_parser_arg_command command = command_builder(L"man", COMMAND_CLASS::MAN)
+                .description(L"Describe events.")
+                .usage(L"wperf man <event>")
+                .example(L"> wperf man ld_spec")
+                .arg_count(1)
+                .build();
+
+            Assert::IsTrue(command.m_command == COMMAND_CLASS::MAN);
+            Assert::AreEqual(std::wstring(L"wperf man <event>"), command.m_useage_text);
+            Assert::AreEqual(size_t(1), command.m_examples.size());
+            Assert::IsTrue(command.parse({ L"man", L"ld_spec" }));
+            Assert::AreEqual(std::wstring(L"ld_spec"), command.get_values().front());
+        }
+
+        TEST_METHOD(TEST_CHAINING_RETURNS_SAME_OBJECT)
+        {
+            arg_parser_arg arg(L"--input", {}, L"Input file.");
+            arg_parser_arg& chained = arg.add_alias(L"-i").add_alias(L"-in").add_check_func([](const std::wstring&) { return true; });
+            Assert::IsTrue(&chained == &arg);
+            Assert::AreEqual(size_t(2), arg.m_aliases.size());
+        }
+    };
+
+    TEST_CLASS(ArgParserBuilderBenchmark)
+    {
+    public:
+        TEST_METHOD(BENCH_CONSTRUCTION)
+        {
+            const size_t parsers = 2000;
+            auto start = std::chrono::steady_clock::now();
+            size_t commands = 0;
+            for (size_t i = 0; i < parsers; ++i)
+            {
+                arg_parser parser;
+                commands += parser.m_commands_list.size();
+            }
+            auto parser_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const size_t flags = 20000;
+            const std::wstring description(200, L'x');
+            std::vector<arg_parser_arg_pos> built;
+            built.reserve(flags);
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < flags; ++i)
+            {
+                arg_builder<arg_parser_arg_pos> builder(L"--flag");
+                for (int alias = 0; alias < 8; ++alias) builder.alias(L"-alias-name");
+                built.push_back(builder.description(description).build());
+            }
+            auto builder_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::string message = "construction: arg_parser " + std::to_string(static_cast<long long>(parser_elapsed * 1e6 / parsers))
+                + " us, flag with 8 aliases " + std::to_string(static_cast<long long>(builder_elapsed * 1e9 / flags)) + " ns";
+            Logger::WriteMessage(message.c_str());
+            Assert::AreEqual(flags, built.size());
+            Assert::IsTrue(commands > 0);
+        }
+    };
+}
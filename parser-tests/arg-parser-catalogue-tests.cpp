@@ -0,0 +1,243 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <cwctype>
+#include <string>
+#include <vector>
+#include "alloc-counter.h"
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-catalogue.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using namespace alloc_counter;
+
+namespace arg_parser_catalogue_tests
+{
+    TEST_CLASS(ArgParserCatalogueTests)
+    {
+    public:
+        TEST_METHOD(TEST_FIND_EVERY_ENTRY)
+        {
+            for (auto& event : get_events())
+            {
+                const event_info* found = find_event(event.m_name);
+                Assert::IsTrue(found == &event);
+                Assert::IsNull(find_metric(event.m_name));
+            }
+            for (auto& metric : get_metrics())
+            {
+                Assert::IsTrue(find_metric(metric.m_name) == &metric);
+            }
+            Assert::AreEqual(0x70, static_cast<int>(find_event(L"ld_spec")->m_index));
+        }
+
+        TEST_METHOD(TEST_FIND_UNKNOWN)
+        {
+            Assert::IsNull(find_event(L"ld_spe"));
+            Assert::IsNull(find_event(L"ld_spec_"));
+            Assert::IsNull(find_event(L""));
+            Assert::IsNull(find_metric(L"imix2"));
+        }
+
+        TEST_METHOD(TEST_RAW_EVENTS)
+        {
+            Assert::IsTrue(is_raw_event(L"r1b"));
+            Assert::IsTrue(is_raw_event(L"rFFFF"));
+            Assert::IsFalse(is_raw_event(L"r"));
+            Assert::IsFalse(is_raw_event(L"r10000"));
+            Assert::IsFalse(is_raw_event(L"rxyz"));
+        }
+
+        TEST_METHOD(TEST_VALIDATE_EVENTS)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"{inst_spec,vfp_spec},r1b,ld_spec:100000", L"-m", L"imix", L"--", L"app.exe" };
+            parser.parse(8, argv);
+            Assert::IsTrue(parser.events_arg.is_parsed());
+        }
+
+        TEST_METHOD(TEST_REJECT_UNKNOWN_EVENT)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"inst_spec,no_such_event" };
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(4, argv); });
+        }
+
+        TEST_METHOD(TEST_REJECT_UNKNOWN_METRIC)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-m", L"imix,no_such_metric" };
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(4, argv); });
+        }
+
+        TEST_METHOD(TEST_PMU_EVENTS_SKIP_VALIDATION)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"record", L"-e", L"arm_spe_0/ld=1,st=1/,ld_spec", L"-c", L"8", L"--", L"python_d.exe" };
+            parser.parse(8, argv);
+            Assert::IsTrue(parser.events_arg.is_parsed());
+
+            arg_parser unknown;
+            const wchar_t* unknown_argv[] = { L"wperf", L"stat", L"-e", L"arm_spe_0/ld=1/,ld-spec" };
+            Assert::ExpectException<std::invalid_argument>([&]() { unknown.parse(4, unknown_argv); });
+        }
+
+        // Every example in the help parses: the command line runs up to the first word of its
+        // description, which starts with a capital letter
+        TEST_METHOD(TEST_HELP_EXAMPLES_PARSE)
+        {
+            arg_parser help;
+            size_t examples = 0;
+            for (auto command : help.m_commands_list)
+            {
+                for (auto& example : command->m_examples)
+                {
+                    Assert::AreEqual(size_t(0), example.find(L"> wperf "));
+                    std::vector<std::wstring> tokens;
+                    for (size_t begin = 2; begin < example.size();)
+                    {
+                        const size_t end = (std::min)(example.find(L' ', begin), example.size());
+                        if (iswupper(example[begin])) break;
+                        tokens.emplace_back(example, begin, end - begin);
+                        begin = end + 1;
+                    }
+                    std::vector<const wchar_t*> argv;
+                    for (auto& token : tokens) argv.push_back(token.c_str());
+
+                    arg_parser parser;
+                    parser.parse(static_cast<int>(argv.size()), argv.data());
+                    ++examples;
+                }
+            }
+            Assert::IsTrue(examples >= 7);
+        }
+
+        TEST_METHOD(TEST_CUSTOM_EVENTS_SKIP_VALIDATION)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-E", L"custom_event:0x1234", L"-e", L"custom_event" };
+            parser.parse(6, argv);
+            Assert::IsTrue(parser.events_arg.is_parsed());
+        }
+
+        TEST_METHOD(TEST_MAN_NAMES)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"man", L"ld_spec,imix", L"--json" };
+            parser.parse(4, argv);
+            Assert::IsTrue(parser.m_command == COMMAND_CLASS::MAN);
+            Assert::IsTrue(parser.man_command.get_values().front() == L"ld_spec,imix");
+            Assert::IsTrue(parser.json_opt.is_parsed());
+
+            arg_parser unknown;
+            const wchar_t* unknown_argv[] = { L"wperf", L"man", L"no_such_event" };
+            Assert::ExpectException<std::invalid_argument>([&]() { unknown.parse(3, unknown_argv); });
+
+            arg_parser missing;
+            const wchar_t* missing_argv[] = { L"wperf", L"man" };
+            Assert::ExpectException<std::invalid_argument>([&]() { missing.parse(2, missing_argv); });
+        }
+
+        TEST_METHOD(TEST_MANUAL_JSON)
+        {
+            std::string buffer;
+            json_writer json(buffer);
+            Assert::IsTrue(write_manual(L"ld_spec", json));
+            Assert::IsTrue(buffer.find("\"index\":112") != std::string::npos);
+            Assert::IsFalse(write_manual(L"no_such_event", json));
+        }
+
+        TEST_METHOD(TEST_LIST_STREAMS_WITHOUT_ALLOCATING)
+        {
+            std::string buffer;
+            {
+                json_writer json(buffer);
+                write_catalogue(json);
+            }
+            const size_t size = buffer.size();
+
+            scoped_alloc_counter counter;
+            buffer.clear();
+            json_writer json(buffer);
+            write_catalogue(json);
+            Assert::AreEqual(size_t(0), counter.allocations());
+            Assert::AreEqual(size, buffer.size());
+
+            size_t names = 0;
+            for (size_t pos = buffer.find("\"name\""); pos != std::string::npos; pos = buffer.find("\"name\"", pos + 1)) ++names;
+            Assert::AreEqual(get_events().size() + get_metrics().size(), names);
+        }
+    };
+
+    TEST_CLASS(ArgParserCatalogueBenchmark)
+    {
+    public:
+        TEST_METHOD(BENCH_EVENT_LOOKUP)
+        {
+            std::vector<std::wstring> names;
+            for (auto& event : get_events()) names.emplace_back(event.m_name);
+            names.emplace_back(L"no_such_event");
+
+            const size_t iterations = 20000;
+            size_t found = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                for (auto& name : names) found += find_event(name) != nullptr;
+            }
+            auto hashed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                for (auto& name : names)
+                {
+                    for (auto& event : get_events())
+                    {
+                        if (event.m_name == name) { --found; break; }
+                    }
+                }
+            }
+            auto linear = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const double lookups = static_cast<double>(iterations * names.size());
+            std::string message = "catalogue lookup: " + std::to_string(static_cast<long long>(hashed * 1e9 / lookups)) + " ns perfect hash, "
+                + std::to_string(static_cast<long long>(linear * 1e9 / lookups)) + " ns linear scan";
+            Logger::WriteMessage(message.c_str());
+            Assert::AreEqual(size_t(0), found);
+        }
+    };
+}
@@ -0,0 +1,255 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-constraints.h"
+#include "parser/arg-parser-output.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_constraints_tests
+{
+    // Parses argv, which starts with the command, and returns the error text or an empty string
+    std::string parse_error(const std::vector<const wchar_t*>& tokens)
+    {
+        std::vector<const wchar_t*> argv = { L"wperf" };
+        argv.insert(argv.end(), tokens.begin(), tokens.end());
+        buffer_sink errors;
+        arg_parser parser;
+        parser.set_error_sink(errors);
+        try
+        {
+            parser.parse(static_cast<int>(argv.size()), argv.data());
+        }
+        catch (const std::invalid_argument&)
+        {
+            return errors.get_buffer();
+        }
+        return "";
+    }
+
+    // A few flags and commands with their own rule table, to check the engine without the built-in rules
+    struct rule_fixture {
+        arg_parser_arg_opt m_a{ L"-a", {}, L"" };
+        arg_parser_arg_opt m_b{ L"-b", {}, L"" };
+        arg_parser_arg_opt m_c{ L"-c", {}, L"" };
+        arg_parser_arg_opt m_d{ L"-d", {}, L"" };
+        arg_parser_arg_opt m_run{ L"run", {}, L"" };
+        arg_parser_arg_opt m_walk{ L"walk", {}, L"" };
+        flag_constraints m_constraints;
+
+        explicit rule_fixture(const std::vector<flag_rule>& rules)
+        {
+            m_constraints = flag_constraints(rules.data(), rules.size(),
+                [this](std::wstring_view name) -> arg_parser_arg* {
+                    for (auto* flag : { &m_a, &m_b, &m_c, &m_d })
+                        if (flag->m_name == name) return flag;
+                    return nullptr;
+                },
+                [this](std::wstring_view name) -> arg_parser_arg* {
+                    for (auto* command : { &m_run, &m_walk })
+                        if (command->m_name == name) return command;
+                    return nullptr;
+                });
+        }
+
+        std::vector<rule_violation> evaluate(std::vector<arg_parser_arg_opt*> given, const arg_parser_arg* command)
+        {
+            for (auto* flag : { &m_a, &m_b, &m_c, &m_d }) flag->reset();
+            for (auto* flag : given) flag->parse({ flag->m_name });
+            std::vector<rule_violation> violations;
+            m_constraints.evaluate(command, violations);
+            return violations;
+        }
+    };
+
+    TEST_CLASS(ArgParserConstraintsTests)
+    {
+    public:
+        TEST_METHOD(TEST_IMPLIES_IS_TRANSITIVE)
+        {
+            rule_fixture fixture({ { FLAG_RULE::IMPLIES, L"-a", L"-b" }, { FLAG_RULE::IMPLIES, L"-b", L"-c" } });
+            Assert::IsTrue(fixture.evaluate({ &fixture.m_a }, &fixture.m_run).empty());
+            Assert::IsTrue(fixture.m_b.m_is_parsed);
+            Assert::IsTrue(fixture.m_c.m_is_parsed);
+            Assert::IsFalse(fixture.m_d.m_is_parsed);
+        }
+
+        TEST_METHOD(TEST_IMPLIED_FLAG_IS_DROPPED_WITH_ITS_CAUSE)
+        {
+            rule_fixture fixture({ { FLAG_RULE::IMPLIES, L"-a", L"-b" } });
+            fixture.evaluate({ &fixture.m_a }, &fixture.m_run);
+            Assert::IsTrue(fixture.m_b.m_is_implied);
+
+            // -a is gone, so is -b; but a -b given on its own stays
+            fixture.m_a.reset();
+            std::vector<rule_violation> violations;
+            fixture.m_constraints.evaluate(&fixture.m_run, violations);
+            Assert::IsFalse(fixture.m_b.m_is_parsed);
+
+            fixture.m_b.parse({ L"-b" });
+            fixture.m_constraints.evaluate(&fixture.m_run, violations);
+            Assert::IsTrue(fixture.m_b.m_is_parsed);
+            Assert::IsFalse(fixture.m_b.m_is_implied);
+        }
+
+        TEST_METHOD(TEST_REQUIRES)
+        {
+            rule_fixture fixture({ { FLAG_RULE::REQUIRES, L"-a", L"-b" }, { FLAG_RULE::IMPLIES, L"-c", L"-b" } });
+            auto violations = fixture.evaluate({ &fixture.m_a }, &fixture.m_run);
+            Assert::AreEqual(size_t(1), violations.size());
+            Assert::IsTrue(FLAG_RULE::REQUIRES == violations[0].m_kind);
+            Assert::IsTrue(&fixture.m_b == violations[0].m_other);
+            Assert::AreEqual(std::wstring(L"-a requires -b"), fixture.m_constraints.describe(violations[0]));
+
+            Assert::IsTrue(fixture.evaluate({ &fixture.m_a, &fixture.m_b }, &fixture.m_run).empty());
+            // an implied flag satisfies the rule too
+            Assert::IsTrue(fixture.evaluate({ &fixture.m_a, &fixture.m_c }, &fixture.m_run).empty());
+        }
+
+        TEST_METHOD(TEST_CONFLICTS_REPORTED_ONCE)
+        {
+            rule_fixture fixture({ { FLAG_RULE::CONFLICTS, L"-b", L"-a" }, { FLAG_RULE::IMPLIES, L"-c", L"-a" } });
+            auto violations = fixture.evaluate({ &fixture.m_a, &fixture.m_b }, &fixture.m_run);
+            Assert::AreEqual(size_t(1), violations.size());
+            Assert::IsTrue(FLAG_RULE::CONFLICTS == violations[0].m_kind);
+
+            violations = fixture.evaluate({ &fixture.m_b, &fixture.m_c }, &fixture.m_run);
+            Assert::AreEqual(size_t(1), violations.size());
+            Assert::AreEqual(std::wstring(L"-b cannot be used with -a"), fixture.m_constraints.describe(violations[0]));
+        }
+
+        TEST_METHOD(TEST_ONLY_WITH_COMMAND)
+        {
+            rule_fixture fixture({ { FLAG_RULE::ONLY_WITH_COMMAND, L"-a", L"run" }, { FLAG_RULE::ONLY_WITH_COMMAND, L"-a", L"walk" },
+                { FLAG_RULE::ONLY_WITH_COMMAND, L"-b", L"walk" } });
+            Assert::IsTrue(fixture.evaluate({ &fixture.m_a, &fixture.m_c }, &fixture.m_run).empty());
+            Assert::IsTrue(fixture.evaluate({ &fixture.m_a }, &fixture.m_walk).empty());
+
+            auto violations = fixture.evaluate({ &fixture.m_a, &fixture.m_b }, &fixture.m_run);
+            Assert::AreEqual(size_t(1), violations.size());
+            Assert::AreEqual(std::wstring(L"-b is only valid with walk"), fixture.m_constraints.describe(violations[0]));
+
+            violations = fixture.evaluate({ &fixture.m_a }, &fixture.m_c);
+            Assert::AreEqual(std::wstring(L"-a is only valid with run, walk"), fixture.m_constraints.describe(violations[0]));
+        }
+
+        TEST_METHOD(TEST_BAD_TABLES)
+        {
+            Assert::ExpectException<std::invalid_argument>([]() { rule_fixture({ { FLAG_RULE::REQUIRES, L"-a", L"-z" } }); });
+            Assert::ExpectException<std::invalid_argument>([]() { rule_fixture({ { FLAG_RULE::ONLY_WITH_COMMAND, L"-a", L"fly" } }); });
+            Assert::ExpectException<std::invalid_argument>([]() { rule_fixture({ { FLAG_RULE::CONFLICTS, L"-a", L"-a" } }); });
+        }
+
+        TEST_METHOD(TEST_DISASSEMBLE_IMPLIES_ANNOTATE)
+        {
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--disassemble" };
+            arg_parser parser;
+            parser.parse(3, argv);
+            Assert::IsTrue(parser.annotate_opt.m_is_parsed);
+        }
+
+        TEST_METHOD(TEST_BUILT_IN_RULES)
+        {
+            Assert::AreEqual(std::string(), parse_error({ L"stat", L"-t", L"-i", L"2", L"-n", L"3", L"--output-csv", L"out.csv" }));
+            Assert::AreEqual(std::string(), parse_error({ L"record", L"--symbol", L"main", L"--record_spawn_delay", L"100", L"--", L"app.exe" }));
+
+            Assert::AreNotEqual(std::string::npos, parse_error({ L"stat", L"--output-csv", L"out.csv" }).find("--output-csv requires -t"));
+            Assert::AreNotEqual(std::string::npos, parse_error({ L"sample", L"--pdb_file", L"app.pdb" }).find("--pdb_file requires --pe_file"));
+            Assert::AreNotEqual(std::string::npos, parse_error({ L"stat", L"--symbol", L"main" }).find("--symbol is only valid with sample, record"));
+            Assert::AreNotEqual(std::string::npos, parse_error({ L"sample", L"--record_spawn_delay", L"1" }).find("--record_spawn_delay is only valid with record"));
+        }
+
+        TEST_METHOD(TEST_EVERY_VIOLATION_REPORTED)
+        {
+            const std::string error = parse_error({ L"stat", L"-i", L"2", L"-n", L"3", L"--annotate" });
+            Assert::AreNotEqual(std::string::npos, error.find("the following flags are used incorrectly"));
+            Assert::AreNotEqual(std::string::npos, error.find("--annotate is only valid with sample, record"));
+            Assert::AreNotEqual(std::string::npos, error.find("-i requires -t"));
+            Assert::AreNotEqual(std::string::npos, error.find("-n requires -t"));
+        }
+
+        TEST_METHOD(TEST_COLD_START_SCENARIOS_PARSE)
+        {
+            // tools/cold-start.ps1 fails CI when a scenario does not parse; its `"name" = "arguments"`
+            // lines are read from the script itself, so the list here cannot fall behind
+            const std::filesystem::path script = std::filesystem::path(__FILE__).parent_path().parent_path() / "tools" / "cold-start.ps1";
+            std::ifstream file(script);
+            Assert::IsTrue(file.is_open(), L"tools/cold-start.ps1 not found");
+
+            size_t scenarios = 0;
+            bool is_in_scenarios = false;
+            for (std::string line; std::getline(file, line);)
+            {
+                if (line.find("$scenarios = ") != std::string::npos)
+                {
+                    is_in_scenarios = true;
+                    continue;
+                }
+                if (!is_in_scenarios) continue;
+                if (line.find('}') != std::string::npos) break;
+
+                const size_t equals = line.find("= \"");
+                if (equals == std::string::npos) continue;
+                const size_t begin = equals + 3;
+                const std::string arguments = line.substr(begin, line.rfind('"') - begin);
+
+                std::vector<std::wstring> tokens;
+                for (size_t position = 0; position < arguments.size();)
+                {
+                    const size_t end = (std::min)(arguments.find(' ', position), arguments.size());
+                    tokens.emplace_back(arguments.begin() + position, arguments.begin() + end);
+                    position = end + 1;
+                }
+                std::vector<const wchar_t*> argv;
+                for (auto& token : tokens) argv.push_back(token.c_str());
+
+                const std::string error = parse_error(argv);
+                Assert::AreEqual(std::string(), error, std::wstring(arguments.begin(), arguments.end()).c_str());
+                ++scenarios;
+            }
+            Assert::AreEqual(size_t(3), scenarios);
+        }
+
+        TEST_METHOD(TEST_QUIET_AND_VERBOSE_STAY_COMPATIBLE)
+        {
+            Assert::AreEqual(std::string(), parse_error({ L"sample", L"--verbose", L"-q" }));
+        }
+    };
+}
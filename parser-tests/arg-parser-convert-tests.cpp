@@ -0,0 +1,206 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include "alloc-counter.h"
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using namespace ArgParserArg;
+using alloc_counter::scoped_alloc_counter;
+
+namespace arg_parser_convert_tests
+{
+    TEST_CLASS(ArgParserConvertTests)
+    {
+    public:
+        TEST_METHOD(TEST_CONVERT_VALUE_VALID)
+        {
+            int int_value = 0;
+            long long long_value = 0;
+            double double_value = 0;
+            std::filesystem::path path_value;
+
+            Assert::IsTrue(convert_value(L"42", int_value));
+            Assert::AreEqual(42, int_value);
+            Assert::IsTrue(convert_value(L"-7", int_value));
+            Assert::AreEqual(-7, int_value);
+            Assert::IsTrue(convert_value(L"99999999999", long_value));
+            Assert::AreEqual(99999999999LL, long_value);
+            Assert::IsTrue(convert_value(L"10.5", double_value));
+            Assert::AreEqual(10.5, double_value);
+            Assert::IsTrue(convert_value(L"C:\\data\\app.exe", path_value));
+            Assert::AreEqual(std::wstring(L"C:\\data\\app.exe"), path_value.wstring());
+        }
+
+        TEST_METHOD(TEST_CONVERT_VALUE_INVALID)
+        {
+            int int_value = 0;
+            double double_value = 0;
+            std::filesystem::path path_value;
+
+            Assert::IsFalse(convert_value(L"", int_value));
+            Assert::IsFalse(convert_value(L"12a", int_value));
+            Assert::IsFalse(convert_value(L" 1", int_value));
+            Assert::IsFalse(convert_value(L"99999999999", int_value));
+            Assert::IsFalse(convert_value(L"\uff11", int_value));
+            Assert::IsFalse(convert_value(std::wstring(100, L'1'), int_value));
+            Assert::IsFalse(convert_value(L"1e400", double_value));
+            Assert::IsFalse(convert_value(L"nan", double_value));
+            Assert::IsFalse(convert_value(L"inf", double_value));
+            Assert::IsFalse(convert_value(L"", path_value));
+        }
+
+        TEST_METHOD(TEST_CONVERT_DURATION)
+        {
+            using namespace std::chrono_literals;
+            std::chrono::nanoseconds value{};
+
+            Assert::IsTrue(convert_value(L"5", value));
+            Assert::IsTrue(value == 5s);
+            Assert::IsTrue(convert_value(L"0.1", value));
+            Assert::IsTrue(value == 100ms);
+            Assert::IsTrue(convert_value(L"2.25ms", value));
+            Assert::IsTrue(value == 2250us);
+            Assert::IsTrue(convert_value(L"1.5m", value));
+            Assert::IsTrue(value == 90s);
+            Assert::IsTrue(convert_value(L"1h", value));
+            Assert::IsTrue(value == 1h);
+            Assert::IsTrue(convert_value(L"0.01d", value));
+            Assert::IsTrue(value == 864s);
+
+            Assert::IsFalse(convert_value(L"", value));
+            Assert::IsFalse(convert_value(L"1.", value));
+            Assert::IsFalse(convert_value(L"1.234", value));
+            Assert::IsFalse(convert_value(L"5 s", value));
+            Assert::IsFalse(convert_value(L"5us", value));
+            Assert::IsFalse(convert_value(L"200000d", value));
+        }
+
+        TEST_METHOD(TEST_GET_PARSED_VALUES)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"-t", L"-n", L"12", L"--timeout", L"10.5", L"--pe_file", L"app.exe", L"--", L"app.exe" };
+            int argc = 11;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            Assert::AreEqual(12, parser.iteration_arg.get<int>());
+            Assert::AreEqual(12LL, parser.iteration_arg.get<long long>());
+            Assert::AreEqual(10.5, parser.timeout_arg.get<double>());
+            Assert::IsTrue(parser.timeout_arg.get<std::chrono::nanoseconds>() == std::chrono::milliseconds(10500));
+            Assert::AreEqual(std::wstring(L"app.exe"), parser.pe_file_arg.get<std::filesystem::path>().wstring());
+        }
+
+        TEST_METHOD(TEST_GET_DEFAULT_AND_OVERRIDE)
+        {
+            arg_parser parser;
+            Assert::AreEqual(50, parser.sample_display_row_arg.get<int>());
+
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--sample-display-row", L"100" };
+            int argc = 4;
+            parser.parse(argc, argv);
+            Assert::AreEqual(100, parser.sample_display_row_arg.get<int>());
+            Assert::AreEqual(size_t(1), parser.sample_display_row_arg.get_value_count());
+        }
+
+        TEST_METHOD(TEST_GET_ERRORS)
+        {
+            arg_parser_arg_pos arg(L"--name", {}, L"Test argument", {}, 1);
+            Assert::ExpectException<std::out_of_range>([&]() { arg.get<int>(); });
+            Assert::AreEqual(size_t(0), arg.get<arg_span<const int>>().size());
+
+            arg.parse({ L"--name", L"value" });
+            Assert::ExpectException<std::invalid_argument>([&]() { arg.get<int>(); });
+            Assert::ExpectException<std::invalid_argument>([&]() { arg.get<double>(); });
+            Assert::AreEqual(std::wstring(L"value"), arg.get<std::filesystem::path>().wstring());
+        }
+
+        TEST_METHOD(TEST_GET_SPAN)
+        {
+            arg_parser_arg_pos arg(L"--name", {}, L"Test argument", {}, 3);
+            arg.parse({ L"--name", L"1", L"2", L"3" });
+
+            arg_span<const long long> values = arg.get<arg_span<const long long>>();
+            Assert::AreEqual(size_t(3), values.size());
+            Assert::AreEqual(1LL, values[0]);
+            Assert::AreEqual(3LL, values[2]);
+
+            long long sum = 0;
+            for (long long value : values) sum += value;
+            Assert::AreEqual(6LL, sum);
+        }
+
+        TEST_METHOD(TEST_GET_IS_CACHED)
+        {
+            arg_parser_arg_pos arg(L"--name", {}, L"Test argument", {}, 2);
+            arg.parse({ L"--name", L"4", L"5" });
+
+            const int* first = arg.get<arg_span<const int>>().data();
+            scoped_alloc_counter counter;
+            for (int i = 0; i < 1000; ++i)
+            {
+                Assert::AreEqual(4, arg.get<int>());
+                Assert::IsTrue(first == arg.get<arg_span<const int>>().data());
+            }
+            Assert::AreEqual(size_t(0), counter.allocations());
+        }
+
+        TEST_METHOD(TEST_UINT_FLAG_CONVERTED_AT_PARSE)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-t", L"-n", L"3", L"-e", L"ld_spec" };
+            int argc = 7;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            scoped_alloc_counter counter;
+            Assert::AreEqual(3, parser.iteration_arg.get<int>());
+            Assert::AreEqual(3LL, parser.iteration_arg.get<long long>());
+            Assert::AreEqual(size_t(0), counter.allocations());
+        }
+
+        TEST_METHOD(TEST_REPARSE_INVALIDATES_CACHE)
+        {
+            arg_parser_arg_pos arg(L"--name", {}, L"Test argument", {}, 1);
+            arg.parse({ L"--name", L"1" });
+            Assert::AreEqual(1, arg.get<int>());
+
+            arg.m_values.clear();
+            arg.parse({ L"--name", L"2" });
+            Assert::AreEqual(2, arg.get<int>());
+        }
+    };
+}
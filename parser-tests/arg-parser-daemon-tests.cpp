@@ -0,0 +1,291 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "parser/arg-parser-daemon.h"
+#include "parser/arg-parser-result.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_daemon_tests
+{
+    std::string socket_path(const char* name)
+    {
+        return (std::filesystem::temp_directory_path() / name).u8string();
+    }
+
+    // Runs a request through handle_daemon_request and splits the response frame
+    DAEMON_STATUS handle(arg_parser& parser, DAEMON_FORMAT format, const std::vector<std::string>& args, std::string& payload)
+    {
+        std::string request;
+        append_daemon_request(request, format, args);
+        std::string response;
+        buffer_sink errors;
+        handle_daemon_request(parser, errors, static_cast<std::uint8_t>(request[4]), std::string_view(request).substr(DAEMON_FRAME_HEADER_SIZE), response);
+        Assert::IsTrue(response.size() >= DAEMON_FRAME_HEADER_SIZE);
+        payload.assign(response, DAEMON_FRAME_HEADER_SIZE);
+        return static_cast<DAEMON_STATUS>(response[4]);
+    }
+
+    std::string expected_json(const std::vector<const wchar_t*>& argv)
+    {
+        arg_parser parser;
+        parser.parse(static_cast<int>(argv.size()), const_cast<const wchar_t**>(argv.data()));
+        std::string buffer;
+        json_writer json(buffer);
+        parser.write_json(json);
+        return buffer;
+    }
+
+    TEST_CLASS(ArgParserDaemonTests)
+    {
+    public:
+        TEST_METHOD(TEST_DAEMON_COMMAND)
+        {
+            const wchar_t* argv[] = { L"wperf", L"--daemon", L"wperf.sock" };
+            arg_parser parser;
+            parser.parse(3, argv);
+            Assert::IsTrue(COMMAND_CLASS::DAEMON == parser.m_command);
+            Assert::AreEqual(std::wstring(L"wperf.sock"), parser.daemon_command.get_values().front());
+            Assert::IsTrue(COMMAND_CLASS::DAEMON == arg_parser::sniff_command(3, argv));
+
+            buffer_sink help;
+            parser.set_output_sink(help);
+            parser.print_help();
+            Assert::AreNotEqual(std::string::npos, help.get_buffer().find("wperf --daemon <SOCKET>"));
+
+            for (std::vector<const wchar_t*> bad : { std::vector<const wchar_t*>{ L"wperf", L"--daemon" }, { L"wperf", L"--daemon", L"a|b.sock" } })
+            {
+                buffer_sink errors;
+                arg_parser rejected;
+                rejected.set_error_sink(errors);
+                Assert::ExpectException<std::invalid_argument>([&]() { rejected.parse(static_cast<int>(bad.size()), bad.data()); });
+                Assert::IsFalse(errors.get_buffer().empty());
+            }
+        }
+
+        TEST_METHOD(TEST_REQUEST_JSON)
+        {
+            arg_parser parser;
+            std::string payload;
+            Assert::IsTrue(DAEMON_STATUS::OK == handle(parser, DAEMON_FORMAT::JSON, { "stat", "-e", "ld_spec", "-t", "-n", "3" }, payload));
+            Assert::AreEqual(expected_json({ L"wperf", L"stat", L"-e", L"ld_spec", L"-t", L"-n", L"3" }), payload);
+        }
+
+        TEST_METHOD(TEST_REQUEST_BINARY)
+        {
+            arg_parser parser;
+            std::string payload;
+            Assert::IsTrue(DAEMON_STATUS::OK == handle(parser, DAEMON_FORMAT::BINARY, { "record", "--timeout", "2" }, payload));
+
+            std::vector<std::uint64_t> blob((payload.size() + 7) / 8);
+            std::memcpy(blob.data(), payload.data(), payload.size());
+            parse_result_view view(blob.data(), payload.size());
+            Assert::IsTrue(COMMAND_CLASS::RECORD == view.get_command());
+            const size_t timeout = view.find_flag(L"--timeout");
+            Assert::IsTrue(view.is_flag_parsed(timeout));
+            Assert::AreEqual(std::wstring(L"2"), std::wstring(view.get_value(timeout, 0)));
+        }
+
+        TEST_METHOD(TEST_WARM_PARSER_IS_RESET)
+        {
+            arg_parser parser;
+            std::string payload;
+            handle(parser, DAEMON_FORMAT::JSON, { "stat", "-e", "ld_spec", "-t", "-n", "3", "--", "app.exe" }, payload);
+            Assert::IsTrue(DAEMON_STATUS::OK == handle(parser, DAEMON_FORMAT::JSON, { "record", "-k" }, payload));
+            Assert::AreEqual(expected_json({ L"wperf", L"record", L"-k" }), payload);
+        }
+
+        TEST_METHOD(TEST_REQUEST_ERRORS)
+        {
+            arg_parser parser;
+            std::string payload;
+            Assert::IsTrue(DAEMON_STATUS::INVALID_ARGUMENT == handle(parser, DAEMON_FORMAT::JSON, { "stat", "-t", "-n", "x" }, payload));
+            Assert::IsTrue(payload.find("Invalid argument detected:") == 0);
+
+            Assert::IsTrue(DAEMON_STATUS::BAD_REQUEST == handle(parser, static_cast<DAEMON_FORMAT>(7), { "stat" }, payload));
+
+            std::string response;
+            buffer_sink errors;
+            handle_daemon_request(parser, errors, 0, std::string_view("stat", 4), response);
+            Assert::IsTrue(DAEMON_STATUS::BAD_REQUEST == static_cast<DAEMON_STATUS>(response[4]));
+
+            // the parser still works after failed requests
+            Assert::IsTrue(DAEMON_STATUS::OK == handle(parser, DAEMON_FORMAT::JSON, { "stat", "-t", "-n", "4" }, payload));
+        }
+
+        TEST_METHOD(TEST_PIPELINED_REQUESTS_IN_ORDER)
+        {
+            const std::string path = socket_path("wperf-daemon-order.sock");
+            daemon_server server(path);
+            server.listen();
+            std::thread runner([&server]() { server.run(); });
+
+            {
+                daemon_client client(path);
+                for (int i = 1; i <= 200; ++i)
+                    client.send_request(DAEMON_FORMAT::JSON, { "stat", "-t", "-n", std::to_string(i) });
+                client.send_request(DAEMON_FORMAT::JSON, { "stat", "-t", "-n", "0" });
+                client.flush();
+
+                DAEMON_STATUS status;
+                std::string payload;
+                for (int i = 1; i <= 200; ++i)
+                {
+                    Assert::IsTrue(client.read_response(status, payload));
+                    Assert::IsTrue(DAEMON_STATUS::OK == status);
+                    Assert::IsTrue(payload.find("\"-n\":[" + std::to_string(i) + "]") != std::string::npos);
+                }
+                Assert::IsTrue(client.read_response(status, payload));
+                Assert::IsTrue(DAEMON_STATUS::INVALID_ARGUMENT == status);
+            }
+
+            server.stop();
+            runner.join();
+        }
+
+        TEST_METHOD(TEST_LISTEN_KEEPS_FOREIGN_FILES)
+        {
+            const std::string path = socket_path("wperf-daemon-foreign.sock");
+            std::ofstream(std::filesystem::u8path(path)) << "keep";
+            daemon_server server(path);
+            Assert::ExpectException<std::runtime_error>([&server]() { server.listen(); });
+            Assert::IsTrue(std::filesystem::is_regular_file(std::filesystem::u8path(path)));
+            std::filesystem::remove(std::filesystem::u8path(path));
+        }
+
+        TEST_METHOD(TEST_LISTEN_KEEPS_A_RUNNING_DAEMON)
+        {
+            const std::string path = socket_path("wperf-daemon-running.sock");
+            daemon_server first(path);
+            first.listen();
+            std::thread runner([&first]() { first.run(); });
+
+            daemon_server second(path);
+            Assert::ExpectException<std::runtime_error>([&second]() { second.listen(); });
+            daemon_load_report report = run_daemon_load(path, { "stat", "-e", "ld_spec" }, DAEMON_FORMAT::BINARY, 1, 10, 1);
+            Assert::AreEqual(size_t(0), report.m_errors);
+
+            first.stop();
+            runner.join();
+        }
+
+#ifndef _WIN32
+        TEST_METHOD(TEST_LISTEN_REPLACES_A_STALE_SOCKET)
+        {
+            const std::string path = socket_path("wperf-daemon-stale.sock");
+            std::filesystem::remove(std::filesystem::u8path(path));
+            // a socket bound and closed without unlinking, as a daemon that was killed leaves it
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.data(), path.size());
+            const int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            Assert::AreEqual(0, ::bind(stale, reinterpret_cast<const sockaddr*>(&address), sizeof(address)));
+            ::close(stale);
+
+            daemon_server server(path);
+            server.listen();
+            server.stop();
+            Assert::IsFalse(std::filesystem::exists(std::filesystem::u8path(path)));
+        }
+
+        TEST_METHOD(TEST_LISTEN_SOCKET_IS_PRIVATE)
+        {
+            const std::string path = socket_path("wperf-daemon-private.sock");
+            const mode_t mask = ::umask(S_IWGRP | S_IWOTH);
+            daemon_server server(path);
+            server.listen();
+            const std::filesystem::perms perms = std::filesystem::status(std::filesystem::u8path(path)).permissions();
+            Assert::IsTrue((perms & std::filesystem::perms::all) == (std::filesystem::perms::owner_read | std::filesystem::perms::owner_write));
+            // the narrower mask is only in place around bind
+            Assert::AreEqual(static_cast<int>(S_IWGRP | S_IWOTH), static_cast<int>(::umask(mask)));
+            server.stop();
+        }
+#endif
+
+        TEST_METHOD(TEST_CONCURRENT_CONNECTIONS)
+        {
+            const std::string path = socket_path("wperf-daemon-concurrent.sock");
+            daemon_server server(path);
+            server.listen();
+            std::thread runner([&server]() { server.run(); });
+
+            daemon_load_report report = run_daemon_load(path, { "stat", "-e", "ld_spec,st_spec", "-t", "-n", "3" }, DAEMON_FORMAT::BINARY, 8, 250, 8);
+            Assert::AreEqual(size_t(2000), report.m_requests);
+            Assert::AreEqual(size_t(0), report.m_errors);
+
+            server.stop();
+            runner.join();
+        }
+
+        TEST_METHOD(BENCH_DAEMON_LOAD)
+        {
+            const std::string path = socket_path("wperf-daemon-bench.sock");
+            daemon_server server(path);
+            server.listen();
+            std::thread runner([&server]() { server.run(); });
+
+            const std::vector<std::string> args = { "record", "-e", "ld_spec,vfp_spec", "-c", "0", "--timeout", "2", "--", "app.exe" };
+            for (size_t depth : { 1, 16 })
+            {
+                for (DAEMON_FORMAT format : { DAEMON_FORMAT::BINARY, DAEMON_FORMAT::JSON })
+                {
+                    daemon_load_report report = run_daemon_load(path, args, format, 4, 5000, depth);
+                    std::string message = std::string(format == DAEMON_FORMAT::JSON ? "json" : "binary")
+                        + ", pipeline depth " + std::to_string(depth) + ": "
+                        + std::to_string(static_cast<long long>(report.get_requests_per_second())) + " requests/s, p50 "
+                        + std::to_string(report.m_p50_us) + " us, p99 " + std::to_string(report.m_p99_us) + " us";
+                    Logger::WriteMessage(message.c_str());
+                    Assert::AreEqual(size_t(0), report.m_errors);
+                }
+            }
+
+            server.stop();
+            runner.join();
+        }
+    };
+}
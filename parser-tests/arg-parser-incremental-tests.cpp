@@ -0,0 +1,281 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include "parser/arg-parser-incremental.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_incremental_tests
+{
+    std::vector<const wchar_t*> make_argv(const wstr_vec& tokens)
+    {
+        std::vector<const wchar_t*> argv = { L"wperf" };
+        for (auto& token : tokens) argv.push_back(token.c_str());
+        return argv;
+    }
+
+    void parse_tokens(incremental_parser& parser, const wstr_vec& tokens)
+    {
+        std::vector<const wchar_t*> argv = make_argv(tokens);
+        parser.parse(static_cast<int>(argv.size()), argv.data());
+    }
+
+    std::string to_json(const arg_parser& parser)
+    {
+        std::string buffer;
+        json_writer json(buffer);
+        parser.write_json(json);
+        return buffer;
+    }
+
+    // what a fresh parser makes of the same tokens
+    std::string fresh_json(const wstr_vec& tokens)
+    {
+        std::vector<const wchar_t*> argv = make_argv(tokens);
+        arg_parser parser;
+        parser.parse(static_cast<int>(argv.size()), argv.data());
+        return to_json(parser);
+    }
+
+    TEST_CLASS(ArgParserIncrementalTests)
+    {
+    public:
+        TEST_METHOD(TEST_REPLACE_VALUE)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"stat", L"-e", L"ld_spec", L"-n", L"3", L"--timeout", L"1", L"-t" });
+            Assert::AreEqual(size_t(8), parser.get_reparsed_token_count());
+
+            parser.apply(token_edit::replace(4, L"5"));
+            Assert::AreEqual(5, parser.iteration_arg.get<int>());
+            Assert::AreEqual(size_t(2), parser.get_reparsed_token_count());
+            Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+        }
+
+        TEST_METHOD(TEST_INSERT_AND_DELETE_FLAGS)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"stat", L"-e", L"ld_spec", L"--timeout", L"1", L"-t" });
+
+            parser.apply(token_edit::insert(3, { L"-n", L"4", L"--verbose" }));
+            Assert::AreEqual(size_t(3), parser.get_reparsed_token_count());
+            Assert::IsTrue(parser.verbose_opt.m_is_parsed);
+            Assert::AreEqual(4, parser.iteration_arg.get<int>());
+            Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+
+            parser.apply(token_edit::erase(3, 2));
+            Assert::IsFalse(parser.iteration_arg.m_is_parsed);
+            Assert::IsTrue(parser.timeout_arg.m_is_parsed);
+            Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+
+            parser.apply(token_edit::insert(parser.get_tokens().size(), { L"-k" }));
+            Assert::IsTrue(parser.kernel_opt.m_is_parsed);
+            Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+        }
+
+        TEST_METHOD(TEST_REPEATED_FLAG_KEEPS_ORDER)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"stat", L"-e", L"ld_spec", L"-n", L"3", L"-e", L"st_spec", L"-t" });
+
+            parser.apply(token_edit::replace(2, L"vfp_spec"));
+            Assert::AreEqual(size_t(2), parser.events_arg.get_value_count());
+            Assert::AreEqual(std::wstring(L"vfp_spec"), parser.events_arg.get_value(0));
+            Assert::AreEqual(std::wstring(L"st_spec"), parser.events_arg.get_value(1));
+            Assert::AreEqual(size_t(4), parser.get_reparsed_token_count());
+        }
+
+        TEST_METHOD(TEST_EDIT_SHIFTS_FLAG_BOUNDARIES)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"record", L"-n", L"3", L"--verbose", L"-k", L"-t" });
+
+            // "--symbol" takes a value, so the flag after it becomes that value
+            parser.apply(token_edit::replace(3, L"--symbol"));
+            Assert::IsFalse(parser.verbose_opt.m_is_parsed);
+            Assert::IsFalse(parser.kernel_opt.m_is_parsed);
+            Assert::AreEqual(std::wstring(L"-k"), parser.symbol_arg.get_value(0));
+            Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+        }
+
+        TEST_METHOD(TEST_FAILED_EDIT_IS_UNDONE)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"stat", L"-e", L"ld_spec", L"-n", L"3", L"-t" });
+            const std::string before = to_json(parser);
+
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.apply(token_edit::replace(4, L"x")); });
+            Assert::AreEqual(std::wstring(L"3"), parser.get_tokens()[4]);
+            Assert::AreEqual(before, to_json(parser));
+
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.apply(token_edit::replace(2, L"not_an_event")); });
+            Assert::AreEqual(before, to_json(parser));
+
+            Assert::ExpectException<std::out_of_range>([&]() { parser.apply(token_edit::erase(5, 2)); });
+            Assert::AreEqual(size_t(6), parser.get_tokens().size());
+        }
+
+        TEST_METHOD(TEST_COMMAND_EDIT_PARSES_EVERYTHING)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"stat", L"-e", L"ld_spec", L"-n", L"3", L"-t" });
+
+            parser.apply(token_edit::replace(0, L"record"));
+            Assert::IsTrue(COMMAND_CLASS::RECORD == parser.m_command);
+            Assert::AreEqual(size_t(6), parser.get_reparsed_token_count());
+            Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+        }
+
+        TEST_METHOD(TEST_PASSTHROUGH_FOLLOWS_EDITS)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"record", L"-e", L"ld_spec", L"--", L"app.exe", L"arg" });
+
+            parser.apply(token_edit::insert(3, { L"--timeout", L"2" }));
+            Assert::AreEqual(std::wstring(L"app.exe arg"), parser.extra_args_arg.get_command_line());
+
+            parser.apply(token_edit::insert(parser.get_tokens().size(), { L"two words" }));
+            Assert::AreEqual(std::wstring(L"app.exe arg \"two words\""), parser.extra_args_arg.get_command_line());
+            Assert::AreEqual(std::string("two words"), std::string(parser.extra_args_arg.get_argv()[2]));
+        }
+
+        TEST_METHOD(TEST_SYMBOL_PATTERNS_FOLLOW_EDITS)
+        {
+            incremental_parser parser;
+            parse_tokens(parser, { L"record", L"--symbol", L"main", L"-e", L"ld_spec" });
+            Assert::IsFalse(parser.get_symbol_matcher().match(L"other"));
+
+            parser.apply(token_edit::erase(1, 2));
+            Assert::IsTrue(parser.get_symbol_matcher().match(L"other"));
+        }
+
+        TEST_METHOD(TEST_RANDOM_EDITS_MATCH_FULL_PARSE)
+        {
+            const std::vector<wstr_vec> pool = {
+                { L"--verbose" }, { L"-k" }, { L"-n", L"3" }, { L"-n", L"7" }, { L"--timeout", L"2" },
+                { L"-e", L"ld_spec" }, { L"-e", L"vfp_spec,st_spec" }, { L"--dmc", L"1" }, { L"-c", L"0,1" },
+                { L"--symbol", L"main" }, { L"--disassemble" }, { L"--annotate" }
+            };
+            std::vector<wstr_vec> units = { pool[2], pool[5] };
+            const auto unit_position = [&units](size_t unit) {
+                size_t position = 2;
+                for (size_t i = 0; i < unit; ++i) position += units[i].size();
+                return position;
+            };
+
+            incremental_parser parser;
+            parse_tokens(parser, { L"record", L"-t", L"-n", L"3", L"-e", L"ld_spec" });
+
+            unsigned state = 12345;
+            const auto next = [&state](size_t bound) {
+                state = state * 1103515245u + 12345u;
+                return static_cast<size_t>((state >> 8) % bound);
+            };
+            for (int step = 0; step < 500; ++step)
+            {
+                const size_t operation = next(3);
+                if (operation == 0 || units.size() < 2)
+                {
+                    const size_t unit = next(units.size() + 1);
+                    const wstr_vec& tokens = pool[next(pool.size())];
+                    parser.apply(token_edit::insert(unit_position(unit), tokens));
+                    units.insert(units.begin() + unit, tokens);
+                }
+                else if (operation == 1)
+                {
+                    const size_t unit = next(units.size());
+                    parser.apply(token_edit::erase(unit_position(unit), units[unit].size()));
+                    units.erase(units.begin() + unit);
+                }
+                else
+                {
+                    const size_t unit = next(units.size());
+                    const wstr_vec& tokens = pool[next(pool.size())];
+                    parser.apply(token_edit{ unit_position(unit), units[unit].size(), tokens });
+                    units[unit] = tokens;
+                }
+                Assert::AreEqual(fresh_json(parser.get_tokens()), to_json(parser));
+            }
+        }
+
+        TEST_METHOD(BENCH_EDIT_LATENCY)
+        {
+            const wstr_vec filler[] = { { L"-e", L"ld_spec" }, { L"--verbose" }, { L"-c", L"0" }, { L"-e", L"st_spec,vfp_spec" } };
+            for (size_t length : { 16, 256, 4096 })
+            {
+                wstr_vec tokens = { L"stat", L"-t", L"-n", L"3" };
+                for (size_t i = 0; tokens.size() < length; ++i)
+                    tokens.insert(tokens.end(), filler[i % 4].begin(), filler[i % 4].end());
+
+                incremental_parser parser;
+                parse_tokens(parser, tokens);
+
+                const size_t iterations = 1000;
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < iterations; ++i)
+                    parser.apply(token_edit::replace(3, i % 2 ? L"3" : L"4"));
+                const double replace = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+                // inserting or erasing tokens also shifts the ones after them, a memmove over the line
+                start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < iterations; ++i)
+                {
+                    parser.apply(token_edit::insert(4, { L"--timeout", L"2" }));
+                    parser.apply(token_edit::erase(4, 2));
+                }
+                const double insert_erase = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / (2 * iterations);
+
+                const size_t full_iterations = 30;
+                std::vector<const wchar_t*> argv = make_argv(tokens);
+                start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < full_iterations; ++i)
+                {
+                    arg_parser full;
+                    full.parse(static_cast<int>(argv.size()), argv.data());
+                }
+                const double full = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / full_iterations;
+
+                std::string message = std::to_string(length) + " tokens: "
+                    + std::to_string(replace) + " us per replace, " + std::to_string(insert_erase) + " us per insert or erase, "
+                    + std::to_string(full) + " us per full parse";
+                Logger::WriteMessage(message.c_str());
+                Assert::AreEqual(tokens.size(), parser.get_tokens().size());
+            }
+        }
+    };
+}
@@ -0,0 +1,222 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <cwchar>
+#include <string>
+#include <vector>
+#include "alloc-counter.h"
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-json.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using namespace alloc_counter;
+
+namespace arg_parser_json_tests
+{
+    TEST_CLASS(ArgParserJsonTests)
+    {
+    public:
+        TEST_METHOD(TEST_WRITER_SEPARATORS_AND_TYPES)
+        {
+            std::string buffer;
+            json_writer json(buffer);
+            json.begin_object()
+                .key("a").value(1)
+                .key("b").begin_array().value(true).value(false).null().value(-5).end_array()
+                .key("c").begin_object().end_object()
+                .key("d").value(18446744073709551615ULL)
+                .end_object();
+            Assert::AreEqual(std::string("{\"a\":1,\"b\":[true,false,null,-5],\"c\":{},\"d\":18446744073709551615}"), buffer);
+            Assert::AreEqual(0u, json.get_depth());
+        }
+
+        TEST_METHOD(TEST_WRITER_ESCAPING)
+        {
+            std::string buffer;
+            json_writer json(buffer);
+            json.begin_array()
+                .value(L"C:\\caf\u00e9\\\"x\"\n\t\x01")
+                .value("tab\there")
+                .end_array();
+            Assert::AreEqual(std::string("[\"C:\\\\caf\xC3\xA9\\\\\\\"x\\\"\\n\\t\\u0001\",\"tab\\there\"]"), buffer);
+        }
+
+        TEST_METHOD(TEST_WRITER_DEPTH_AND_BALANCE)
+        {
+            std::string buffer;
+            json_writer json(buffer);
+            Assert::ExpectException<std::logic_error>([&json]() { json.end_array(); });
+            for (unsigned i = 0; i < json_writer::MAX_DEPTH; ++i) json.begin_array();
+            Assert::ExpectException<std::length_error>([&json]() { json.begin_array(); });
+        }
+
+        TEST_METHOD(TEST_PARSE_RESULT_JSON)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"-t", L"-n", L"12", L"--json", L"--", L"app.exe" };
+            parser.parse(10, argv);
+
+            std::string buffer;
+            json_writer json(buffer);
+            parser.write_json(json);
+            Assert::IsTrue(buffer.find("\"command\":\"stat\"") != std::string::npos);
+            Assert::IsTrue(buffer.find("\"-e\":[\"ld_spec\"]") != std::string::npos);
+            Assert::IsTrue(buffer.find("\"-n\":[12]") != std::string::npos);
+            Assert::IsTrue(buffer.find("\"--json\":true") != std::string::npos);
+            Assert::IsTrue(buffer.find("\"--\":[\"app.exe\"]") != std::string::npos);
+        }
+
+        TEST_METHOD(TEST_EMPTY_PASSTHROUGH_JSON)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"--" };
+            parser.parse(5, argv);
+
+            std::string buffer;
+            json_writer json(buffer);
+            parser.write_json(json);
+            Assert::IsTrue(buffer.find("\"--\":[]") != std::string::npos);
+        }
+
+        TEST_METHOD(TEST_HELP_JSON)
+        {
+            arg_parser parser;
+            std::string buffer;
+            json_writer json(buffer);
+            parser.write_help_json(json);
+            Assert::IsTrue(buffer.find("{\"commands\":[{") == 0);
+            Assert::IsTrue(buffer.find("{\"name\":\"list\",\"aliases\":[\"-l\"]") != std::string::npos);
+            Assert::IsTrue(buffer.find("{\"name\":\"--timeout\",\"aliases\":[\"sleep\"]") != std::string::npos);
+            Assert::IsTrue(buffer.back() == '}');
+        }
+
+        TEST_METHOD(TEST_ERROR_JSON)
+        {
+            arg_parser parser;
+            std::string buffer;
+            json_writer json(buffer);
+            parser.write_error_json(json, L"--bogus", L"Error: Unrecognized command");
+            Assert::IsTrue(buffer.find("{\"error\":{\"command_line\":\"wperf\"") == 0);
+            Assert::IsTrue(buffer.find("\"message\":\"Error: Unrecognized command\"") != std::string::npos);
+        }
+
+        // The position points at the argument inside the reported command line
+        TEST_METHOD(TEST_ERROR_JSON_POSITION)
+        {
+            // the values in these errors need no unescaping
+            const auto field = [](const std::string& json, const std::string& key) {
+                size_t begin = json.find("\"" + key + "\":") + key.size() + 3;
+                if (json[begin] != '"') return json.substr(begin, json.find_first_of(",}", begin) - begin);
+                ++begin;
+                return json.substr(begin, json.find('"', begin) - begin);
+            };
+            const std::vector<std::vector<const wchar_t*>> lines = {
+                { L"wperf", L"--annotate", L"--json" },
+                { L"wperf", L"stat", L"-e", L"ld_spec", L"-c", L"x", L"--json" },
+                { L"wperf", L"stat", L"-e", L"ld_spec,no_such_event", L"--json" },
+                { L"wperf", L"stat", L"--bogus", L"--json" }
+            };
+            for (auto argv : lines)
+            {
+                buffer_sink errors;
+                arg_parser parser;
+                parser.set_error_sink(errors);
+                Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(static_cast<int>(argv.size()), argv.data()); });
+                const std::string& json = errors.get_buffer();
+                const std::string command_line = field(json, "command_line");
+                const std::string argument = field(json, "argument");
+                const size_t position = std::stoul(field(json, "position"));
+                std::string expected = "wperf";
+                for (size_t i = 1; i < argv.size(); ++i)
+                    expected += " " + std::string(argv[i], argv[i] + std::wcslen(argv[i]));
+                Assert::AreEqual(expected, command_line);
+                Assert::IsTrue(position < command_line.size());
+                Assert::AreEqual(argument, command_line.substr(position, argument.size()));
+            }
+        }
+
+        TEST_METHOD(TEST_REUSED_BUFFER_DOES_NOT_ALLOCATE)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"record", L"-e", L"inst_spec,vfp_spec", L"-c", L"1", L"--pe_file", L"C:\\Windows\\notepad.exe", L"--", L"notepad.exe" };
+            parser.parse(10, argv);
+
+            std::string buffer;
+            {
+                json_writer json(buffer);
+                parser.write_json(json);
+            }
+            const std::string first = buffer;
+
+            scoped_alloc_counter counter;
+            buffer.clear();
+            json_writer json(buffer);
+            parser.write_json(json);
+            Assert::AreEqual(size_t(0), counter.allocations());
+            Assert::IsTrue(first == buffer);
+        }
+    };
+
+    TEST_CLASS(ArgParserJsonBenchmark)
+    {
+    public:
+        TEST_METHOD(BENCH_PARSE_RESULT_RECORDS)
+        {
+            arg_parser parser;
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"inst_spec,vfp_spec,ase_spec,dp_spec,ld_spec,st_spec", L"-c", L"0,1,2,3",
+                L"-t", L"-n", L"10", L"--json", L"--pe_file", L"C:\\Program Files\\app\\app.exe", L"--", L"app.exe", L"--input", L"data.bin" };
+            parser.parse(16, argv);
+
+            std::string buffer;
+            const size_t records = 100000;
+            size_t bytes = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < records; ++i)
+            {
+                buffer.clear();
+                json_writer json(buffer);
+                parser.write_json(json);
+                bytes += buffer.size();
+            }
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::string message = "json_writer: " + std::to_string(static_cast<long long>(records / elapsed)) + " records/s, "
+                + std::to_string(static_cast<long long>(elapsed * 1e9 / records)) + " ns/record";
+            Logger::WriteMessage(message.c_str());
+            Assert::AreEqual(records * buffer.size(), bytes);
+        }
+    };
+}
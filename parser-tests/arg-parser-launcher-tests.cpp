@@ -0,0 +1,190 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-launcher.h"
+#include "parser/arg-parser-output.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <sched.h>
+#include <sys/wait.h>
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using namespace std::chrono_literals;
+
+namespace arg_parser_launcher_tests
+{
+    // Parses `wperf record ... -- <shell> <exit with code>` and keeps the parser the options point into
+    struct exit_command {
+        explicit exit_command(int code, std::vector<const wchar_t*> flags = {})
+        {
+            m_code = std::to_wstring(code);
+            std::vector<const wchar_t*> argv = { L"wperf", L"record" };
+            argv.insert(argv.end(), flags.begin(), flags.end());
+    #ifdef _WIN32
+            argv.insert(argv.end(), { L"--", L"cmd.exe", L"/c", L"exit", m_code.c_str() });
+    #else
+            m_script = L"exit " + m_code;
+            argv.insert(argv.end(), { L"--", L"/bin/sh", L"-c", m_script.c_str() });
+    #endif
+            m_parser.parse(static_cast<int>(argv.size()), argv.data());
+        }
+
+        std::wstring m_code;
+        std::wstring m_script;
+        arg_parser m_parser;
+    };
+
+    TEST_CLASS(ArgParserLauncherTests)
+    {
+    public:
+        TEST_METHOD(TEST_LAUNCH_OPTIONS_FROM_FLAGS)
+        {
+            exit_command command(5, { L"-c", L"0", L"--record_spawn_delay", L"25" });
+            const launch_options options = command.m_parser.get_launch_options();
+            Assert::IsTrue(options.m_cores == std::vector<unsigned>({ 0 }));
+            Assert::IsTrue(options.m_spawn_delay == 25ms);
+            Assert::IsTrue(options.m_argv == command.m_parser.extra_args_arg.get_argv());
+            Assert::AreEqual(command.m_parser.extra_args_arg.get_command_line(), options.m_command_line);
+
+            launched_process process = launch_process(options);
+            Assert::AreEqual(5, process.wait());
+        }
+
+        TEST_METHOD(TEST_LAUNCH_WITHOUT_COMMAND)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"-e", L"ld_spec" };
+            buffer_sink errors;
+            arg_parser parser;
+            parser.set_error_sink(errors);
+            parser.parse(4, argv);
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.get_launch_options(); });
+            Assert::AreNotEqual(std::string::npos, errors.get_buffer().find("no command to launch"));
+        }
+
+        TEST_METHOD(TEST_LAUNCH_MISSING_PROGRAM)
+        {
+            launch_options options;
+            char program[] = "wperf-no-such-program";
+            char* argv[] = { program, nullptr };
+            options.m_argv = argv;
+            options.m_command_line = L"wperf-no-such-program";
+            Assert::ExpectException<std::runtime_error>([&]() { launch_process(options); });
+        }
+
+        TEST_METHOD(TEST_SPAWN_DELAY_FROM_EXEC)
+        {
+            exit_command command(0, { L"--record_spawn_delay", L"30" });
+            launched_process process = launch_process(command.m_parser.get_launch_options());
+            Assert::IsTrue(process.get_spawn_to_exec() > 0ns);
+            Assert::IsTrue(process.get_spawn_delay() >= 30ms);
+            Assert::IsTrue(process.get_spawn_delay() < 30ms + timeline_scheduler::MAX_SLEEP);
+            Assert::AreEqual(0, process.wait());
+            Assert::ExpectException<std::runtime_error>([&]() { process.wait(); });
+        }
+
+        TEST_METHOD(TEST_SPAWN_DELAY_CANCELLED)
+        {
+            exit_command command(0, { L"--record_spawn_delay", L"10000" });
+            cancellation_token token;
+            token.cancel();
+            launched_process process = launch_process(command.m_parser.get_launch_options(), &token);
+            Assert::IsTrue(process.get_spawn_delay() < 1s);
+            Assert::AreEqual(0, process.wait());
+        }
+
+    #ifdef __linux__
+        TEST_METHOD(TEST_CHILD_PINNED_FROM_FIRST_INSTRUCTION)
+        {
+            cpu_set_t before;
+            CPU_ZERO(&before);
+            sched_getaffinity(0, sizeof(before), &before);
+
+            // the shell reads its own affinity, which it had before it ran anything
+            const wchar_t* argv[] = { L"wperf", L"record", L"-c", L"0", L"--", L"/bin/sh", L"-c", L"grep -q '^Cpus_allowed_list:[[:space:]]*0$' /proc/self/status" };
+            arg_parser parser;
+            parser.parse(8, argv);
+            launched_process process = launch_process(parser.get_launch_options());
+            Assert::AreEqual(0, process.wait());
+
+            // the launching thread is back to where it was
+            cpu_set_t after;
+            CPU_ZERO(&after);
+            sched_getaffinity(0, sizeof(after), &after);
+            Assert::IsTrue(CPU_EQUAL(&before, &after));
+        }
+
+        TEST_METHOD(TEST_EXITED_CHILD_REAPED_WITHOUT_WAIT)
+        {
+            exit_command command(0);
+            pid_t pid = 0;
+            {
+                launched_process process = launch_process(command.m_parser.get_launch_options());
+                pid = static_cast<pid_t>(process.get_pid());
+                // wait for the exit without reaping, so the destructor finds a zombie
+                siginfo_t info{};
+                Assert::AreEqual(0, waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT));
+            }
+            int status = 0;
+            Assert::AreEqual(-1, static_cast<int>(waitpid(pid, &status, WNOHANG)));
+            Assert::AreEqual(ECHILD, errno);
+        }
+    #endif
+
+        TEST_METHOD(BENCH_SPAWN_TO_EXEC)
+        {
+            constexpr size_t LAUNCHES = 200;
+            exit_command command(0, { L"-c", L"0" });
+            const launch_options options = command.m_parser.get_launch_options();
+            std::vector<double> latencies;
+            for (size_t i = 0; i < LAUNCHES; ++i)
+            {
+                launched_process process = launch_process(options);
+                latencies.push_back(std::chrono::duration<double, std::micro>(process.get_spawn_to_exec()).count());
+                process.wait();
+            }
+            std::sort(latencies.begin(), latencies.end());
+            std::string message = "spawn to exec, pinned: p50 " + std::to_string(latencies[LAUNCHES / 2]) + " us, p99 "
+                + std::to_string(latencies[LAUNCHES * 99 / 100]) + " us";
+            Logger::WriteMessage(message.c_str());
+        }
+    };
+}
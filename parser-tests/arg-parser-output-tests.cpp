@@ -0,0 +1,174 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include "alloc-counter.h"
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-output.h"
+#include "parser/arg-parser-utf8.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using alloc_counter::scoped_alloc_counter;
+
+namespace arg_parser_output_tests
+{
+    // Counts the chunks a writer hands over
+    class counting_sink : public output_sink {
+    public:
+        void write(const char*, size_t size) override
+        {
+            ++m_writes;
+            m_bytes += size;
+        }
+        void flush() override { ++m_flushes; }
+
+        size_t m_writes = 0;
+        size_t m_bytes = 0;
+        size_t m_flushes = 0;
+    };
+
+    TEST_CLASS(ArgParserOutputTests)
+    {
+    public:
+        TEST_METHOD(TEST_WRITER_BATCHES_WRITES)
+        {
+            counting_sink sink;
+            {
+                utf8_writer writer(sink);
+                for (int i = 0; i < 1000; ++i)
+                    writer << L"line " << std::string_view("of text\n");
+                Assert::AreEqual(size_t(0), sink.m_writes);
+            }
+            Assert::AreEqual(size_t(1), sink.m_writes);
+            Assert::AreEqual(size_t(13000), sink.m_bytes);
+            Assert::AreEqual(size_t(1), sink.m_flushes);
+        }
+
+        TEST_METHOD(TEST_WRITER_FLUSHES_LARGE_CHUNKS)
+        {
+            counting_sink sink;
+            {
+                utf8_writer writer(sink);
+                const std::string chunk(1000, 'x');
+                for (int i = 0; i < 200; ++i)
+                    writer << chunk;
+            }
+            // 200 KB go out in chunks of at least 64 KB
+            Assert::IsTrue(sink.m_writes <= 4);
+            Assert::AreEqual(size_t(200000), sink.m_bytes);
+        }
+
+        TEST_METHOD(TEST_BUFFER_SINK)
+        {
+            buffer_sink sink;
+            {
+                utf8_writer writer(sink);
+                writer << L"caf\u00e9";
+            }
+            Assert::IsTrue(sink.get_buffer() == "caf\xC3\xA9");
+            sink.clear();
+            Assert::IsTrue(sink.get_buffer().empty());
+        }
+
+        TEST_METHOD(TEST_NULL_SINK_DOES_NOTHING)
+        {
+            const std::wstring text(10000, L'\u00e9');
+            scoped_alloc_counter counter;
+            {
+                utf8_writer writer(get_null_sink());
+                for (int i = 0; i < 100; ++i)
+                    writer << text;
+            }
+            Assert::AreEqual(size_t(0), counter.allocations());
+        }
+
+        TEST_METHOD(TEST_FILE_SINK)
+        {
+            const std::filesystem::path path = std::filesystem::temp_directory_path() / "wperf-output-sink-test.txt";
+            {
+                file_sink sink(path);
+                utf8_writer writer(sink);
+                writer << L"first\n" << L"second\n";
+            }
+            Assert::AreEqual(std::uintmax_t(13), std::filesystem::file_size(path));
+            std::filesystem::remove(path);
+
+            Assert::ExpectException<std::runtime_error>([]() { file_sink sink(std::filesystem::path("no-such-directory") / "x" / "out.txt"); });
+        }
+
+        TEST_METHOD(TEST_PARSER_HELP_TO_SINK)
+        {
+            buffer_sink output;
+            arg_parser parser;
+            parser.set_output_sink(output);
+            parser.print_help();
+            Assert::IsTrue(output.get_buffer().find("NAME:") == 0);
+            Assert::IsTrue(output.get_buffer().find("--timeout") != std::string::npos);
+        }
+
+        TEST_METHOD(TEST_PARSER_ERRORS_TO_SINK)
+        {
+            buffer_sink errors;
+            arg_parser parser;
+            parser.set_error_sink(errors);
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-n", L"x" };
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(4, argv); });
+            Assert::IsTrue(errors.get_buffer().find("Invalid argument detected:") == 0);
+            Assert::IsTrue(&errors == &parser.get_error_sink());
+        }
+
+        TEST_METHOD(TEST_PARSER_JSON_ERRORS_TO_SINK)
+        {
+            buffer_sink errors;
+            arg_parser parser;
+            parser.set_error_sink(errors);
+            const wchar_t* argv[] = { L"wperf", L"stat", L"--json", L"--bogus" };
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(4, argv); });
+            Assert::IsTrue(errors.get_buffer().find("{\"error\":") == 0);
+        }
+
+        TEST_METHOD(TEST_QUIET_PARSER)
+        {
+            arg_parser parser;
+            parser.set_output_sink(get_null_sink());
+            parser.set_error_sink(get_null_sink());
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-q", L"--bogus" };
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(4, argv); });
+            parser.print_help();
+        }
+    };
+}
@@ -0,0 +1,141 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "mock-arg-parser.h"
+#include "parser/arg-parser-path-validator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_path_validator_tests
+{
+    TEST_CLASS(ArgParserPathValidatorTests)
+    {
+    public:
+        TEST_METHOD(TEST_EXISTING_PATHS_PASS)
+        {
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--pe_file", L"C:\\Program\\sample.exe", L"--pdb_file", L"C:\\Program\\sample.pdb" };
+            int argc = 6;
+            mock_arg_parser parser;
+            parser.parse(argc, argv);
+            parser.validate_paths([&parser](const std::wstring& path) { return parser.file_exists(path); }, nullptr);
+        }
+
+        TEST_METHOD(TEST_MISSING_PATHS_FAIL)
+        {
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--pe_file", L"C:\\Program\\missing.exe", L"--pdb_file", L"C:\\Program\\sample.pdb" };
+            int argc = 6;
+            mock_arg_parser parser;
+            parser.parse(argc, argv);
+            Assert::ExpectException<std::invalid_argument>([&parser]() {
+                parser.validate_paths([&parser](const std::wstring& path) { return parser.file_exists(path); }, nullptr);
+                }
+            );
+        }
+
+        TEST_METHOD(TEST_UNQUALIFIED_COMMAND_IS_NOT_PROBED)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"--", L"notepad.exe", L"C:\\not\\a\\path\\argument" };
+            int argc = 5;
+            mock_arg_parser parser;
+            parser.parse(argc, argv);
+            size_t probes = 0;
+            parser.validate_paths([&probes](const std::wstring&) { ++probes; return false; }, nullptr);
+            Assert::AreEqual(size_t(0), probes);
+        }
+
+        TEST_METHOD(TEST_ALL_MISSING_PATHS_ARE_REPORTED)
+        {
+            std::vector<std::wstring> paths = { L"C:\\a.exe", L"C:\\Program\\sample.exe", L"C:\\b.pdb", L"C:\\c.cfg" };
+            mock_arg_parser parser;
+            std::vector<std::wstring> missing = probe_paths(paths, [&parser](const std::wstring& path) { return parser.file_exists(path); }, nullptr);
+            Assert::AreEqual(size_t(3), missing.size());
+            Assert::AreEqual(std::wstring(L"C:\\a.exe"), missing[0]);
+            Assert::AreEqual(std::wstring(L"C:\\b.pdb"), missing[1]);
+            Assert::AreEqual(std::wstring(L"C:\\c.cfg"), missing[2]);
+        }
+
+        TEST_METHOD(TEST_PROBES_RUN_CONCURRENTLY)
+        {
+            std::vector<std::wstring> paths;
+            for (int i = 0; i < 8; ++i) paths.push_back(L"\\\\share\\file" + std::to_wstring(i));
+
+            auto slow_probe = [](const std::wstring&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                return true;
+            };
+            auto start = std::chrono::steady_clock::now();
+            Assert::IsTrue(probe_paths(paths, slow_probe, nullptr, 4).empty());
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            // 8 probes of 50ms on 4 workers take ~100ms, serially they would take 400ms
+            Assert::IsTrue(elapsed < std::chrono::milliseconds(350));
+        }
+
+        TEST_METHOD(TEST_FAILING_PROBE_REPORTS_MISSING)
+        {
+            std::vector<std::wstring> paths;
+            for (int i = 0; i < 8; ++i) paths.push_back(L"\\\\share\\file" + std::to_wstring(i));
+
+            auto failing_probe = [](const std::wstring& path) -> bool {
+                if (path.back() == L'3')
+                    throw std::runtime_error("share unreachable");
+                return true;
+            };
+            std::vector<std::wstring> missing = probe_paths(paths, failing_probe, nullptr, 4);
+            Assert::AreEqual(size_t(1), missing.size());
+            Assert::AreEqual(std::wstring(L"\\\\share\\file3"), missing[0]);
+        }
+
+        TEST_METHOD(TEST_CACHE_MEMOIZES_UNTIL_TTL)
+        {
+            path_probe_cache cache(std::chrono::hours(1));
+            std::atomic<size_t> probes(0);
+            auto counting_probe = [&probes](const std::wstring&) { ++probes; return true; };
+            std::vector<std::wstring> paths = { L"C:\\Program\\sample.exe" };
+
+            probe_paths(paths, counting_probe, &cache);
+            probe_paths(paths, counting_probe, &cache);
+            Assert::AreEqual(size_t(1), probes.load());
+
+            cache.set_ttl(std::chrono::milliseconds(0));
+            cache.clear();
+            probe_paths(paths, counting_probe, &cache);
+            probe_paths(paths, counting_probe, &cache);
+            Assert::AreEqual(size_t(3), probes.load());
+        }
+    };
+}
@@ -0,0 +1,230 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-json.h"
+#include "parser/arg-parser-output.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_registry_tests
+{
+    namespace validators = ArgParserArg::validators;
+
+    void parse_tokens(arg_parser& parser, const wstr_vec& tokens)
+    {
+        std::vector<const wchar_t*> argv = { L"wperf" };
+        for (auto& token : tokens) argv.push_back(token.c_str());
+        parser.parse(static_cast<int>(argv.size()), argv.data());
+    }
+
+    // A registry with count flags named --plugin-0, --plugin-1, ... each taking one value
+    plugin_registry make_plugin_flags(size_t count)
+    {
+        plugin_registry registry;
+        for (size_t i = 0; i < count; ++i)
+            registry.add_flag(arg_builder<arg_parser_arg_pos>(L"--plugin-" + std::to_wstring(i)).build());
+        return registry;
+    }
+
+    TEST_CLASS(ArgParserRegistryTests)
+    {
+    public:
+        TEST_METHOD(TEST_PLUGIN_COMMAND_AND_FLAG)
+        {
+            plugin_registry registry;
+            const arg_parser_arg_command& trace = registry.add_command(command_builder(L"trace", COMMAND_CLASS::PLUGIN)
+                .alias(L"tr").description(L"Trace the events of a site-specific driver.").usage(L"wperf trace [--depth]").build());
+            const arg_parser_arg_pos& depth = registry.add_flag(arg_builder<arg_parser_arg_pos>(L"--depth")
+                .description(L"Stack depth.").validator<validators::is_uint>().build());
+
+            arg_parser parser;
+            parser.register_plugins(std::move(registry));
+            parse_tokens(parser, { L"tr", L"--depth", L"8", L"-c", L"1" });
+
+            Assert::IsTrue(COMMAND_CLASS::PLUGIN == parser.m_command);
+            Assert::IsTrue(&trace == parser.get_command_arg());
+            // the sniffer only knows the built-in commands
+            const wchar_t* sniffed[] = { L"wperf", L"trace" };
+            Assert::IsTrue(COMMAND_CLASS::NO_COMMAND == arg_parser::sniff_command(2, sniffed));
+            Assert::IsTrue(depth.m_is_parsed);
+            Assert::AreEqual(8, depth.get<int>());
+            Assert::IsTrue(parser.cores_arg.m_is_parsed);
+        }
+
+        TEST_METHOD(TEST_PLUGIN_COMMAND_NAMES_IN_JSON)
+        {
+            for (const wchar_t* name : { L"trace", L"probe" })
+            {
+                plugin_registry registry;
+                registry.add_command(command_builder(L"trace", COMMAND_CLASS::PLUGIN).build());
+                registry.add_command(command_builder(L"probe", COMMAND_CLASS::PLUGIN).build());
+                arg_parser parser;
+                parser.register_plugins(std::move(registry));
+                parse_tokens(parser, { name });
+                std::string buffer;
+                json_writer json(buffer);
+                parser.write_json(json);
+                const std::wstring wide = name;
+                Assert::AreNotEqual(std::string::npos, buffer.find("\"command\":\"" + std::string(wide.begin(), wide.end()) + "\""));
+            }
+        }
+
+        TEST_METHOD(TEST_BUILT_IN_COMMANDS_STILL_PARSE)
+        {
+            arg_parser parser;
+            parser.register_plugins(make_plugin_flags(10));
+            parse_tokens(parser, { L"stat", L"--plugin-3", L"x", L"-e", L"ld_spec", L"--json" });
+
+            Assert::IsTrue(COMMAND_CLASS::STAT == parser.m_command);
+            Assert::IsTrue(&parser.count_command == parser.get_command_arg());
+            Assert::IsTrue(parser.json_opt.m_is_parsed);
+            Assert::AreEqual(std::wstring(L"ld_spec"), parser.events_arg.get_values().front());
+        }
+
+        TEST_METHOD(TEST_CONFLICT_IN_REGISTRY)
+        {
+            plugin_registry registry;
+            registry.add_flag(arg_builder<arg_parser_arg_opt>(L"--trace-all").alias(L"-T").build());
+
+            Assert::ExpectException<std::invalid_argument>([&registry]() {
+                registry.add_flag(arg_builder<arg_parser_arg_opt>(L"-T").build());
+            });
+            Assert::ExpectException<std::invalid_argument>([&registry]() {
+                registry.add_command(command_builder(L"trace", COMMAND_CLASS::PLUGIN).alias(L"--trace-all").build());
+            });
+            // a rejected arg reserves none of its names
+            registry.add_command(command_builder(L"trace", COMMAND_CLASS::PLUGIN).build());
+        }
+
+        TEST_METHOD(TEST_CONFLICT_WITH_BUILT_IN_REGISTERS_NOTHING)
+        {
+            buffer_sink errors;
+            arg_parser parser;
+            parser.set_error_sink(errors);
+
+            for (const wchar_t* taken : { L"--json", L"-q", L"stat", L"-l", L"--parser-stats" })
+            {
+                plugin_registry registry;
+                registry.add_flag(arg_builder<arg_parser_arg_opt>(L"--fresh").build());
+                registry.add_flag(arg_builder<arg_parser_arg_opt>(taken).build());
+                Assert::ExpectException<std::invalid_argument>([&parser, &registry]() {
+                    parser.register_plugins(std::move(registry));
+                });
+            }
+
+            Assert::ExpectException<std::invalid_argument>([&parser]() {
+                parse_tokens(parser, { L"stat", L"--fresh" });
+            });
+        }
+
+        TEST_METHOD(TEST_PLUGINS_IN_HELP)
+        {
+            plugin_registry registry;
+            registry.add_command(command_builder(L"trace", COMMAND_CLASS::PLUGIN).usage(L"wperf trace [--depth]").build());
+            registry.add_flag(arg_builder<arg_parser_arg_pos>(L"--depth").description(L"Stack depth.").build());
+
+            buffer_sink output;
+            arg_parser parser;
+            parser.set_output_sink(output);
+            parser.register_plugins(std::move(registry));
+            parser.print_help();
+
+            Assert::AreNotEqual(std::string::npos, output.get_buffer().find("wperf trace [--depth]"));
+            Assert::AreNotEqual(std::string::npos, output.get_buffer().find("Stack depth."));
+        }
+
+        TEST_METHOD(TEST_RESET_CLEARS_PLUGIN_FLAGS)
+        {
+            plugin_registry registry;
+            const arg_parser_arg_pos& depth = registry.add_flag(arg_builder<arg_parser_arg_pos>(L"--depth").default_value(L"4").build());
+            arg_parser parser;
+            parser.register_plugins(std::move(registry));
+            parse_tokens(parser, { L"stat", L"--depth", L"8" });
+            Assert::AreEqual(std::wstring(L"8"), depth.get_values().front());
+
+            parser.reset();
+            Assert::IsFalse(depth.m_is_parsed);
+            Assert::IsTrue(nullptr == parser.get_command_arg());
+            Assert::AreEqual(std::wstring(L"4"), depth.get_values().front());
+        }
+
+        TEST_METHOD(TEST_PROBES_DO_NOT_GROW_WITH_PLUGINS)
+        {
+            // every token is one index lookup, however many flags are registered
+            arg_parser parser;
+            parser.register_plugins(make_plugin_flags(1000));
+            parse_tokens(parser, { L"stat", L"-k", L"--plugin-999", L"x", L"--timeout", L"2" });
+
+            const parse_stats& stats = parser.get_stats();
+            if (parse_stats_enabled())
+                Assert::AreEqual(std::uint64_t(4), stats.m_flag_probes);
+        }
+
+        TEST_METHOD(BENCH_PARSE_WITH_PLUGINS)
+        {
+            wstr_vec tokens = { L"stat" };
+            for (size_t i = 0; tokens.size() < 1000; ++i)
+            {
+                tokens.push_back(i % 2 ? L"-k" : L"--plugin-" + std::to_wstring(i % 100));
+                if (i % 2 == 0) tokens.push_back(L"x");
+            }
+
+            for (size_t plugins : { 100, 1000, 10000 })
+            {
+                arg_parser parser;
+                parser.register_plugins(make_plugin_flags(plugins));
+
+                // reset visits every flag, so it stays out of the per-token time
+                const size_t iterations = 100;
+                double elapsed = 0;
+                for (size_t i = 0; i < iterations; ++i)
+                {
+                    parser.reset();
+                    const auto start = std::chrono::steady_clock::now();
+                    parse_tokens(parser, tokens);
+                    elapsed += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                }
+
+                char message[128];
+                snprintf(message, sizeof(message), "%zu plugin flags: %f ns/token\n", plugins, elapsed / (iterations * tokens.size()));
+                Logger::WriteMessage(message);
+            }
+        }
+    };
+}
@@ -0,0 +1,140 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <cstring>
+#include "parser/arg-parser-result.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_result_tests
+{
+    TEST_CLASS(ArgParserResultTests)
+    {
+    public:
+        TEST_METHOD(TEST_EXPORT_ROUND_TRIP)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"-e", L"vfp_spec", L"-c", L"0", L"--json" };
+            int argc = 9;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            std::vector<std::uint8_t> blob = export_parse_result(parser);
+            parse_result_view view(blob.data(), blob.size());
+
+            Assert::IsTrue(COMMAND_CLASS::STAT == view.get_command());
+            Assert::AreEqual(parser.m_flags_list.size(), view.get_flag_count());
+
+            size_t events = view.find_flag(L"-e");
+            Assert::IsTrue(view.is_flag_parsed(events));
+            Assert::AreEqual(size_t(2), view.get_value_count(events));
+            Assert::IsTrue(view.get_value(events, 0) == L"ld_spec");
+            Assert::IsTrue(view.get_value(events, 1) == L"vfp_spec");
+
+            Assert::IsTrue(view.is_flag_parsed(view.find_flag(L"--json")));
+            Assert::IsFalse(view.is_flag_parsed(view.find_flag(L"--annotate")));
+            Assert::AreEqual(view.get_flag_count(), view.find_flag(L"--unknown"));
+        }
+
+        TEST_METHOD(TEST_EXPORT_KEEPS_DEFAULT_VALUES)
+        {
+            const wchar_t* argv[] = { L"wperf", L"sample" };
+            int argc = 2;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            std::vector<std::uint8_t> blob = export_parse_result(parser);
+            parse_result_view view(blob.data(), blob.size());
+
+            size_t rows = view.find_flag(L"--sample-display-row");
+            Assert::IsFalse(view.is_flag_parsed(rows));
+            Assert::IsTrue(view.get_value(rows, 0) == L"50");
+        }
+
+        TEST_METHOD(TEST_EXPORT_IS_COPYABLE_BYTES)
+        {
+            const wchar_t* argv[] = { L"wperf", L"record", L"--", L"notepad.exe", L"test_arg" };
+            int argc = 5;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            std::vector<std::uint8_t> blob = export_parse_result(parser);
+            std::vector<std::uint64_t> shared((blob.size() + 7) / 8);
+            std::memcpy(shared.data(), blob.data(), blob.size());
+            blob.clear();
+
+            parse_result_view view(shared.data(), shared.size() * sizeof(std::uint64_t));
+            size_t extra = view.find_flag(L"--");
+            Assert::IsTrue(COMMAND_CLASS::RECORD == view.get_command());
+            Assert::AreEqual(size_t(2), view.get_value_count(extra));
+            Assert::IsTrue(view.get_value(extra, 0) == L"notepad.exe");
+            Assert::IsTrue(view.get_value(extra, 1) == L"test_arg");
+        }
+
+        TEST_METHOD(TEST_WRITE_REPORTS_REQUIRED_SIZE)
+        {
+            const wchar_t* argv[] = { L"wperf", L"test" };
+            int argc = 2;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            std::uint64_t small[2] = {};
+            size_t required = write_parse_result(parser, small, sizeof(small));
+            Assert::IsTrue(required > sizeof(small));
+            Assert::AreEqual(std::uint64_t(0), small[0]);
+        }
+
+        TEST_METHOD(TEST_VIEW_REJECTS_CORRUPTED_BLOB)
+        {
+            const wchar_t* argv[] = { L"wperf", L"test" };
+            int argc = 2;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            std::vector<std::uint8_t> blob = export_parse_result(parser);
+            Assert::ExpectException<std::invalid_argument>([&blob]() {
+                parse_result_view view(blob.data(), sizeof(parse_result_header) - 1);
+                }
+            );
+
+            parse_result_header header;
+            std::memcpy(&header, blob.data(), sizeof(header));
+            header.m_pool_length += 1000;
+            std::memcpy(blob.data(), &header, sizeof(header));
+            Assert::ExpectException<std::invalid_argument>([&blob]() {
+                parse_result_view view(blob.data(), blob.size());
+                }
+            );
+        }
+    };
+}
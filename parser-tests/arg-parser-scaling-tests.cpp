@@ -0,0 +1,180 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "alloc-counter.h"
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using alloc_counter::scoped_alloc_counter;
+
+namespace arg_parser_scaling_tests
+{
+#if defined(_DEBUG)
+    // checked iterators make the largest command lines take minutes
+    constexpr size_t MAX_TOKENS = 100'000;
+#else
+    constexpr size_t MAX_TOKENS = 1'000'000;
+#endif
+
+    // Time per token may grow by this much between 10k tokens and the largest size, which leaves
+    // room for cache effects while a quadratic step (100x per decade) fails at once. Memory is
+    // deterministic and only gets slack for the geometric growth of vectors.
+    constexpr double MAX_TIME_GROWTH = 4.0;
+    constexpr double MAX_MEMORY_GROWTH = 2.0;
+
+    struct scaling_sample {
+        size_t m_tokens;
+        double m_ns_per_token;
+        double m_bytes_per_token;
+    };
+
+    // Command line of about `tokens` tokens, argv[0] included
+    typedef std::function<wstr_vec(size_t tokens)> command_line_generator;
+
+    scaling_sample measure(const command_line_generator& generate, size_t tokens)
+    {
+        const wstr_vec args = generate(tokens);
+        std::vector<const wchar_t*> argv;
+        argv.reserve(args.size());
+        for (auto& arg : args) argv.push_back(arg.c_str());
+        const int argc = static_cast<int>(argv.size());
+
+        // the best of a few runs, the first touch of a large heap alone can cost several times the parse
+        const int runs = 3;
+        double best = 0;
+        size_t bytes = 0;
+        for (int run = 0; run < runs; ++run)
+        {
+            scoped_alloc_counter counter;
+            const auto start = std::chrono::steady_clock::now();
+            {
+                arg_parser parser;
+                parser.parse(argc, argv.data());
+            }
+            const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = run == 0 ? elapsed : (std::min)(best, elapsed);
+            bytes = counter.bytes();
+        }
+        return scaling_sample{ args.size(), best / args.size(), static_cast<double>(bytes) / args.size() };
+    }
+
+    void check_scaling(const char* name, const command_line_generator& generate)
+    {
+        std::vector<scaling_sample> samples;
+        for (size_t tokens = 10; tokens <= MAX_TOKENS; tokens *= 10)
+        {
+            samples.push_back(measure(generate, tokens));
+            const scaling_sample& sample = samples.back();
+            std::string message = std::string(name) + ": " + std::to_string(sample.m_tokens) + " tokens, "
+                + std::to_string(sample.m_ns_per_token) + " ns/token, " + std::to_string(sample.m_bytes_per_token) + " bytes/token";
+            Logger::WriteMessage(message.c_str());
+        }
+
+        // small sizes are dominated by constructing the parser, growth is judged from 1k and 10k tokens on
+        const scaling_sample& time_base = samples[3];
+        const scaling_sample& memory_base = samples[2];
+        for (size_t i = 3; i < samples.size(); ++i)
+        {
+            const double time_growth = samples[i].m_ns_per_token / time_base.m_ns_per_token;
+            const double memory_growth = samples[i].m_bytes_per_token / memory_base.m_bytes_per_token;
+            std::string message = std::string(name) + ": per token cost at " + std::to_string(samples[i].m_tokens)
+                + " tokens is " + std::to_string(time_growth) + "x in time and " + std::to_string(memory_growth) + "x in memory";
+            Assert::IsTrue(time_growth <= MAX_TIME_GROWTH, std::wstring(message.begin(), message.end()).c_str());
+            Assert::IsTrue(memory_growth <= MAX_MEMORY_GROWTH, std::wstring(message.begin(), message.end()).c_str());
+        }
+    }
+
+    TEST_CLASS(ArgParserScalingTests)
+    {
+    public:
+        TEST_METHOD(TEST_SCALING_REPEATED_FLAGS)
+        {
+            check_scaling("repeated flags", [](size_t tokens) {
+                wstr_vec args = { L"wperf", L"stat" };
+                const wchar_t* events[] = { L"ld_spec", L"st_spec", L"vfp_spec", L"r1b" };
+                for (size_t i = 0; args.size() < tokens; ++i)
+                {
+                    args.push_back(L"-e");
+                    args.push_back(events[i % 4]);
+                }
+                return args;
+            });
+        }
+
+        TEST_METHOD(TEST_SCALING_MIXED_FLAGS)
+        {
+            check_scaling("mixed flags", [](size_t tokens) {
+                wstr_vec args = { L"wperf", L"record", L"-t" };
+                const wstr_vec flags[] = { { L"-k" }, { L"--timeout", L"2" }, { L"-c", L"0,1" }, { L"--verbose" }, { L"--symbol", L"main" }, { L"-n", L"3" } };
+                for (size_t i = 0; args.size() < tokens; ++i)
+                    args.insert(args.end(), flags[i % 6].begin(), flags[i % 6].end());
+                return args;
+            });
+        }
+
+        TEST_METHOD(TEST_SCALING_LONG_EVENT_LIST)
+        {
+            // a single -e value holding one event name per token of the other shapes
+            check_scaling("long -e list", [](size_t tokens) {
+                const wchar_t* events[] = { L"ld_spec", L"st_spec", L"vfp_spec", L"r1b" };
+                std::wstring list;
+                for (size_t i = 0; i < tokens; ++i)
+                {
+                    if (i > 0) list += (i % 8 == 0) ? L"},{" : L",";
+                    list += events[i % 4];
+                }
+                wstr_vec args = { L"wperf", L"stat", L"-e", L"{" + list + L"}" };
+                // padded with names so the per token figures compare with the other shapes
+                args.resize(tokens, L"-k");
+                return args;
+            });
+        }
+
+        TEST_METHOD(TEST_SCALING_DEEP_PASSTHROUGH)
+        {
+            check_scaling("deep passthrough", [](size_t tokens) {
+                wstr_vec args = { L"wperf", L"record", L"-e", L"ld_spec", L"--", L"app.exe" };
+                for (size_t i = 0; args.size() < tokens; ++i)
+                    args.push_back(i % 3 ? L"--input=data" + std::to_wstring(i) : L"two words");
+                return args;
+            });
+        }
+    };
+}
@@ -0,0 +1,232 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-scheduler.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+using namespace std::chrono_literals;
+
+namespace arg_parser_scheduler_tests
+{
+    timeline_schedule parse_schedule(std::vector<const wchar_t*> argv)
+    {
+        argv.insert(argv.begin(), L"wperf");
+        arg_parser parser;
+        parser.parse(static_cast<int>(argv.size()), argv.data());
+        return parser.get_timeline_schedule();
+    }
+
+    double to_us(std::chrono::nanoseconds duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    // Mean lateness of the first and of the last thousand windows, in microseconds
+    std::pair<double, double> lateness_at_ends(const std::vector<std::chrono::nanoseconds>& lateness)
+    {
+        const size_t span = (std::min)(lateness.size(), size_t(1000));
+        const auto mean = [&](size_t first) {
+            std::chrono::nanoseconds total{ 0 };
+            for (size_t i = first; i < first + span; ++i) total += lateness[i];
+            return to_us(total) / span;
+        };
+        return { mean(0), mean(lateness.size() - span) };
+    }
+
+    void log_lateness(const char* name, std::vector<std::chrono::nanoseconds> lateness)
+    {
+        const auto ends = lateness_at_ends(lateness);
+        std::sort(lateness.begin(), lateness.end());
+        std::string message = std::string(name) + ": " + std::to_string(lateness.size()) + " windows, lateness p50 "
+            + std::to_string(to_us(lateness[lateness.size() / 2])) + " us, p99 " + std::to_string(to_us(lateness[lateness.size() * 99 / 100]))
+            + " us, max " + std::to_string(to_us(lateness.back())) + " us, drift " + std::to_string(ends.second - ends.first) + " us";
+        Logger::WriteMessage(message.c_str());
+    }
+
+    TEST_CLASS(ArgParserSchedulerTests)
+    {
+    public:
+        TEST_METHOD(TEST_SCHEDULE_FROM_FLAGS)
+        {
+            timeline_schedule schedule = parse_schedule({ L"stat", L"-e", L"ld_spec", L"-t", L"-i", L"250ms", L"-n", L"4", L"--timeout", L"0.5" });
+            Assert::IsTrue(schedule.m_window == 500ms);
+            Assert::IsTrue(schedule.m_interval == 250ms);
+            Assert::AreEqual(size_t(4), schedule.m_iterations);
+
+            schedule = parse_schedule({ L"stat", L"-e", L"ld_spec", L"--timeout", L"2" });
+            Assert::IsTrue(schedule.m_window == 2s);
+            Assert::IsTrue(schedule.m_interval == 0s);
+            Assert::AreEqual(size_t(1), schedule.m_iterations);
+
+            schedule = parse_schedule({ L"stat", L"-e", L"ld_spec", L"-t" });
+            Assert::IsTrue(schedule.m_window == timeline_schedule::UNTIL_CANCELLED);
+            Assert::IsTrue(schedule.m_interval == timeline_schedule::DEFAULT_INTERVAL);
+            Assert::AreEqual(size_t(0), schedule.m_iterations);
+        }
+
+        TEST_METHOD(TEST_LATE_WINDOW_DOES_NOT_SHIFT_LATER_ONES)
+        {
+            timeline_schedule schedule;
+            schedule.m_window = 5ms;
+            schedule.m_interval = 5ms;
+            schedule.m_iterations = 6;
+
+            std::vector<size_t> started, stopped;
+            const timeline_run run = timeline_scheduler(schedule).run(
+                [&](size_t iteration) { started.push_back(iteration); },
+                [&](size_t iteration) {
+                    stopped.push_back(iteration);
+                    // reading the counters of window 1 overruns the start of window 2
+                    if (iteration == 1) std::this_thread::sleep_for(12ms);
+                });
+
+            Assert::IsFalse(run.m_is_cancelled);
+            Assert::AreEqual(size_t(6), run.m_iterations.size());
+            Assert::IsTrue(started == std::vector<size_t>({ 0, 1, 2, 3, 4, 5 }));
+            Assert::IsTrue(stopped == started);
+            for (size_t i = 0; i < run.m_iterations.size(); ++i)
+            {
+                const timeline_iteration& window = run.m_iterations[i];
+                const std::chrono::nanoseconds slot = static_cast<long long>(i) * 10ms;
+                Assert::IsTrue(window.m_intended_start == slot);
+                Assert::IsTrue(window.m_intended_end == slot + 5ms);
+                Assert::IsTrue(window.m_actual_start >= window.m_intended_start);
+                Assert::IsTrue(window.m_actual_end >= window.m_intended_end);
+            }
+            Assert::IsTrue(run.m_iterations[2].m_actual_start - run.m_iterations[2].m_intended_start >= 5ms);
+            // the overrun is not carried over: relative sleeps would leave every later window 12 ms behind
+            Assert::IsTrue(run.m_iterations[5].m_actual_start - run.m_iterations[5].m_intended_start < 10ms);
+        }
+
+        TEST_METHOD(TEST_CANCEL_ENDS_OPEN_WINDOW)
+        {
+            cancellation_token token;
+            timeline_schedule schedule;
+            schedule.m_iterations = 0;
+            size_t stops = 0;
+            std::thread canceller([&token] {
+                std::this_thread::sleep_for(20ms);
+                token.cancel();
+            });
+            const auto start = std::chrono::steady_clock::now();
+            const timeline_run run = timeline_scheduler(schedule, &token).run([](size_t) {}, [&stops](size_t) { ++stops; });
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            canceller.join();
+
+            Assert::IsTrue(run.m_is_cancelled);
+            Assert::AreEqual(size_t(1), run.m_iterations.size());
+            Assert::AreEqual(size_t(1), stops);
+            Assert::IsTrue(run.m_iterations[0].m_intended_end == timeline_schedule::UNTIL_CANCELLED);
+            Assert::IsTrue(elapsed < 1s);
+        }
+
+        TEST_METHOD(TEST_CANCEL_BEFORE_START)
+        {
+            cancellation_token token;
+            token.cancel();
+            timeline_schedule schedule;
+            schedule.m_window = 1ms;
+            schedule.m_iterations = 3;
+            size_t callbacks = 0;
+            const timeline_run run = timeline_scheduler(schedule, &token).run([&](size_t) { ++callbacks; }, [&](size_t) { ++callbacks; });
+            Assert::IsTrue(run.m_is_cancelled);
+            Assert::AreEqual(size_t(0), run.m_iterations.size());
+            Assert::AreEqual(size_t(0), callbacks);
+        }
+
+        TEST_METHOD(TEST_INTERRUPT_GUARD)
+        {
+            cancellation_token token;
+            {
+                interrupt_guard guard(token);
+                cancellation_token other;
+                Assert::ExpectException<std::logic_error>([&]() { interrupt_guard second(other); });
+    #ifndef _WIN32
+                std::raise(SIGINT);
+                Assert::IsTrue(token.is_cancelled());
+    #endif
+            }
+            // gone with the guard, a new one can be installed
+            token.reset();
+            interrupt_guard guard(token);
+            Assert::IsFalse(token.is_cancelled());
+        }
+
+        TEST_METHOD(BENCH_SCHEDULER_DRIFT)
+        {
+            // 10k windows of 100 us with 100 us in between: absolute deadlines, and on Linux the loop
+            // of relative sleeps they replace, which adds every oversleep to all later windows
+            constexpr size_t ITERATIONS = 10'000;
+            timeline_schedule schedule;
+            schedule.m_window = 100us;
+            schedule.m_interval = 100us;
+            schedule.m_iterations = ITERATIONS;
+
+            cancellation_token token;
+            const timeline_run run = timeline_scheduler(schedule, &token).run([](size_t) {}, [](size_t) {});
+            std::vector<std::chrono::nanoseconds> lateness;
+            lateness.reserve(ITERATIONS);
+            for (auto& window : run.m_iterations)
+                lateness.push_back(window.m_actual_start - window.m_intended_start);
+            log_lateness("absolute deadlines", lateness);
+            const auto ends = lateness_at_ends(lateness);
+
+#ifdef __linux__
+            // short sleeps round up to the system timer on Windows, which would stretch the
+            // comparison loop to many seconds, so it only runs where sleep_for is precise
+            lateness.clear();
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < ITERATIONS; ++i)
+            {
+                lateness.push_back(std::chrono::steady_clock::now() - start - static_cast<long long>(i) * 200us);
+                std::this_thread::sleep_for(schedule.m_window);
+                std::this_thread::sleep_for(schedule.m_interval);
+            }
+            log_lateness("relative sleeps", lateness);
+#endif
+
+            Assert::AreEqual(ITERATIONS, run.m_iterations.size());
+            Assert::IsTrue(ends.second - ends.first < 2000.0);
+        }
+    };
+}
@@ -0,0 +1,104 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <algorithm>
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_stats_tests
+{
+    TEST_CLASS(ArgParserStatsTests)
+    {
+    public:
+        TEST_METHOD(TEST_PARSER_STATS_FLAG_IS_HIDDEN)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"--parser-stats" };
+            int argc = 3;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            Assert::IsTrue(parser.parser_stats_opt.is_set());
+            Assert::IsTrue(std::find(parser.m_flags_list.begin(), parser.m_flags_list.end(), &parser.parser_stats_opt) == parser.m_flags_list.end());
+        }
+
+        TEST_METHOD(TEST_PARSE_COUNTERS)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"-c", L"0", L"--json" };
+            int argc = 7;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            const parse_stats& stats = parser.get_stats();
+            if (!parse_stats_enabled())
+            {
+                Assert::AreEqual(std::uint64_t(0), stats.m_tokens);
+                Assert::AreEqual(std::uint64_t(0), stats.m_flag_probes);
+                return;
+            }
+            Assert::AreEqual(std::uint64_t(argc - 1), stats.m_tokens);
+            Assert::IsTrue(stats.m_flag_probes >= std::uint64_t(3));
+            Assert::AreEqual(std::uint64_t(1), stats.m_phase_calls[static_cast<size_t>(PARSE_PHASE::ARGV_INGESTION)]);
+            Assert::AreEqual(std::uint64_t(1), stats.m_phase_calls[static_cast<size_t>(PARSE_PHASE::COMMAND_SELECTION)]);
+            Assert::AreEqual(std::uint64_t(1), stats.m_phase_calls[static_cast<size_t>(PARSE_PHASE::FLAG_LOOP)]);
+            Assert::AreEqual(std::uint64_t(1), stats.m_phase_calls[static_cast<size_t>(PARSE_PHASE::VALIDATION)]);
+        }
+
+        // Formatting an error is timed by the phase that raised it, not as a second phase
+        TEST_METHOD(TEST_ERROR_FORMATTING_IS_COUNTED)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"--unknown" };
+            int argc = 3;
+            arg_parser parser;
+            Assert::ExpectException<std::invalid_argument>([&parser, argc, &argv]() {
+                parser.parse(argc, argv);
+                }
+            );
+            if (!parse_stats_enabled()) return;
+            Assert::AreEqual(std::uint64_t(1), parser.get_stats().m_phase_calls[static_cast<size_t>(PARSE_PHASE::FLAG_LOOP)]);
+            Assert::AreEqual(std::uint64_t(0), parser.get_stats().m_phase_calls[static_cast<size_t>(PARSE_PHASE::VALIDATION)]);
+        }
+
+        TEST_METHOD(TEST_STATS_JSON)
+        {
+            parse_stats stats;
+            stats.m_tokens = 4;
+            std::string json = stats.to_json();
+            Assert::IsTrue(json.front() == '{' && json.back() == '}');
+            Assert::IsTrue(json.find("\"tokens\":4") != std::string::npos);
+            Assert::IsTrue(json.find("\"flag_loop\":{\"calls\":0,\"ns\":0}") != std::string::npos);
+            Assert::IsTrue(json.find("\"print_help\"") != std::string::npos);
+        }
+    };
+}
@@ -0,0 +1,175 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_symbol_matcher_tests
+{
+    TEST_CLASS(ArgParserSymbolMatcherTests)
+    {
+    public:
+        TEST_METHOD(TEST_EMPTY_MATCHER_MATCHES_EVERYTHING)
+        {
+            symbol_matcher matcher;
+            Assert::IsTrue(matcher.empty());
+            Assert::IsTrue(matcher.match(L"main"));
+            Assert::IsTrue(matcher.match(L""));
+        }
+
+        TEST_METHOD(TEST_LITERAL_PATTERNS)
+        {
+            symbol_matcher matcher({ L"main", L"mainCRTStartup" });
+            Assert::IsTrue(matcher.match(L"main"));
+            Assert::IsTrue(matcher.match(L"mainCRTStartup"));
+            Assert::IsFalse(matcher.match(L"mai"));
+            Assert::IsFalse(matcher.match(L"main2"));
+            Assert::AreEqual(std::uint32_t(1), matcher.match_index(L"mainCRTStartup"));
+        }
+
+        TEST_METHOD(TEST_GLOB_PATTERNS)
+        {
+            symbol_matcher matcher({ L"std::*", L"*_spec", L"f?o", L"a*b*c" });
+            Assert::IsTrue(matcher.match(L"std::vector<int>::push_back"));
+            Assert::IsTrue(matcher.match(L"ld_spec"));
+            Assert::IsTrue(matcher.match(L"foo"));
+            Assert::IsTrue(matcher.match(L"f_o"));
+            Assert::IsTrue(matcher.match(L"abc"));
+            Assert::IsTrue(matcher.match(L"a__b__c"));
+            Assert::IsTrue(matcher.match(L"abcbc"));
+            Assert::IsFalse(matcher.match(L"fo"));
+            Assert::IsFalse(matcher.match(L"ab"));
+            Assert::IsFalse(matcher.match(L"stdx"));
+            Assert::AreEqual(std::uint32_t(0), matcher.match_index(L"std::_spec"));
+            Assert::AreEqual(symbol_matcher::NO_MATCH, matcher.match_index(L"other"));
+        }
+
+        TEST_METHOD(TEST_ESCAPED_AND_WIDE_CHARACTERS)
+        {
+            symbol_matcher matcher({ L"operator\\*", L"\u00e9t\u00e9*" });
+            Assert::IsTrue(matcher.match(L"operator*"));
+            Assert::IsFalse(matcher.match(L"operator+"));
+            Assert::IsTrue(matcher.match(L"\u00e9t\u00e9_2024"));
+            Assert::IsFalse(matcher.match(L"ete_2024"));
+        }
+
+        TEST_METHOD(TEST_SPLIT_PATTERNS)
+        {
+            std::vector<std::wstring> patterns = symbol_matcher::split_patterns({ L"main,foo*", L"bar\\,baz" });
+            Assert::AreEqual(size_t(3), patterns.size());
+            Assert::AreEqual(std::wstring(L"main"), patterns[0]);
+            Assert::AreEqual(std::wstring(L"foo*"), patterns[1]);
+            Assert::AreEqual(std::wstring(L"bar,baz"), patterns[2]);
+
+            for (const wchar_t* value : { L",", L"main,", L"main,,foo", L"" })
+                Assert::ExpectException<std::invalid_argument>([value]() { symbol_matcher::split_patterns({ value }); });
+        }
+
+        TEST_METHOD(TEST_PARSER_REJECTS_EMPTY_SYMBOL_PATTERN)
+        {
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--symbol", L"," };
+            buffer_sink errors;
+            arg_parser parser;
+            parser.set_error_sink(errors);
+            Assert::ExpectException<std::invalid_argument>([&parser, &argv]() { parser.parse(4, argv); });
+            Assert::AreNotEqual(std::string::npos, errors.get_buffer().find("empty pattern"));
+        }
+
+        TEST_METHOD(TEST_COMPILE_LIMITS)
+        {
+            std::wstring distinct;
+            for (wchar_t c = 0x4E00; c < 0x4E00 + 200; ++c) distinct += c;
+            const std::wstring too_long(symbol_matcher::MAX_PATTERN_LENGTH + 1, L'a');
+            // one any-character per position after `*a` doubles the subset states
+            const auto wildcards = [](size_t count) { return L"*a" + std::wstring(count, L'?'); };
+
+            Assert::ExpectException<std::invalid_argument>([&]() { symbol_matcher({ too_long }); });
+            Assert::ExpectException<std::invalid_argument>([&]() { symbol_matcher({ wildcards(12), distinct }); });
+            Assert::ExpectException<std::invalid_argument>([&]() { symbol_matcher({ wildcards(30) }); });
+
+            const symbol_matcher matcher({ wildcards(10), distinct.substr(0, 20) });
+            Assert::IsTrue(matcher.match(L"xxa0123456789"));
+            Assert::IsFalse(matcher.match(L"xxa012345678"));
+            Assert::IsTrue(matcher.match(distinct.substr(0, 20)));
+        }
+
+        TEST_METHOD(TEST_PARSER_COMPILES_SYMBOL_FLAG)
+        {
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--symbol", L"main,Py*", L"-s", L"*alloc" };
+            int argc = 6;
+            arg_parser parser;
+            parser.parse(argc, argv);
+
+            const symbol_matcher& matcher = parser.get_symbol_matcher();
+            Assert::AreEqual(size_t(3), matcher.get_pattern_count());
+            Assert::IsTrue(matcher.match(L"PyEval_EvalFrameDefault"));
+            Assert::IsTrue(matcher.match(L"malloc"));
+            Assert::IsFalse(matcher.match(L"memcpy"));
+        }
+    };
+
+    TEST_CLASS(ArgParserSymbolMatcherBenchmark)
+    {
+    public:
+        TEST_METHOD(BENCH_SYMBOL_MATCH_THROUGHPUT)
+        {
+            symbol_matcher matcher({ L"Py*Eval*", L"*alloc", L"std::vector<*>::push_back", L"main", L"__*_spec" });
+
+            const wchar_t* prefixes[] = { L"Py", L"std::vector<int>::", L"_", L"mem", L"nt!Ke" };
+            const wchar_t* suffixes[] = { L"EvalFrameDefault", L"push_back", L"_ld_spec", L"cpy", L"malloc", L"WaitForSingleObject" };
+            std::vector<std::wstring> names;
+            for (size_t i = 0; i < 4096; ++i)
+                names.push_back(std::wstring(prefixes[i % 5]) + suffixes[(i / 5) % 6] + std::to_wstring(i % 3 == 0 ? i : 0).substr(0, i % 3 == 0 ? 8 : 0));
+
+            const size_t iterations = 256;
+            size_t matched = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                for (auto& name : names) matched += matcher.match(name);
+            }
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const double per_second = (iterations * names.size()) / elapsed;
+            std::wstring message = L"symbol_matcher: " + std::to_wstring(static_cast<long long>(per_second)) + L" names/s, "
+                + std::to_wstring(matcher.get_state_count()) + L" DFA states";
+            Logger::WriteMessage(message.c_str());
+            Assert::IsTrue(matched > 0 && matched < iterations * names.size());
+        }
+    };
+}
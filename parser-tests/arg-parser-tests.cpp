@@ -227,8 +227,8 @@ namespace arg_parser_tests
         // Test parsing sample command with pdb_file
         TEST_METHOD(TEST_SAMPLE_COMMAND_WITH_PDB_FILE)
         {
-            const wchar_t* argv[] = { L"wperf", L"sample", L"--pdb_file", L"C:\\Program\\sample.pdb" };
-            int argc = 4;
+            const wchar_t* argv[] = { L"wperf", L"sample", L"--pe_file", L"C:\\Program\\sample.exe", L"--pdb_file", L"C:\\Program\\sample.pdb" };
+            int argc = 6;
             arg_parser parser;
 
             // Similarly, adjust or mock check_file_path for testing
@@ -326,5 +326,33 @@ namespace arg_parser_tests
             Assert::IsTrue(check_value_in_vector(parser.output_filename_arg.get_values(), L"_output_02.json"));
             Assert::IsTrue(check_value_in_vector(parser.events_arg.get_values(), L"inst_spec,vfp_spec,ase_spec,dp_spec,ld_spec,st_spec,br_immed_spec,crypto_spec"));
         }
+
+        // Test that the command sniffer agrees with the full command list
+        TEST_METHOD(TEST_SNIFF_COMMAND_MATCHES_COMMAND_LIST)
+        {
+            arg_parser parser;
+            for (auto& command : parser.m_commands_list)
+            {
+                std::vector<std::wstring> tokens = command->m_aliases;
+                tokens.push_back(command->get_name());
+                for (auto& token : tokens)
+                {
+                    if (token.empty()) continue;
+                    const wchar_t* argv[] = { L"wperf", token.c_str(), L"-v" };
+                    Assert::IsTrue(command->m_command == arg_parser::sniff_command(3, argv));
+                }
+            }
+        }
+
+        // Test that the command sniffer rejects anything that is not a command
+        TEST_METHOD(TEST_SNIFF_COMMAND_NO_COMMAND)
+        {
+            const wchar_t* no_args[] = { L"wperf" };
+            const wchar_t* flag_first[] = { L"wperf", L"--json", L"stat" };
+            const wchar_t* prefix[] = { L"wperf", L"sta" };
+            Assert::IsTrue(COMMAND_CLASS::NO_COMMAND == arg_parser::sniff_command(1, no_args));
+            Assert::IsTrue(COMMAND_CLASS::NO_COMMAND == arg_parser::sniff_command(3, flag_first));
+            Assert::IsTrue(COMMAND_CLASS::NO_COMMAND == arg_parser::sniff_command(2, prefix));
+        }
     };
 }
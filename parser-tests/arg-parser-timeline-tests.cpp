@@ -0,0 +1,272 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-output.h"
+#include "parser/arg-parser-timeline.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_timeline_tests
+{
+    // Keeps every chunk it is handed apart, and can be held up to play a slow disk
+    class chunk_sink : public output_sink {
+    public:
+        void write(const char* data, size_t size) override
+        {
+            while (m_is_held.load()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+            if (m_delay.count() > 0) std::this_thread::sleep_for(m_delay);
+            m_chunks.emplace_back(data, size);
+        }
+        void flush() override { ++m_flushes; }
+
+        std::string get_text() const
+        {
+            std::string text;
+            for (auto& chunk : m_chunks) text += chunk;
+            return text;
+        }
+
+        std::vector<std::string> m_chunks;
+        std::atomic<bool> m_is_held{ false };
+        std::chrono::microseconds m_delay{ 0 };
+        size_t m_flushes = 0;
+    };
+
+    std::string read_file(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    TEST_CLASS(ArgParserTimelineTests)
+    {
+    public:
+        TEST_METHOD(TEST_RESOLVE_OUTPUT_PATH)
+        {
+            Assert::IsTrue(resolve_output_path(L"", L"out.csv") == std::filesystem::path(L"out.csv"));
+            Assert::IsTrue(resolve_output_path(L"results", L"out.csv") == std::filesystem::path(L"results") / L"out.csv");
+            const std::filesystem::path absolute = std::filesystem::temp_directory_path() / L"out.csv";
+            Assert::IsTrue(resolve_output_path(L"results", absolute.wstring()) == absolute);
+        }
+
+        TEST_METHOD(TEST_ROW_FORMATTING)
+        {
+            buffer_sink sink;
+            {
+                timeline_writer writer(sink);
+                Assert::IsTrue(writer.write_row("core", L"inst_spec", 7, -3, 123456789012345ull, 2.5));
+                Assert::IsTrue(writer.write_row("a,b", "say \"hi\"", L"line\nbreak", std::string("plain")));
+                Assert::IsTrue(writer.write("{\"core\":0}\n"));
+            }
+            Assert::AreEqual(std::string("core,inst_spec,7,-3,123456789012345,2.5\n\"a,b\",\"say \"\"hi\"\"\",\"line\nbreak\",plain\n{\"core\":0}\n"), sink.get_buffer());
+        }
+
+        TEST_METHOD(TEST_BUFFERS_HOLD_WHOLE_ROWS)
+        {
+            chunk_sink sink;
+            std::string expected;
+            {
+                timeline_writer writer(sink, 100);
+                for (int row = 0; row < 1000; ++row)
+                {
+                    Assert::IsTrue(writer.write_row(row, row * 3, "cycles"));
+                    expected += std::to_string(row) + "," + std::to_string(row * 3) + ",cycles\n";
+                }
+                writer.flush();
+                Assert::AreEqual(size_t(1), sink.m_flushes);
+                const timeline_writer_stats stats = writer.get_stats();
+                Assert::AreEqual(size_t(1000), stats.m_rows);
+                Assert::AreEqual(size_t(0), stats.m_rows_dropped);
+                Assert::AreEqual(expected.size(), stats.m_bytes_written);
+            }
+            Assert::AreEqual(expected, sink.get_text());
+            Assert::IsTrue(sink.m_chunks.size() > 100);
+            for (auto& chunk : sink.m_chunks)
+            {
+                Assert::IsTrue(chunk.size() <= 100);
+                Assert::AreEqual('\n', chunk.back());
+            }
+        }
+
+        TEST_METHOD(TEST_BLOCK_WAITS_FOR_SLOW_SINK)
+        {
+            chunk_sink sink;
+            sink.m_delay = std::chrono::microseconds(500);
+            size_t stalls = 0;
+            {
+                timeline_writer writer(sink, 64, BACKPRESSURE::BLOCK);
+                for (int row = 0; row < 200; ++row)
+                    Assert::IsTrue(writer.write_row(row, "ld_spec", 1.25));
+                stalls = writer.get_stats().m_stalls;
+            }
+            Assert::IsTrue(stalls > 0);
+            const std::string text = sink.get_text();
+            Assert::AreEqual(ptrdiff_t(200), std::count(text.begin(), text.end(), '\n'));
+        }
+
+        TEST_METHOD(TEST_DROP_KEEPS_MEMORY_BOUNDED)
+        {
+            chunk_sink sink;
+            sink.m_is_held = true;
+            timeline_writer_stats stats;
+            {
+                timeline_writer writer(sink, 64, BACKPRESSURE::DROP);
+                size_t kept = 0;
+                for (int row = 0; row < 1000; ++row)
+                    kept += writer.write_row(row, "st_spec") ? 1 : 0;
+                stats = writer.get_stats();
+                Assert::AreEqual(kept, stats.m_rows);
+                Assert::AreEqual(size_t(1000), stats.m_rows + stats.m_rows_dropped);
+                // the held sink keeps one buffer, the other fills up and everything after it is dropped
+                Assert::IsTrue(stats.m_rows < 20);
+                Assert::AreEqual(size_t(0), stats.m_stalls);
+                sink.m_is_held = false;
+                writer.flush();
+                Assert::IsTrue(writer.write_row(1000, "st_spec"));
+            }
+            const std::string text = sink.get_text();
+            Assert::AreEqual(ptrdiff_t(stats.m_rows + 1), std::count(text.begin(), text.end(), '\n'));
+            Assert::AreEqual(std::string("1000,st_spec\n"), text.substr(text.size() - 13));
+        }
+
+        TEST_METHOD(TEST_ROW_LARGER_THAN_BUFFER)
+        {
+            buffer_sink sink;
+            {
+                timeline_writer writer(sink, 16);
+                Assert::IsTrue(writer.write("short\n"));
+                Assert::ExpectException<std::length_error>([&]() { writer.write(std::string(40, 'x')); });
+                // the rejected record leaves nothing behind
+                Assert::IsTrue(writer.write("after\n"));
+            }
+            Assert::AreEqual(std::string("short\nafter\n"), sink.get_buffer());
+        }
+
+        TEST_METHOD(TEST_OPEN_TIMELINE_OUTPUTS)
+        {
+            const std::filesystem::path root = std::filesystem::temp_directory_path() / L"wperf-timeline-outputs";
+            std::filesystem::remove_all(root);
+            std::filesystem::create_directories(root);
+            const std::wstring prefix = root.wstring();
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"-t", L"-i", L"1", L"-n", L"2", L"--output-prefix", prefix.c_str(), L"--output-csv", L"counts.csv", L"--output", L"counts.json" };
+            arg_parser parser;
+            parser.parse(15, argv);
+            // parse only checks the paths
+            Assert::IsFalse(std::filesystem::exists(root / L"counts.csv"));
+
+            timeline_outputs outputs = parser.open_timeline_outputs();
+            Assert::IsTrue(outputs.m_csv.m_sink != nullptr);
+            Assert::IsTrue(outputs.m_csv.m_path == root / L"counts.csv");
+            Assert::IsTrue(outputs.m_json.m_sink != nullptr);
+            Assert::IsTrue(std::filesystem::exists(root / L"counts.json"));
+
+            {
+                timeline_writer writer(*outputs.m_csv.m_sink);
+                writer.write_row("core", "ld_spec");
+                // the files belong to the caller, resetting or parsing again leaves them alone
+                parser.reset();
+                parser.parse(15, argv);
+                writer.write_row(0, 42);
+            }
+            outputs = {};
+            Assert::AreEqual(std::string("core,ld_spec\n0,42\n"), read_file(root / L"counts.csv"));
+        }
+
+        TEST_METHOD(TEST_PARSE_REPORTS_UNWRITABLE_OUTPUTS)
+        {
+            const std::filesystem::path missing = std::filesystem::temp_directory_path() / L"wperf-timeline-missing" / L"dir";
+            std::filesystem::remove_all(missing.parent_path());
+            const std::wstring prefix = missing.wstring();
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"-t", L"--output-prefix", prefix.c_str(), L"--output-csv", L"counts.csv", L"--output", L"counts.json" };
+            buffer_sink errors;
+            arg_parser parser;
+            parser.set_error_sink(errors);
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(11, argv); });
+            const std::string error = errors.get_buffer();
+            Assert::AreNotEqual(std::string::npos, error.find("the following timeline outputs cannot be created"));
+            Assert::AreNotEqual(std::string::npos, error.find("counts.csv (--output-csv)"));
+            Assert::AreNotEqual(std::string::npos, error.find("counts.json (--output)"));
+
+            Assert::IsFalse(can_create_file(missing / L"counts.csv"));
+            Assert::IsFalse(can_create_file(std::filesystem::temp_directory_path()));
+            Assert::IsTrue(can_create_file(std::filesystem::temp_directory_path() / L"wperf-timeline-new.csv"));
+        }
+
+        TEST_METHOD(TEST_NO_TIMELINE_NO_FILES)
+        {
+            const std::filesystem::path path = std::filesystem::temp_directory_path() / L"wperf-timeline-untouched.json";
+            std::filesystem::remove(path);
+            const std::wstring output = path.wstring();
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec", L"--output", output.c_str() };
+            arg_parser parser;
+            parser.parse(6, argv);
+            Assert::IsTrue(parser.open_timeline_outputs().m_json.m_sink == nullptr);
+            Assert::IsFalse(std::filesystem::exists(path));
+        }
+
+        TEST_METHOD(BENCH_TIMELINE_WRITER)
+        {
+            // a row per interval for 128 cores of 6 counters each, against a sink that costs nothing
+            // and one that takes 100 us per buffer
+            constexpr int ROWS = 20000;
+            for (const auto delay : { std::chrono::microseconds(0), std::chrono::microseconds(100) })
+            {
+                chunk_sink sink;
+                sink.m_delay = delay;
+                timeline_writer writer(sink);
+                const auto start = std::chrono::steady_clock::now();
+                for (int row = 0; row < ROWS; ++row)
+                    writer.write_row(row / 128, row % 128, 123456789ull + row, 987654321ull, 42ull, 7ull, 1000000ull + row, 0.75);
+                const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                const timeline_writer_stats stats = writer.get_stats();
+                std::string message = "timeline_writer, " + std::to_string(delay.count()) + " us per buffer: "
+                    + std::to_string(elapsed / ROWS) + " ns/row, " + std::to_string(stats.m_stalls) + " stalls";
+                Logger::WriteMessage(message.c_str());
+            }
+        }
+    };
+}
@@ -0,0 +1,172 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include "parser/arg-parser-tokenizer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_tokenizer_tests
+{
+    template<class CharT>
+    void assert_same_spans(const std::vector<token_span<CharT>>& expected, const std::vector<token_span<CharT>>& actual)
+    {
+        Assert::AreEqual(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            Assert::IsTrue(expected[i].m_text.data() == actual[i].m_text.data());
+            Assert::AreEqual(expected[i].m_text.size(), actual[i].m_text.size());
+            Assert::IsTrue(expected[i].m_delimiter == actual[i].m_delimiter);
+        }
+    }
+
+    TEST_CLASS(ArgParserTokenizerTests)
+    {
+    public:
+        TEST_METHOD(TEST_TOKENIZE_EVENT_LIST)
+        {
+            const std::wstring events = L"{inst_spec,vfp_spec},ld_spec:k,st_spec";
+            std::vector<token_span<wchar_t>> spans;
+            tokenize(events, spans);
+
+            Assert::AreEqual(size_t(7), spans.size());
+            Assert::IsTrue(spans[0].m_text.empty() && spans[0].m_delimiter == L'{');
+            Assert::IsTrue(spans[1].m_text == L"inst_spec" && spans[1].m_delimiter == L',');
+            Assert::IsTrue(spans[2].m_text == L"vfp_spec" && spans[2].m_delimiter == L'}');
+            Assert::IsTrue(spans[3].m_text.empty() && spans[3].m_delimiter == L',');
+            Assert::IsTrue(spans[4].m_text == L"ld_spec" && spans[4].m_delimiter == L':');
+            Assert::IsTrue(spans[5].m_text == L"k" && spans[5].m_delimiter == L',');
+            Assert::IsTrue(spans[6].m_text == L"st_spec" && spans[6].m_delimiter == L'\0');
+        }
+
+        TEST_METHOD(TEST_TOKENIZE_SPANS_POINT_INTO_INPUT)
+        {
+            const std::string cores = "0-3,8";
+            std::vector<token_span<char>> spans;
+            tokenize(cores, spans);
+
+            Assert::AreEqual(size_t(3), spans.size());
+            Assert::IsTrue(spans[0].m_text.data() == cores.data());
+            Assert::IsTrue(spans[1].m_text == "3" && spans[0].m_delimiter == '-');
+            Assert::IsTrue(spans[2].m_text.data() == cores.data() + 4);
+        }
+
+        TEST_METHOD(TEST_TOKENIZE_EMPTY_AND_TRAILING)
+        {
+            std::vector<token_span<wchar_t>> spans;
+            tokenize(std::wstring_view(), spans);
+            Assert::AreEqual(size_t(0), spans.size());
+
+            tokenize(L"a,", spans);
+            Assert::AreEqual(size_t(2), spans.size());
+            Assert::IsTrue(spans[1].m_text.empty() && spans[1].m_delimiter == L'\0');
+        }
+
+        // Every length and delimiter position around the vector block sizes must agree with the scalar scan
+        TEST_METHOD(TEST_TOKENIZE_MATCHES_SCALAR)
+        {
+            const wchar_t alphabet[] = { L'a', L',', L'{', L'}', L':', L'-', L'_', 0x2C00, 0x012C };
+            std::vector<token_span<wchar_t>> expected, actual;
+            std::vector<token_span<char>> expected_narrow, actual_narrow;
+            unsigned seed = 7;
+            for (size_t length = 0; length < 100; ++length)
+            {
+                for (size_t round = 0; round < 20; ++round)
+                {
+                    std::wstring text;
+                    std::string narrow;
+                    for (size_t i = 0; i < length; ++i)
+                    {
+                        seed = seed * 1103515245 + 12345;
+                        text += alphabet[(seed >> 16) % 9];
+                        narrow += static_cast<char>(text.back() & 0x7F);
+                    }
+                    tokenize_scalar(text, expected);
+                    tokenize(text, actual);
+                    assert_same_spans(expected, actual);
+
+                    tokenize_scalar(narrow, expected_narrow);
+                    tokenize(narrow, actual_narrow);
+                    assert_same_spans(expected_narrow, actual_narrow);
+                }
+            }
+        }
+    };
+
+    TEST_CLASS(ArgParserTokenizerBenchmark)
+    {
+    public:
+        TEST_METHOD(BENCH_TOKENIZE_LONG_EVENT_LIST)
+        {
+            const wchar_t* events[] = { L"inst_spec", L"vfp_spec", L"ase_spec", L"dp_spec", L"ld_spec", L"st_spec", L"br_immed_spec", L"crypto_spec" };
+            std::wstring list;
+            for (size_t i = 0; list.size() < 64 * 1024; ++i)
+            {
+                if (i % 6 == 0) list += L"{";
+                list += events[i % 8];
+                list += (i % 6 == 5) ? L"}," : L",";
+            }
+
+            std::vector<token_span<wchar_t>> spans;
+            const size_t iterations = 200;
+            size_t tokens = 0;
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                tokenize_scalar(list, spans);
+                tokens += spans.size();
+            }
+            auto scalar = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                tokenize(list, spans);
+                tokens -= spans.size();
+            }
+            auto vector = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const double megabytes = iterations * list.size() * sizeof(wchar_t) / (1024.0 * 1024.0);
+            std::string message = std::string("tokenizer (") + get_tokenizer_isa() + "): "
+                + std::to_string(static_cast<long long>(megabytes / vector)) + " MB/s, scalar: "
+                + std::to_string(static_cast<long long>(megabytes / scalar)) + " MB/s";
+            Logger::WriteMessage(message.c_str());
+            Assert::AreEqual(size_t(0), tokens);
+        }
+    };
+}
@@ -0,0 +1,207 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-output.h"
+#include "parser/arg-parser-topology.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_topology_tests
+{
+    void write_file(const std::filesystem::path& path, const std::string& text)
+    {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << text << "\n";
+    }
+
+    // A fake sysfs tree: 8 CPUs in 2 nodes of 4, clusters and SMT cores of 2, a shared last level
+    // cache per node and CPU 7 offline, without the topology files sysfs drops for offline CPUs.
+    std::filesystem::path make_sysfs_tree(const char* name)
+    {
+        const std::filesystem::path root = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(root);
+        const std::filesystem::path cpu_root = root / "devices" / "system" / "cpu";
+        write_file(cpu_root / "possible", "0-7");
+        write_file(cpu_root / "present", "0-7");
+        write_file(cpu_root / "online", "0-6");
+        for (unsigned cpu = 0; cpu < 7; ++cpu)
+        {
+            const std::filesystem::path cpu_dir = cpu_root / ("cpu" + std::to_string(cpu));
+            const unsigned core = cpu / 2 * 2;
+            const unsigned node = cpu / 4 * 4;
+            write_file(cpu_dir / "topology" / "cluster_id", std::to_string(cpu / 2));
+            write_file(cpu_dir / "topology" / "thread_siblings_list", std::to_string(core) + "-" + std::to_string(core + 1));
+            write_file(cpu_dir / "cache" / "index0" / "level", "1");
+            write_file(cpu_dir / "cache" / "index0" / "shared_cpu_list", std::to_string(cpu));
+            write_file(cpu_dir / "cache" / "index1" / "level", "3");
+            write_file(cpu_dir / "cache" / "index1" / "shared_cpu_list", std::to_string(node) + "-" + std::to_string(node + 3));
+        }
+        write_file(root / "devices" / "system" / "node" / "node0" / "cpulist", "0-3");
+        write_file(root / "devices" / "system" / "node" / "node1" / "cpulist", "4-7");
+        write_file(root / "devices" / "system" / "node" / "online", "0-1");
+        return root;
+    }
+
+    std::vector<unsigned> resolve(const cpu_topology& topology, const wchar_t* cores)
+    {
+        const wchar_t* argv[] = { L"wperf", L"stat", L"-c", cores };
+        arg_parser parser;
+        parser.parse(4, argv);
+        return parser.resolve_cores(topology);
+    }
+
+    std::string resolve_error(const cpu_topology& topology, const wchar_t* cores)
+    {
+        const wchar_t* argv[] = { L"wperf", L"stat", L"-c", cores };
+        buffer_sink errors;
+        arg_parser parser;
+        parser.set_error_sink(errors);
+        parser.parse(4, argv);
+        try
+        {
+            parser.resolve_cores(topology);
+        }
+        catch (const std::invalid_argument&)
+        {
+            return errors.get_buffer();
+        }
+        return "";
+    }
+
+    TEST_CLASS(ArgParserTopologyTests)
+    {
+    public:
+        TEST_METHOD(TEST_PARSE_CPU_LIST)
+        {
+            std::vector<unsigned> cpus;
+            Assert::IsTrue(cpu_topology::parse_cpu_list("0-2,5,8-9\n", cpus));
+            Assert::IsTrue(std::vector<unsigned>{ 0, 1, 2, 5, 8, 9 } == cpus);
+
+            cpus.clear();
+            Assert::IsTrue(cpu_topology::parse_cpu_list("\n", cpus));
+            Assert::IsTrue(cpus.empty());
+            Assert::IsFalse(cpu_topology::parse_cpu_list("3-1", cpus));
+            Assert::IsFalse(cpu_topology::parse_cpu_list("0,x", cpus));
+        }
+
+        TEST_METHOD(TEST_READ_SYSFS)
+        {
+            const cpu_topology topology = cpu_topology::read_sysfs(make_sysfs_tree("wperf-topology-read"));
+            const std::vector<cpu_info>& cpus = topology.get_cpus();
+            Assert::AreEqual(size_t(8), cpus.size());
+            Assert::IsTrue(cpus[7].m_present);
+            Assert::IsFalse(cpus[7].m_online);
+            Assert::AreEqual(1u, cpus[5].m_node);
+            Assert::AreEqual(2u, cpus[5].m_cluster);
+            Assert::IsTrue(std::vector<unsigned>{ 4, 5 } == cpus[5].m_smt_siblings);
+            Assert::IsTrue(std::vector<unsigned>{ 4, 5, 6, 7 } == cpus[5].m_cache_domain);
+            // no topology files: its own core and cache domain
+            Assert::IsTrue(std::vector<unsigned>{ 7 } == cpus[7].m_smt_siblings);
+        }
+
+        TEST_METHOD(TEST_SELECTORS)
+        {
+            const cpu_topology topology = cpu_topology::read_sysfs(make_sysfs_tree("wperf-topology-selectors"));
+            Assert::IsTrue(std::vector<unsigned>{ 0, 1, 2, 3, 4, 5, 6 } == resolve(topology, L"online"));
+            Assert::IsTrue(std::vector<unsigned>{ 0, 1, 2, 3 } == resolve(topology, L"node0"));
+            Assert::IsTrue(std::vector<unsigned>{ 2, 3 } == resolve(topology, L"cluster1"));
+            Assert::IsTrue(std::vector<unsigned>{ 4, 5 } == resolve(topology, L"smt-siblings-of:5"));
+            Assert::IsTrue(std::vector<unsigned>{ 0, 1, 2, 3 } == resolve(topology, L"cache-domain-of:2"));
+            Assert::IsTrue(std::vector<unsigned>{ 0, 1, 3, 4, 5, 6 } == resolve(topology, L"cluster0,3-5,smt-siblings-of:0,6"));
+        }
+
+        TEST_METHOD(TEST_INVALID_CORES_REPORTED_TOGETHER)
+        {
+            const cpu_topology topology = cpu_topology::read_sysfs(make_sysfs_tree("wperf-topology-invalid"));
+            const std::string error = resolve_error(topology, L"1,12,node5,smt-siblings-of:9,7");
+            Assert::AreNotEqual(std::string::npos, error.find("12 does not exist"));
+            Assert::AreNotEqual(std::string::npos, error.find("node5 does not exist"));
+            Assert::AreNotEqual(std::string::npos, error.find("smt-siblings-of:9 does not exist"));
+            Assert::AreNotEqual(std::string::npos, error.find("core 7 is offline"));
+            Assert::AreNotEqual(std::string::npos, resolve_error(topology, L"4-7").find("core 7 is offline"));
+            Assert::AreEqual(std::string(), resolve_error(topology, L"0-6"));
+        }
+
+        TEST_METHOD(TEST_SELECTORS_SKIP_OFFLINE_CPUS)
+        {
+            const cpu_topology topology = cpu_topology::read_sysfs(make_sysfs_tree("wperf-topology-offline"));
+            Assert::IsTrue(std::vector<unsigned>{ 0, 1, 2, 3, 4, 5, 6 } == resolve(topology, L"all"));
+            Assert::IsTrue(std::vector<unsigned>{ 4, 5, 6 } == resolve(topology, L"node1"));
+            Assert::IsTrue(std::vector<unsigned>{ 4, 5, 6 } == resolve(topology, L"cache-domain-of:6"));
+            Assert::AreEqual(std::string(), resolve_error(topology, L"all,node1"));
+            // an explicit index still has to be online, and a group with nothing online is reported
+            Assert::AreNotEqual(std::string::npos, resolve_error(topology, L"node1,7").find("core 7 is offline"));
+            Assert::AreNotEqual(std::string::npos, resolve_error(topology, L"smt-siblings-of:7").find("smt-siblings-of:7 has no online cores"));
+        }
+
+        TEST_METHOD(TEST_CACHED_PER_ROOT)
+        {
+            const std::filesystem::path root = make_sysfs_tree("wperf-topology-cached");
+            const cpu_topology& first = cpu_topology::cached(root);
+            write_file(root / "devices" / "system" / "cpu" / "online", "0");
+            const cpu_topology& second = cpu_topology::cached(root);
+            Assert::IsTrue(&first == &second);
+            Assert::IsTrue(second.is_online(6));
+        }
+
+        TEST_METHOD(TEST_MISSING_ROOT)
+        {
+            const cpu_topology topology = cpu_topology::read_sysfs(std::filesystem::temp_directory_path() / "wperf-topology-missing");
+            Assert::IsTrue(topology.get_cpus().empty());
+            Assert::AreNotEqual(std::string::npos, resolve_error(topology, L"0").find("0 does not exist"));
+        }
+
+        TEST_METHOD(TEST_HOST_HAS_AN_ONLINE_CPU)
+        {
+            const cpu_topology& topology = cpu_topology::host();
+            Assert::IsTrue(topology.is_online(resolve(topology, L"online").front()));
+            Assert::IsTrue(&topology == &cpu_topology::host());
+        }
+
+        TEST_METHOD(TEST_NO_CORES_GIVEN)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-e", L"ld_spec" };
+            arg_parser parser;
+            parser.parse(4, argv);
+            Assert::IsTrue(parser.resolve_cores(cpu_topology()).empty());
+        }
+    };
+}
@@ -0,0 +1,180 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "parser/arg-parser.h"
+#include "parser/arg-parser-utf8.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParser;
+
+namespace arg_parser_utf8_tests
+{
+    TEST_CLASS(ArgParserUtf8Tests)
+    {
+    public:
+        TEST_METHOD(TEST_ROUND_TRIP_ASCII_AND_NON_ASCII)
+        {
+            // ASCII long enough for the vector path, then 2, 3 and 4 byte sequences straddling a block boundary
+            const std::wstring wide = L"C:\\Users\\perf\\traces\\caf\u00e9-\u6027\u80fd-\U0001F680.json";
+            const std::string utf8 = "C:\\Users\\perf\\traces\\caf\xC3\xA9-\xE6\x80\xA7\xE8\x83\xBD-\xF0\x9F\x9A\x80.json";
+
+            Assert::IsTrue(wide_to_utf8(wide) == utf8);
+            Assert::IsTrue(utf8_to_wide(utf8) == wide);
+        }
+
+        TEST_METHOD(TEST_ROUND_TRIP_EVERY_LENGTH)
+        {
+            for (size_t length = 0; length < 70; ++length)
+            {
+                std::wstring wide;
+                for (size_t i = 0; i < length; ++i)
+                    wide += (i % 23 == 22) ? L'\u00e9' : static_cast<wchar_t>(L'a' + i % 26);
+                Assert::IsTrue(utf8_to_wide(wide_to_utf8(wide)) == wide);
+            }
+        }
+
+        TEST_METHOD(TEST_REJECT_MALFORMED_UTF8)
+        {
+            const char* malformed[] = {
+                "\xC0\x80",             // overlong NUL
+                "\xED\xA0\x80",         // encoded surrogate
+                "\xF4\x90\x80\x80",     // above U+10FFFF
+                "abc\xE6\x80",          // truncated
+                "\x80",                 // stray continuation byte
+                "\xFF"
+            };
+            for (const char* input : malformed)
+            {
+                std::wstring out;
+                Assert::IsFalse(utf8_to_wide(input, out));
+                Assert::ExpectException<std::invalid_argument>([input]() { utf8_to_wide(std::string_view(input)); });
+            }
+        }
+
+        TEST_METHOD(TEST_REPLACE_MALFORMED)
+        {
+            std::wstring wide;
+            Assert::IsFalse(utf8_to_wide("a\xFF" "b", wide, true));
+            Assert::IsTrue(wide == L"a\uFFFDb");
+
+            std::string utf8;
+            const wchar_t lone_surrogate[] = { L'a', static_cast<wchar_t>(0xD800), L'b', 0 };
+            Assert::IsFalse(wide_to_utf8(lone_surrogate, utf8, true));
+            Assert::IsTrue(utf8 == "a\xEF\xBF\xBD" "b");
+        }
+
+        TEST_METHOD(TEST_PARSE_UTF8_ARGV)
+        {
+            arg_parser parser;
+            const char* argv[] = { "wperf", "record", "-e", "ld_spec", "--pe_file", "C:\\caf\xC3\xA9\\app.exe", "--", "app.exe" };
+            parser.parse(8, argv);
+
+            Assert::IsTrue(parser.m_command == COMMAND_CLASS::RECORD);
+            Assert::IsTrue(parser.pe_file_arg.get_values().front() == L"C:\\caf\u00e9\\app.exe");
+        }
+
+        TEST_METHOD(TEST_PARSE_MALFORMED_UTF8_ARGV)
+        {
+            arg_parser parser;
+            const char* argv[] = { "wperf", "stat", "-e", "ld\xFF" };
+            Assert::ExpectException<std::invalid_argument>([&]() { parser.parse(4, argv); });
+        }
+
+        TEST_METHOD(TEST_WRITER_EMITS_UTF8)
+        {
+            FILE* file = std::tmpfile();
+            Assert::IsNotNull(file);
+            {
+                utf8_writer writer(file);
+                writer << L"caf\u00e9 " << std::string_view("ok") << L"\n";
+            }
+            std::rewind(file);
+            char buffer[32] = {};
+            const size_t size = std::fread(buffer, 1, sizeof(buffer), file);
+            std::fclose(file);
+            Assert::IsTrue(std::string(buffer, size) == "caf\xC3\xA9 ok\n");
+        }
+    };
+
+    TEST_CLASS(ArgParserUtf8Benchmark)
+    {
+    public:
+        static void bench(const char* name, const std::wstring& wide)
+        {
+            const std::string utf8 = wide_to_utf8(wide);
+            std::string narrow_out;
+            std::wstring wide_out;
+            const size_t iterations = 200;
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                narrow_out.clear();
+                wide_to_utf8(wide, narrow_out);
+            }
+            auto encode = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (size_t iteration = 0; iteration < iterations; ++iteration)
+            {
+                wide_out.clear();
+                utf8_to_wide(utf8, wide_out);
+            }
+            auto decode = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const double megabytes = iterations * utf8.size() / (1024.0 * 1024.0);
+            std::string message = std::string("utf8 ") + name + ": encode " + std::to_string(static_cast<long long>(megabytes / encode))
+                + " MB/s, decode " + std::to_string(static_cast<long long>(megabytes / decode)) + " MB/s";
+            Logger::WriteMessage(message.c_str());
+            Assert::IsTrue(wide_out == wide && narrow_out == utf8);
+        }
+
+        TEST_METHOD(BENCH_TRANSCODE_ASCII)
+        {
+            std::wstring wide;
+            while (wide.size() < 256 * 1024) wide += L"C:\\Windows\\System32\\ntoskrnl.exe,inst_spec,ld_spec,";
+            bench("ascii", wide);
+        }
+
+        TEST_METHOD(BENCH_TRANSCODE_NON_ASCII)
+        {
+            std::wstring wide;
+            while (wide.size() < 256 * 1024) wide += L"D:\\\u30c8\u30ec\u30fc\u30b9\\caf\u00e9\\\u6027\u80fd.json,";
+            bench("non-ascii", wide);
+        }
+    };
+}
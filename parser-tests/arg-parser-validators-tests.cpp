@@ -0,0 +1,186 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <array>
+#include <cstring>
+#include "parser/arg-parser.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace ArgParserArg;
+using namespace ArgParserArg::validators;
+
+namespace arg_parser_validators_tests
+{
+    constexpr std::array<std::wstring_view, 3> k_modes = { L"fast", L"slow", L"auto" };
+
+    template <class Validator>
+    bool accepts(const wchar_t* value)
+    {
+        validation_error error;
+        return Validator::check(value, error);
+    }
+
+    template <class Validator>
+    const char* rejected_by(const wchar_t* value)
+    {
+        validation_error error;
+        if (Validator::check(value, error)) return "";
+        return error.m_validator;
+    }
+
+    TEST_CLASS(ArgParserValidatorsTests)
+    {
+    public:
+        TEST_METHOD(TestIsUint)
+        {
+            Assert::IsTrue(accepts<is_uint>(L"0"));
+            Assert::IsTrue(accepts<is_uint>(L"18446744073709551615"));
+            Assert::IsFalse(accepts<is_uint>(L"18446744073709551616"));
+            Assert::IsFalse(accepts<is_uint>(L""));
+            Assert::IsFalse(accepts<is_uint>(L"-1"));
+            Assert::IsFalse(accepts<is_uint>(L"12a"));
+        }
+
+        TEST_METHOD(TestInRange)
+        {
+            Assert::IsTrue(accepts<in_range<1, 1'000'000>>(L"1"));
+            Assert::IsTrue(accepts<in_range<1, 1'000'000>>(L"1000000"));
+            Assert::IsFalse(accepts<in_range<1, 1'000'000>>(L"0"));
+            Assert::IsFalse(accepts<in_range<1, 1'000'000>>(L"1000001"));
+        }
+
+        TEST_METHOD(TestOneOf)
+        {
+            Assert::IsTrue(accepts<one_of<k_modes>>(L"slow"));
+            Assert::IsFalse(accepts<one_of<k_modes>>(L"Slow"));
+        }
+
+        TEST_METHOD(TestIsDuration)
+        {
+            Assert::IsTrue(accepts<is_duration>(L"5"));
+            Assert::IsTrue(accepts<is_duration>(L"2m"));
+            Assert::IsTrue(accepts<is_duration>(L"10.5"));
+            Assert::IsTrue(accepts<is_duration>(L"0.25ms"));
+            Assert::IsTrue(accepts<is_duration>(L"1d"));
+            Assert::IsFalse(accepts<is_duration>(L"1.234"));
+            Assert::IsFalse(accepts<is_duration>(L"5."));
+            Assert::IsFalse(accepts<is_duration>(L"ms"));
+            Assert::IsFalse(accepts<is_duration>(L"3w"));
+        }
+
+        TEST_METHOD(TestIsCoreList)
+        {
+            Assert::IsTrue(accepts<is_core_list>(L"0"));
+            Assert::IsTrue(accepts<is_core_list>(L"0,2-5,7"));
+            Assert::IsFalse(accepts<is_core_list>(L"0,"));
+            Assert::IsFalse(accepts<is_core_list>(L"2-"));
+            Assert::IsFalse(accepts<is_core_list>(L"a"));
+            Assert::IsTrue(accepts<is_core_list>(L"all"));
+            Assert::IsTrue(accepts<is_core_list>(L"0-3,node1,cluster12,smt-siblings-of:5,cache-domain-of:7,online"));
+            Assert::IsFalse(accepts<is_core_list>(L"node"));
+            Assert::IsFalse(accepts<is_core_list>(L"alls"));
+            Assert::IsFalse(accepts<is_core_list>(L"node1-3"));
+            Assert::IsFalse(accepts<is_core_list>(L"0-node1"));
+            Assert::IsFalse(accepts<is_core_list>(L"smt-siblings-of:"));
+        }
+
+        TEST_METHOD(TestIsPathShape)
+        {
+            Assert::IsTrue(accepts<is_path_shape>(L"C:\\Program\\sample.exe"));
+            Assert::IsTrue(accepts<is_path_shape>(L"out\\_output_02.json"));
+            Assert::IsFalse(accepts<is_path_shape>(L""));
+            Assert::IsFalse(accepts<is_path_shape>(L"C:\\a|b"));
+            Assert::IsTrue(accepts<is_path_shape>(L"\\\\?\\C:\\very\\long\\out.json"));
+            Assert::IsTrue(accepts<is_path_shape>(L"\\\\?\\UNC\\server\\share\\out.csv"));
+            Assert::IsTrue(accepts<is_path_shape>(L"\\\\.\\pipe\\wperf"));
+            Assert::IsFalse(accepts<is_path_shape>(L"\\\\?\\C:\\a?b"));
+#ifdef _WIN32
+            Assert::IsFalse(accepts<is_path_shape>(L"dir\\C:file"));
+            Assert::IsFalse(accepts<is_path_shape>(L"\\\\?\\dir\\C:file"));
+#else
+            Assert::IsTrue(accepts<is_path_shape>(L"runs/12:30.csv"));
+#endif
+        }
+
+        TEST_METHOD(TestCompositionReportsFailingValidator)
+        {
+            typedef validators::all_of<is_uint, in_range<1, 100>> row_count;
+            Assert::AreEqual(0, std::strcmp("", rejected_by<row_count>(L"50")));
+            Assert::AreEqual(0, std::strcmp("is_uint", rejected_by<row_count>(L"x")));
+            Assert::AreEqual(0, std::strcmp("in_range", rejected_by<row_count>(L"101")));
+
+            typedef validators::any_of<is_uint, one_of<k_modes>> uint_or_mode;
+            Assert::IsTrue(accepts<uint_or_mode>(L"12"));
+            Assert::IsTrue(accepts<uint_or_mode>(L"auto"));
+            Assert::AreEqual(0, std::strcmp("one_of", rejected_by<uint_or_mode>(L"never")));
+        }
+
+        TEST_METHOD(TestArgValidatorRejectsValue)
+        {
+            arg_parser_arg arg(L"--rows", {}, L"Test argument", {}, 1);
+            arg.set_validator<validators::all_of<is_uint, in_range<1, 100>>>();
+            Assert::IsTrue(arg.parse({ L"--rows", L"10" }));
+            try
+            {
+                arg.parse({ L"--rows", L"1000" });
+                Assert::Fail();
+            }
+            catch (const std::invalid_argument& err)
+            {
+                Assert::IsTrue(std::strstr(err.what(), "in_range") != nullptr);
+            }
+            Assert::AreEqual(size_t(1), arg.get_values().size());
+        }
+
+        TEST_METHOD(TestParserRejectsInvalidTimeout)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"--timeout", L"soon" };
+            int argc = 4;
+            ArgParser::arg_parser parser;
+            Assert::ExpectException<std::invalid_argument>([&parser, argc, &argv]() {
+                parser.parse(argc, argv);
+                }
+            );
+        }
+
+        TEST_METHOD(TestParserTimelineCountFlag)
+        {
+            const wchar_t* argv[] = { L"wperf", L"stat", L"-t", L"-i", L"2", L"-n", L"3" };
+            int argc = 7;
+            ArgParser::arg_parser parser;
+            parser.parse(argc, argv);
+            Assert::IsTrue(parser.interval_arg.get_values().front() == L"2");
+            Assert::IsTrue(parser.iteration_arg.get_values().front() == L"3");
+        }
+    };
+}
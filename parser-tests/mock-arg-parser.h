@@ -3,7 +3,7 @@
 #include <unordered_set>
 #include <string>
 
-class mock_arg_parser : public arg_parser
+class mock_arg_parser : public ArgParser::arg_parser
 {
 public:
     // Map to simulate existing files
@@ -11,4 +11,10 @@ public:
         L"C:\\Program\\sample.exe",
         L"C:\\Program\\sample.pdb"
     };
+
+    // Path probe for validate_paths that only knows about existing_files
+    bool file_exists(const std::wstring& path) const
+    {
+        return existing_files.count(path) > 0;
+    }
 };
@@ -1,14 +1,18 @@
 #include "arg-parser-arg.h"
+#include "arg-parser-stats.h"
+#include "arg-parser-utf8.h"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 namespace ArgParserArg {
     arg_parser_arg::arg_parser_arg(
-        const std::wstring name,
-        const std::vector<std::wstring> alias,
-        const std::wstring description,
-        const std::vector<std::wstring> default_values,
+        std::wstring name,
+        std::vector<std::wstring> alias,
+        std::wstring description,
+        std::vector<std::wstring> default_values,
         const int arg_count
-    ) : m_name(name), m_aliases(alias), m_description(description), m_arg_count(arg_count), m_values(default_values) {};
+    ) : m_name(std::move(name)), m_aliases(std::move(alias)), m_description(std::move(description)), m_arg_count(arg_count), m_is_variadic(arg_count == -1), m_values(default_values), m_default_values(std::move(default_values)) {};
 
     inline bool arg_parser_arg::operator==(const std::wstring& other_arg) const
     {
@@ -37,9 +41,9 @@ namespace ArgParserArg {
         return m_description;
     }
 
-    arg_parser_arg arg_parser_arg::add_alias(std::wstring new_alias)
+    arg_parser_arg& arg_parser_arg::add_alias(std::wstring new_alias)
     {
-        m_aliases.push_back(new_alias);
+        m_aliases.push_back(std::move(new_alias));
         return *this;
     }
 
@@ -66,9 +70,9 @@ namespace ArgParserArg {
         return alias_string;
     }
 
-    arg_parser_arg arg_parser_arg::add_check_func(std::function<bool(const std::wstring&)> check_func)
+    arg_parser_arg& arg_parser_arg::add_check_func(std::function<bool(const std::wstring&)> check_func)
     {
-        m_check_funcs.push_back(check_func);
+        m_check_funcs.push_back(std::move(check_func));
         return *this;
     }
 
@@ -77,29 +81,43 @@ namespace ArgParserArg {
         m_is_parsed = true;
     }
 
-    bool arg_parser_arg::is_parsed()
+    bool arg_parser_arg::is_parsed() const
     {
         return m_is_parsed;
     }
 
-    bool arg_parser_arg::is_set()
+    bool arg_parser_arg::is_set() const
     {
-        return is_parsed() && m_values.size() == m_arg_count;
+        // through get_value_count, the passthrough keeps its values out of m_values
+        return is_parsed() && get_value_count() == static_cast<size_t>(m_arg_count);
     }
 
-    std::vector<std::wstring> arg_parser_arg::get_values()
+    const std::vector<std::wstring>& arg_parser_arg::get_values() const
     {
         return m_values;
     }
 
-    bool arg_parser_arg::parse(std::vector<std::wstring> arg_vect)
+    size_t arg_parser_arg::get_value_count() const
     {
-        if (arg_vect.size() == 0 || !is_match(arg_vect[0]))
+        return m_values.size();
+    }
+
+    const std::wstring& arg_parser_arg::get_value(size_t index) const
+    {
+        return m_values[index];
+    }
+
+    bool arg_parser_arg::parse(const std::vector<std::wstring>& arg_vect, size_t start)
+    {
+        // arg_vect[start] is the flag itself, its values (if any) follow it
+        if (start >= arg_vect.size() || !is_match(arg_vect[start]))
             return false;
+        m_is_implied = false;
 
-        if (m_arg_count == -1 && arg_vect.size() > 0) m_arg_count = arg_vect.size() - 1;
+        const size_t available = arg_vect.size() - start - 1;
+        if (m_arg_count == -1) m_arg_count = static_cast<int>(available);
 
-        if (arg_vect.size() < m_arg_count + 1)
+        if (available < static_cast<size_t>(m_arg_count))
             throw std::invalid_argument("Not enough arguments provided.");
 
         if (m_arg_count == 0)
@@ -108,52 +126,230 @@ namespace ArgParserArg {
             return true;
         }
 
-        for (int i = 1; i < m_arg_count + 1; ++i)
+        if (m_validator != nullptr)
+        {
+            validation_error error;
+            size_t failed_index = 0;
+            ARG_PARSER_STATS_ADD(*this, m_check_call_count, 1);
+            if (!m_validator(&arg_vect[start + 1], m_arg_count, error, failed_index))
+                throw std::invalid_argument(std::string("Invalid arguments provided: ") + error.m_validator + " rejected the value (" + error.m_reason + ").");
+        }
+
+        // the first explicit value replaces the defaults, repeated flags accumulate
+        if (!m_is_parsed) m_values.clear();
+        // exact reservations on every repeat of a flag would defeat geometric growth and make
+        // repeated flags quadratic, so only the first occurrence reserves
+        if (m_values.empty()) m_values.reserve(m_arg_count);
+        const size_t first_new = m_values.size();
+        for (size_t i = start + 1; i < start + m_arg_count + 1; ++i)
         {
             for (auto& check_func : m_check_funcs)
             {
+                ARG_PARSER_STATS_ADD(*this, m_check_call_count, 1);
                 if (!check_func(arg_vect[i]))
                     throw std::invalid_argument("Invalid arguments provided.");
             }
             m_values.push_back(arg_vect[i]);
         }
+        if (m_uint_values)
+        {
+            // numeric flags are converted once here so readers only hit the cache; a repeated flag only
+            // converts its new values, re-converting everything on each repeat would be quadratic
+            m_typed_valid &= (1u << typed_index<long long>()) | (1u << typed_index<int>());
+            convert_typed_values<long long>(first_new);
+            convert_typed_values<int>(first_new);
+        }
+        else
+        {
+            reset_typed_values();
+        }
         set_is_parsed();
         return true;
     }
 
+    void arg_parser_arg::reset_typed_values() const
+    {
+        m_typed_valid = 0;
+    }
+
+    void arg_parser_arg::reset()
+    {
+        m_values = m_default_values;
+        m_is_parsed = false;
+        m_is_implied = false;
+        if (m_is_variadic) m_arg_count = -1;
+        reset_typed_values();
+    }
+
+
+    bool arg_parser_arg_passthrough::parse(const std::vector<std::wstring>& arg_vect, size_t start)
+    {
+        if (start >= arg_vect.size() || !is_match(arg_vect[start]))
+            return false;
+
+        m_count = arg_vect.size() - start - 1;
+        m_first = m_count > 0 ? &arg_vect[start + 1] : nullptr;
+        m_arg_count = static_cast<int>(m_count);
+        m_is_materialized = false;
+        m_materialized.clear();
+        reset_typed_values();
+
+        size_t command_line_size = 0;
+        for (size_t i = 0; i < m_count; ++i)
+            command_line_size += m_first[i].size() + 3;
+        m_command_line.clear();
+        m_command_line.reserve(command_line_size);
+        m_argv_storage.clear();
+        m_argv_storage.reserve(command_line_size);
+
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            if (i > 0) m_command_line.push_back(L' ');
+            append_quoted_arg(m_command_line, m_first[i]);
+
+            ArgParser::wide_to_utf8(m_first[i], m_argv_storage, true);
+            m_argv_storage.push_back('\0');
+        }
+
+        // pointers are taken once m_argv_storage can no longer reallocate; tokens never contain NUL
+        m_argv.assign(m_count + 1, nullptr);
+        char* arg = m_count > 0 ? &m_argv_storage[0] : nullptr;
+        for (size_t i = 0; i < m_count; ++i)
+        {
+            m_argv[i] = arg;
+            arg += std::strlen(arg) + 1;
+        }
+
+        set_is_parsed();
+        return true;
+    }
+
+    void arg_parser_arg_passthrough::reset()
+    {
+        arg_parser_arg_pos::reset();
+        m_first = nullptr;
+        m_count = 0;
+        m_command_line.clear();
+        m_argv_storage.clear();
+        m_argv.assign(1, nullptr);
+        m_materialized.clear();
+        m_is_materialized = false;
+    }
+
+    const std::vector<std::wstring>& arg_parser_arg_passthrough::get_values() const
+    {
+        if (!m_is_materialized)
+        {
+            m_materialized.assign(m_first, m_first + m_count);
+            m_is_materialized = true;
+        }
+        return m_materialized;
+    }
+
+    size_t arg_parser_arg_passthrough::get_value_count() const
+    {
+        return m_count;
+    }
+
+    const std::wstring& arg_parser_arg_passthrough::get_value(size_t index) const
+    {
+        return m_first[index];
+    }
+
+    const std::wstring& arg_parser_arg_passthrough::get_command_line() const
+    {
+        return m_command_line;
+    }
+
+    char* const* arg_parser_arg_passthrough::get_argv() const
+    {
+        return m_argv.data();
+    }
+
+    void append_quoted_arg(std::wstring& command_line, const std::wstring& arg)
+    {
+        if (!arg.empty() && arg.find_first_of(L" \t\n\v\"") == std::wstring::npos)
+        {
+            command_line.append(arg);
+            return;
+        }
+
+        // backslashes are only special in front of a quote, including the closing one
+        command_line.push_back(L'"');
+        size_t backslashes = 0;
+        for (wchar_t c : arg)
+        {
+            if (c == L'\\')
+            {
+                ++backslashes;
+                continue;
+            }
+            if (c == L'"')
+                command_line.append(backslashes * 2 + 1, L'\\');
+            else
+                command_line.append(backslashes, L'\\');
+            backslashes = 0;
+            command_line.push_back(c);
+        }
+        command_line.append(backslashes * 2, L'\\');
+        command_line.push_back(L'"');
+    }
+
+    namespace {
+        // Calls on_line for every '\n' terminated line like std::getline does: a trailing '\n' does
+        // not start another, empty line. Splitting by hand keeps locale-aware streams out of help.
+        template <class OnLine>
+        void for_each_line(std::wstring_view str, OnLine on_line)
+        {
+            size_t position = 0;
+            while (position < str.size())
+            {
+                const size_t end = (std::min)(str.find(L'\n', position), str.size());
+                on_line(str.substr(position, end - position));
+                position = end + 1;
+            }
+        }
+
+        // the characters `>>` skips in the classic locale
+        bool is_word_separator(wchar_t c)
+        {
+            return c == L' ' || c == L'\t' || c == L'\n' || c == L'\v' || c == L'\f' || c == L'\r';
+        }
+    }
 
     std::wstring arg_parser_add_wstring_behind_multiline_text(const std::wstring& str, const std::wstring& prefix)
     {
         std::wstring formatted_str;
-        std::wstring current_line;
-        std::wistringstream iss(str);
-        while (getline(iss, current_line, L'\n'))
-        {
+        for_each_line(str, [&](std::wstring_view current_line) {
             if (current_line.empty())
             {
                 formatted_str += L"\n";
-                continue;
+                return;
             }
 
-            formatted_str += prefix + current_line + L"\n";
-        }
+            formatted_str += prefix;
+            formatted_str += current_line;
+            formatted_str += L"\n";
+        });
         return formatted_str;
     }
 
     std::wstring arg_parser_format_string_to_length(const std::wstring& str, size_t max_width)
     {
         std::wstring formatted_str;
-        std::wistringstream lines_stream(str);
-        std::wstring line;
 
-        while (std::getline(lines_stream, line, L'\n'))
-        {
+        for_each_line(str, [&](std::wstring_view line) {
             std::wstring current_line;
-            std::wistringstream word_stream(line);
-            std::wstring word;
+            size_t position = 0;
 
-            while (word_stream >> word)
+            while (true)
             {
+                while (position < line.size() && is_word_separator(line[position])) ++position;
+                if (position == line.size()) break;
+                const size_t word_begin = position;
+                while (position < line.size() && !is_word_separator(line[position])) ++position;
+                const std::wstring_view word = line.substr(word_begin, position - word_begin);
+
                 if (current_line.size() + word.size() > max_width && !current_line.empty())
                 {
                     if (!current_line.empty() && current_line.back() == L' ')
@@ -161,11 +357,13 @@ namespace ArgParserArg {
                         current_line.pop_back();
                     }
                     formatted_str += current_line + L"\n";
-                    current_line = word + L" ";
+                    current_line.assign(word);
+                    current_line += L' ';
                 }
                 else
                 {
-                    current_line += word + L" ";
+                    current_line += word;
+                    current_line += L' ';
                 }
             }
             if (!current_line.empty() && current_line.back() == L' ')
@@ -176,10 +374,10 @@ namespace ArgParserArg {
             {
                 formatted_str += current_line + L"\n\n";
             }
-        }
+        });
 
-        // Remove the trailing newline, if any
-        if (!formatted_str.empty() && formatted_str.back() == L'\n\n')
+        // Remove the trailing blank line, if any
+        if (!formatted_str.empty() && formatted_str.back() == L'\n')
         {
             formatted_str.pop_back();
             formatted_str.pop_back();
@@ -3,68 +3,282 @@
 #include <vector>
 #include <set>
 #include <functional>
-#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <string_view>
+#include <type_traits>
 #include <string>
+#include "arg-parser-convert.h"
+#include "arg-parser-validators.h"
 
 namespace ArgParserArg {
+    typedef bool (*values_validator)(const std::wstring* values, size_t count, validation_error& error, size_t& failed_index);
+
     struct arg_parser_arg {
-        const std::wstring m_name;
+        std::wstring m_name;
         std::vector<std::wstring> m_aliases{};
-        const std::wstring m_description;
+        std::wstring m_description;
 
         int m_arg_count; // -1 for variable number of arguments
+        bool m_is_variadic = false; // consumes every remaining token, m_arg_count is set once parsed
         bool m_is_parsed = false;
+        bool m_is_implied = false; // parsed only because a flag_constraints rule implied it
         std::vector<std::wstring> m_values{};
+        std::vector<std::wstring> m_default_values{};
 
         std::vector <std::function<bool(const std::wstring&)>> m_check_funcs = {};
+        values_validator m_validator = nullptr;
+        bool m_uint_values = false; // the validator only accepts unsigned integers
+        unsigned long long m_check_call_count = 0; // only maintained with ARG_PARSER_ENABLE_STATS
+
+        // Converted values for get<T>(), one vector per supported type, valid when its bit is set
+        using typed_values = std::tuple<std::vector<int>, std::vector<long long>, std::vector<double>, std::vector<std::filesystem::path>, std::vector<std::chrono::nanoseconds>>;
+        mutable typed_values m_typed_values;
+        mutable unsigned m_typed_valid = 0;
 
         inline bool operator==(const std::wstring& other) const;
 
     public:
         arg_parser_arg(
-            const std::wstring name,
-            const std::vector<std::wstring> alias,
-            const std::wstring description,
-            const std::vector<std::wstring> default_values = {},
+            std::wstring name,
+            std::vector<std::wstring> alias,
+            std::wstring description,
+            std::vector<std::wstring> default_values = {},
             const int arg_count = 0
         );
+        // plugin_registry and arg_parser own plugin flags through base pointers
+        virtual ~arg_parser_arg() = default;
+        arg_parser_arg(const arg_parser_arg&) = default;
+        arg_parser_arg(arg_parser_arg&&) = default;
+        arg_parser_arg& operator=(const arg_parser_arg&) = default;
+        arg_parser_arg& operator=(arg_parser_arg&&) = default;
         bool is_match(const std::wstring& arg) const;
         virtual std::wstring get_help() const;
         virtual std::wstring get_all_flags_string() const;
         virtual std::wstring get_usage_text() const;
-        arg_parser_arg add_alias(std::wstring new_alias);
+        arg_parser_arg& add_alias(std::wstring new_alias);
         int get_arg_count() const;
         std::wstring get_name() const;
         std::wstring get_alias_string() const;
-        arg_parser_arg add_check_func(std::function<bool(const std::wstring&)> check_func);
+        arg_parser_arg& add_check_func(std::function<bool(const std::wstring&)> check_func);
+        template <class Validator>
+        arg_parser_arg& set_validator()
+        {
+            m_validator = &validate_values<Validator>;
+            m_uint_values = validators::yields_uint<Validator>::value;
+            return *this;
+        }
         void set_is_parsed();
-        bool is_parsed();
-        bool is_set();
-        std::vector<std::wstring> get_values();
-        bool parse(std::vector<std::wstring> arg_vect);
+        bool is_parsed() const;
+        bool is_set() const;
+        virtual const std::vector<std::wstring>& get_values() const;
+        // Indexed access that never materializes values, see arg_parser_arg_passthrough
+        virtual size_t get_value_count() const;
+        virtual const std::wstring& get_value(size_t index) const;
+        virtual bool parse(const std::vector<std::wstring>& arg_vect, size_t start = 0);
+        // Back to the state before the first parse: default values, not parsed, no cached conversions
+        virtual void reset();
+
+        // Typed access to the values: get<T>() is the first value and get<arg_span<const T>>() all
+        // of them, for T one of int, long long, double, std::filesystem::path and
+        // std::chrono::nanoseconds (durations in the is_duration form). Values are
+        // converted once and cached until the flag parses again; flags with an unsigned integer
+        // validator are converted while parsing. Throws std::invalid_argument when a value does
+        // not convert and std::out_of_range when get<T>() finds no value. Not thread-safe.
+        template <class T>
+        T get() const
+        {
+            if constexpr (is_arg_span<T>::value)
+            {
+                using value_type = std::remove_const_t<typename T::element_type>;
+                const std::vector<value_type>& values = get_typed_values<value_type>();
+                return T(values.data(), values.size());
+            }
+            else
+            {
+                const std::vector<T>& values = get_typed_values<T>();
+                if (values.empty())
+                    throw std::out_of_range("No value provided.");
+                return values.front();
+            }
+        }
+
+    protected:
+        template <class T>
+        static constexpr size_t typed_index()
+        {
+            if constexpr (std::is_same_v<T, int>) return 0;
+            else if constexpr (std::is_same_v<T, long long>) return 1;
+            else if constexpr (std::is_same_v<T, double>) return 2;
+            else if constexpr (std::is_same_v<T, std::filesystem::path>) return 3;
+            else
+            {
+                static_assert(std::is_same_v<T, std::chrono::nanoseconds>, "get<T> supports int, long long, double, std::filesystem::path and std::chrono::nanoseconds");
+                return 4;
+            }
+        }
+
+        // Converts the values from first on into the cache for T, starting over when the cache does not already hold
+        // exactly the values before first; leaves the cache invalid and returns false when one does not convert
+        template <class T>
+        bool convert_typed_values(size_t first = 0) const
+        {
+            constexpr size_t index = typed_index<T>();
+            std::vector<T>& values = std::get<index>(m_typed_values);
+            if ((m_typed_valid & (1u << index)) == 0 || values.size() != first) first = 0;
+            m_typed_valid &= ~(1u << index);
+            values.resize(get_value_count());
+            for (size_t i = first; i < values.size(); ++i)
+            {
+                if (!convert_value(get_value(i), values[i])) return false;
+            }
+            m_typed_valid |= 1u << index;
+            return true;
+        }
+
+        template <class T>
+        const std::vector<T>& get_typed_values() const
+        {
+            constexpr size_t index = typed_index<T>();
+            if ((m_typed_valid & (1u << index)) == 0 && !convert_typed_values<T>())
+                throw std::invalid_argument("Invalid arguments provided: value cannot be converted to the requested type.");
+            return std::get<index>(m_typed_values);
+        }
+
+        void reset_typed_values() const;
     };
 
     class arg_parser_arg_opt : public arg_parser_arg {
     public:
         arg_parser_arg_opt(
-            const std::wstring name,
-            const std::vector<std::wstring> alias,
-            const std::wstring description,
-            const std::vector<std::wstring> default_values = {}
-        ) : arg_parser_arg(name, alias, description, default_values, 0) {};
+            std::wstring name,
+            std::vector<std::wstring> alias,
+            std::wstring description,
+            std::vector<std::wstring> default_values = {}
+        ) : arg_parser_arg(std::move(name), std::move(alias), std::move(description), std::move(default_values), 0) {};
     };
 
     class arg_parser_arg_pos : public arg_parser_arg {
     public:
         arg_parser_arg_pos(
-            const std::wstring name,
-            const std::vector<std::wstring> alias,
-            const std::wstring description,
-            const std::vector<std::wstring> default_values = {},
+            std::wstring name,
+            std::vector<std::wstring> alias,
+            std::wstring description,
+            std::vector<std::wstring> default_values = {},
             const int arg_count = 1
-        ) : arg_parser_arg(name, alias, description, default_values, arg_count) {};
+        ) : arg_parser_arg(std::move(name), std::move(alias), std::move(description), std::move(default_values), arg_count) {};
+    };
+
+    // Everything after `--`, kept as a view over the parser's token storage instead of being copied
+    // into m_values. When it is parsed, the child command line is also built once: a Windows command
+    // line quoted for CommandLineToArgvW, and a null-terminated UTF-8 argv for posix_spawn/execve.
+    // The view stays valid until the owning arg_parser parses again.
+    class arg_parser_arg_passthrough : public arg_parser_arg_pos {
+    public:
+        arg_parser_arg_passthrough(
+            std::wstring name,
+            std::vector<std::wstring> alias,
+            std::wstring description
+        ) : arg_parser_arg_pos(std::move(name), std::move(alias), std::move(description), {}, -1) {};
+
+        bool parse(const std::vector<std::wstring>& arg_vect, size_t start = 0) override;
+        void reset() override;
+        // Copies the view into a vector on first use, prefer get_value/get_value_count
+        const std::vector<std::wstring>& get_values() const override;
+        size_t get_value_count() const override;
+        const std::wstring& get_value(size_t index) const override;
+
+        const std::wstring& get_command_line() const;
+        // argv[get_value_count()] is nullptr
+        char* const* get_argv() const;
+
+    private:
+        const std::wstring* m_first = nullptr;
+        size_t m_count = 0;
+        std::wstring m_command_line;
+        std::string m_argv_storage;
+        std::vector<char*> m_argv{ nullptr };
+        mutable std::vector<std::wstring> m_materialized;
+        mutable bool m_is_materialized = false;
     };
 
+    // Declares a flag in place. Setters store into the builder and return it by reference, and
+    // build() moves everything into the flag, so each string is copied once from its wstring_view
+    // however many calls are chained:
+    //
+    //   arg_parser_arg_pos timeout_arg = arg_builder<arg_parser_arg_pos>(L"--timeout")
+    //       .alias(L"sleep").description(L"Counting duration in seconds.").validator<validators::is_duration>().build();
+    template <class Arg = arg_parser_arg>
+    class arg_builder {
+        static_assert(std::is_base_of_v<arg_parser_arg, Arg>, "arg_builder builds arg_parser_arg types");
+
+    public:
+        explicit arg_builder(std::wstring_view name) : m_name(name) {}
+
+        arg_builder& alias(std::wstring_view alias)
+        {
+            m_aliases.emplace_back(alias);
+            return *this;
+        }
+        arg_builder& description(std::wstring_view description)
+        {
+            m_description.assign(description);
+            return *this;
+        }
+        arg_builder& default_value(std::wstring_view value)
+        {
+            m_default_values.emplace_back(value);
+            return *this;
+        }
+        arg_builder& arg_count(int arg_count)
+        {
+            m_arg_count = arg_count;
+            return *this;
+        }
+        arg_builder& check_func(std::function<bool(const std::wstring&)> check_func)
+        {
+            m_check_funcs.push_back(std::move(check_func));
+            return *this;
+        }
+        template <class Validator>
+        arg_builder& validator()
+        {
+            m_apply_validator = [](arg_parser_arg& arg) { arg.set_validator<Validator>(); };
+            return *this;
+        }
+
+        // Moves the collected spec into a new flag; the builder is left empty.
+        Arg build()
+        {
+            Arg arg = construct();
+            arg.m_check_funcs = std::move(m_check_funcs);
+            if (m_apply_validator != nullptr) m_apply_validator(arg);
+            return arg;
+        }
+
+    private:
+        Arg construct()
+        {
+            if constexpr (std::is_same_v<Arg, arg_parser_arg_passthrough>)
+                return Arg(std::move(m_name), std::move(m_aliases), std::move(m_description));
+            else if constexpr (std::is_same_v<Arg, arg_parser_arg_opt>)
+                return Arg(std::move(m_name), std::move(m_aliases), std::move(m_description), std::move(m_default_values));
+            else
+                return Arg(std::move(m_name), std::move(m_aliases), std::move(m_description), std::move(m_default_values), m_arg_count);
+        }
+
+        std::wstring m_name;
+        std::vector<std::wstring> m_aliases;
+        std::wstring m_description;
+        std::vector<std::wstring> m_default_values;
+        int m_arg_count = std::is_same_v<Arg, arg_parser_arg_pos> ? 1 : 0;
+        std::vector<std::function<bool(const std::wstring&)>> m_check_funcs;
+        void (*m_apply_validator)(arg_parser_arg&) = nullptr;
+    };
+
+    // Appends arg quoted so that CommandLineToArgvW and the C runtime parse it back unchanged.
+    void append_quoted_arg(std::wstring& command_line, const std::wstring& arg);
+
     constexpr auto MAX_HELP_WIDTH = 80;
     std::wstring arg_parser_add_wstring_behind_multiline_text(const std::wstring& str, const std::wstring& prefix);
     std::wstring arg_parser_format_string_to_length(const std::wstring& str, size_t max_width = MAX_HELP_WIDTH);
@@ -0,0 +1,401 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-catalogue.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace ArgParser {
+    namespace {
+    #pragma region Tables
+        // Arm architecture common events (PMUv3), see the Arm ARM section D17 "The Performance Monitors Extension".
+        constexpr event_info k_events[] = {
+            { L"sw_incr", 0x00, L"Instruction architecturally executed, Condition code check pass, software increment" },
+            { L"l1i_cache_refill", 0x01, L"Level 1 instruction cache refill" },
+            { L"l1i_tlb_refill", 0x02, L"Level 1 instruction TLB refill" },
+            { L"l1d_cache_refill", 0x03, L"Level 1 data cache refill" },
+            { L"l1d_cache", 0x04, L"Level 1 data cache access" },
+            { L"l1d_tlb_refill", 0x05, L"Level 1 data TLB refill" },
+            { L"ld_retired", 0x06, L"Instruction architecturally executed, Condition code check pass, load" },
+            { L"st_retired", 0x07, L"Instruction architecturally executed, Condition code check pass, store" },
+            { L"inst_retired", 0x08, L"Instruction architecturally executed" },
+            { L"exc_taken", 0x09, L"Exception taken" },
+            { L"exc_return", 0x0A, L"Instruction architecturally executed, Condition code check pass, exception return" },
+            { L"cid_write_retired", 0x0B, L"Instruction architecturally executed, Condition code check pass, write to CONTEXTIDR" },
+            { L"pc_write_retired", 0x0C, L"Instruction architecturally executed, Condition code check pass, software change of the PC" },
+            { L"br_immed_retired", 0x0D, L"Instruction architecturally executed, immediate branch" },
+            { L"br_return_retired", 0x0E, L"Instruction architecturally executed, Condition code check pass, procedure return" },
+            { L"unaligned_ldst_retired", 0x0F, L"Instruction architecturally executed, Condition code check pass, unaligned load or store" },
+            { L"br_mis_pred", 0x10, L"Branch instruction speculatively executed, mispredicted or not predicted" },
+            { L"cpu_cycles", 0x11, L"Cycle" },
+            { L"br_pred", 0x12, L"Predictable branch instruction speculatively executed" },
+            { L"mem_access", 0x13, L"Data memory access" },
+            { L"l1i_cache", 0x14, L"Level 1 instruction cache access" },
+            { L"l1d_cache_wb", 0x15, L"Level 1 data cache write-back" },
+            { L"l2d_cache", 0x16, L"Level 2 data cache access" },
+            { L"l2d_cache_refill", 0x17, L"Level 2 data cache refill" },
+            { L"l2d_cache_wb", 0x18, L"Level 2 data cache write-back" },
+            { L"bus_access", 0x19, L"Bus access" },
+            { L"memory_error", 0x1A, L"Local memory error" },
+            { L"inst_spec", 0x1B, L"Operation speculatively executed" },
+            { L"ttbr_write_retired", 0x1C, L"Instruction architecturally executed, Condition code check pass, write to TTBR" },
+            { L"bus_cycles", 0x1D, L"Bus cycle" },
+            { L"chain", 0x1E, L"Chain a pair of event counters" },
+            { L"l1d_cache_allocate", 0x1F, L"Level 1 data cache allocation without refill" },
+            { L"l2d_cache_allocate", 0x20, L"Level 2 data cache allocation without refill" },
+            { L"br_retired", 0x21, L"Instruction architecturally executed, branch" },
+            { L"br_mis_pred_retired", 0x22, L"Branch instruction architecturally executed, mispredicted" },
+            { L"stall_frontend", 0x23, L"No operation sent for execution due to the frontend" },
+            { L"stall_backend", 0x24, L"No operation sent for execution due to the backend" },
+            { L"l1d_tlb", 0x25, L"Level 1 data TLB access" },
+            { L"l1i_tlb", 0x26, L"Level 1 instruction TLB access" },
+            { L"l2i_cache", 0x27, L"Level 2 instruction cache access" },
+            { L"l2i_cache_refill", 0x28, L"Level 2 instruction cache refill" },
+            { L"l3d_cache_allocate", 0x29, L"Level 3 data cache allocation without refill" },
+            { L"l3d_cache_refill", 0x2A, L"Level 3 data cache refill" },
+            { L"l3d_cache", 0x2B, L"Level 3 data cache access" },
+            { L"l3d_cache_wb", 0x2C, L"Level 3 data cache write-back" },
+            { L"l2d_tlb_refill", 0x2D, L"Level 2 data TLB refill" },
+            { L"l2i_tlb_refill", 0x2E, L"Level 2 instruction TLB refill" },
+            { L"l2d_tlb", 0x2F, L"Level 2 data TLB access" },
+            { L"l2i_tlb", 0x30, L"Level 2 instruction TLB access" },
+            { L"remote_access", 0x31, L"Access to another socket in a multi-socket system" },
+            { L"ll_cache", 0x32, L"Last level cache access" },
+            { L"ll_cache_miss", 0x33, L"Last level cache miss" },
+            { L"dtlb_walk", 0x34, L"Data TLB access with at least one translation table walk" },
+            { L"itlb_walk", 0x35, L"Instruction TLB access with at least one translation table walk" },
+            { L"ll_cache_rd", 0x36, L"Last level cache access, read" },
+            { L"ll_cache_miss_rd", 0x37, L"Last level cache miss, read" },
+            { L"remote_access_rd", 0x38, L"Access to another socket in a multi-socket system, read" },
+            { L"l1d_cache_lmiss_rd", 0x39, L"Level 1 data cache long-latency read miss" },
+            { L"op_retired", 0x3A, L"Micro-operation architecturally executed" },
+            { L"op_spec", 0x3B, L"Micro-operation speculatively executed" },
+            { L"stall", 0x3C, L"No operation sent for execution" },
+            { L"stall_slot_backend", 0x3D, L"No operation sent for execution on a slot due to the backend" },
+            { L"stall_slot_frontend", 0x3E, L"No operation sent for execution on a slot due to the frontend" },
+            { L"stall_slot", 0x3F, L"No operation sent for execution on a slot" },
+            { L"l1d_cache_rd", 0x40, L"Level 1 data cache access, read" },
+            { L"l1d_cache_wr", 0x41, L"Level 1 data cache access, write" },
+            { L"l1d_cache_refill_rd", 0x42, L"Level 1 data cache refill, read" },
+            { L"l1d_cache_refill_wr", 0x43, L"Level 1 data cache refill, write" },
+            { L"l2d_cache_rd", 0x50, L"Level 2 data cache access, read" },
+            { L"l2d_cache_wr", 0x51, L"Level 2 data cache access, write" },
+            { L"l2d_cache_refill_rd", 0x52, L"Level 2 data cache refill, read" },
+            { L"l2d_cache_refill_wr", 0x53, L"Level 2 data cache refill, write" },
+            { L"bus_access_rd", 0x60, L"Bus access, read" },
+            { L"bus_access_wr", 0x61, L"Bus access, write" },
+            { L"mem_access_rd", 0x66, L"Data memory access, read" },
+            { L"mem_access_wr", 0x67, L"Data memory access, write" },
+            { L"unaligned_ld_spec", 0x68, L"Unaligned access, read" },
+            { L"unaligned_st_spec", 0x69, L"Unaligned access, write" },
+            { L"unaligned_ldst_spec", 0x6A, L"Unaligned access" },
+            { L"ldrex_spec", 0x6C, L"Exclusive operation speculatively executed, Load-Exclusive" },
+            { L"strex_pass_spec", 0x6D, L"Exclusive operation speculatively executed, Store-Exclusive pass" },
+            { L"strex_fail_spec", 0x6E, L"Exclusive operation speculatively executed, Store-Exclusive fail" },
+            { L"strex_spec", 0x6F, L"Exclusive operation speculatively executed, Store-Exclusive" },
+            { L"ld_spec", 0x70, L"Operation speculatively executed, load" },
+            { L"st_spec", 0x71, L"Operation speculatively executed, store" },
+            { L"ldst_spec", 0x72, L"Operation speculatively executed, load or store" },
+            { L"dp_spec", 0x73, L"Operation speculatively executed, integer data processing" },
+            { L"ase_spec", 0x74, L"Operation speculatively executed, Advanced SIMD" },
+            { L"vfp_spec", 0x75, L"Operation speculatively executed, scalar floating-point" },
+            { L"pc_write_spec", 0x76, L"Operation speculatively executed, software change of the PC" },
+            { L"crypto_spec", 0x77, L"Operation speculatively executed, Cryptographic instruction" },
+            { L"br_immed_spec", 0x78, L"Branch speculatively executed, immediate branch" },
+            { L"br_return_spec", 0x79, L"Branch speculatively executed, procedure return" },
+            { L"br_indirect_spec", 0x7A, L"Branch speculatively executed, indirect branch" },
+            { L"isb_spec", 0x7C, L"Barrier speculatively executed, ISB" },
+            { L"dsb_spec", 0x7D, L"Barrier speculatively executed, DSB" },
+            { L"dmb_spec", 0x7E, L"Barrier speculatively executed, DMB" }
+        };
+
+        constexpr metric_info k_metrics[] = {
+            { L"imix", L"inst_spec,dp_spec,vfp_spec,ase_spec,ld_spec,st_spec", L"Instruction mix: integer, floating-point, SIMD, load and store operations" },
+            { L"ipc", L"inst_retired,cpu_cycles", L"Instructions retired per cycle" },
+            { L"icache", L"l1i_cache,l1i_cache_refill", L"Level 1 instruction cache refill rate" },
+            { L"dcache", L"l1d_cache,l1d_cache_refill", L"Level 1 data cache refill rate" },
+            { L"l2cache", L"l2d_cache,l2d_cache_refill", L"Level 2 data cache refill rate" },
+            { L"l3cache", L"l3d_cache,l3d_cache_refill", L"Level 3 data cache refill rate" },
+            { L"itlb", L"l1i_tlb,l1i_tlb_refill", L"Level 1 instruction TLB refill rate" },
+            { L"dtlb", L"l1d_tlb,l1d_tlb_refill", L"Level 1 data TLB refill rate" },
+            { L"branch", L"br_retired,br_mis_pred_retired", L"Branch misprediction rate" },
+            { L"stalls", L"cpu_cycles,stall_frontend,stall_backend", L"Cycles stalled in the frontend and in the backend" }
+        };
+    #pragma endregion
+
+    #pragma region Perfect hash
+        // CHD ("compress, hash and displace"): keys are first hashed into buckets, then buckets are
+        // placed largest first, each with the first seed that sends all its keys to free slots.
+        // A lookup is two hashes and one string compare.
+        constexpr std::uint64_t chd_hash(std::wstring_view key, std::uint64_t seed)
+        {
+            std::uint64_t hash = 0xcbf29ce484222325ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+            for (wchar_t c : key)
+            {
+                hash ^= static_cast<std::uint64_t>(c);
+                hash *= 0x100000001b3ULL;
+            }
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        constexpr size_t NOT_FOUND = ~size_t(0);
+
+        template <size_t Buckets, size_t Slots>
+        struct chd_table {
+            std::array<std::uint32_t, Buckets> m_seeds{};
+            std::array<std::uint16_t, Slots> m_slots{}; // entry index + 1, 0 for an empty slot
+
+            template <class Entry, size_t N>
+            constexpr size_t find(const Entry (&entries)[N], std::wstring_view name) const
+            {
+                const size_t bucket = chd_hash(name, 0) % Buckets;
+                const size_t entry = m_slots[chd_hash(name, m_seeds[bucket]) % Slots];
+                return (entry != 0 && entries[entry - 1].m_name == name) ? entry - 1 : NOT_FOUND;
+            }
+        };
+
+        template <size_t Buckets, size_t Slots, class Entry, size_t N>
+        constexpr chd_table<Buckets, Slots> build_chd(const Entry (&entries)[N])
+        {
+            static_assert(N < 0xFFFF && Slots >= N, "CHD table is too small");
+            constexpr std::uint32_t MAX_SEED = 1 << 16;
+            chd_table<Buckets, Slots> table{};
+
+            // counting sort of the keys by bucket
+            std::array<size_t, N> bucket_of{};
+            std::array<size_t, Buckets + 1> bucket_start{};
+            for (size_t i = 0; i < N; ++i)
+            {
+                bucket_of[i] = chd_hash(entries[i].m_name, 0) % Buckets;
+                ++bucket_start[bucket_of[i] + 1];
+            }
+            size_t largest = 0;
+            for (size_t b = 0; b < Buckets; ++b)
+            {
+                largest = bucket_start[b + 1] > largest ? bucket_start[b + 1] : largest;
+                bucket_start[b + 1] += bucket_start[b];
+            }
+            std::array<size_t, N> keys{};
+            std::array<size_t, Buckets> filled{};
+            for (size_t i = 0; i < N; ++i)
+                keys[bucket_start[bucket_of[i]] + filled[bucket_of[i]]++] = i;
+
+            for (size_t size = largest; size > 0; --size)
+            {
+                for (size_t b = 0; b < Buckets; ++b)
+                {
+                    if (bucket_start[b + 1] - bucket_start[b] != size) continue;
+                    for (std::uint32_t seed = 1;; ++seed)
+                    {
+                        if (seed == MAX_SEED)
+                            throw std::logic_error("no perfect hash found, the catalogue probably has a duplicate name");
+                        std::array<size_t, N> slots{};
+                        bool placed = true;
+                        for (size_t k = 0; k < size && placed; ++k)
+                        {
+                            slots[k] = chd_hash(entries[keys[bucket_start[b] + k]].m_name, seed) % Slots;
+                            placed = table.m_slots[slots[k]] == 0;
+                            for (size_t other = 0; other < k && placed; ++other)
+                                placed = slots[other] != slots[k];
+                        }
+                        if (!placed) continue;
+                        for (size_t k = 0; k < size; ++k)
+                            table.m_slots[slots[k]] = static_cast<std::uint16_t>(keys[bucket_start[b] + k] + 1);
+                        table.m_seeds[b] = seed;
+                        break;
+                    }
+                }
+            }
+            return table;
+        }
+
+        constexpr size_t EVENT_COUNT = sizeof(k_events) / sizeof(k_events[0]);
+        constexpr size_t METRIC_COUNT = sizeof(k_metrics) / sizeof(k_metrics[0]);
+        constexpr auto k_event_table = build_chd<EVENT_COUNT / 2 + 1, EVENT_COUNT + EVENT_COUNT / 4 + 1>(k_events);
+        constexpr auto k_metric_table = build_chd<METRIC_COUNT / 2 + 1, METRIC_COUNT + METRIC_COUNT / 4 + 1>(k_metrics);
+
+        // every metric must be computed from catalogued events
+        constexpr bool metrics_use_known_events()
+        {
+            for (auto& metric : k_metrics)
+            {
+                size_t start = 0;
+                while (start <= metric.m_events.size())
+                {
+                    size_t end = metric.m_events.find(L',', start);
+                    if (end == std::wstring_view::npos) end = metric.m_events.size();
+                    if (k_event_table.find(k_events, metric.m_events.substr(start, end - start)) == NOT_FOUND)
+                        return false;
+                    start = end + 1;
+                }
+            }
+            return true;
+        }
+        static_assert(metrics_use_known_events(), "a metric refers to an event that is not in the catalogue");
+    #pragma endregion
+
+        void write_hex(utf8_writer& output, std::uint16_t value)
+        {
+            static const char digits[] = "0123456789ABCDEF";
+            const char text[] = { '0', 'x', digits[(value >> 12) & 0xF], digits[(value >> 8) & 0xF], digits[(value >> 4) & 0xF], digits[value & 0xF] };
+            output << std::string_view(text, sizeof(text));
+        }
+
+        void write_padded(utf8_writer& output, std::wstring_view text, size_t width)
+        {
+            static const wchar_t spaces[] = L"                                ";
+            output << text;
+            if (text.size() < width)
+                output << std::wstring_view(spaces, (std::min)(width - text.size(), sizeof(spaces) / sizeof(wchar_t) - 1));
+        }
+
+        void write_event_json(json_writer& json, const event_info& event)
+        {
+            json.begin_object()
+                .key("name").value(event.m_name)
+                .key("index").value(event.m_index)
+                .key("description").value(event.m_description)
+                .end_object();
+        }
+
+        void write_metric_json(json_writer& json, const metric_info& metric)
+        {
+            json.begin_object()
+                .key("name").value(metric.m_name)
+                .key("events").value(metric.m_events)
+                .key("description").value(metric.m_description)
+                .end_object();
+        }
+    }
+
+    catalogue_view<event_info> get_events()
+    {
+        return { k_events, EVENT_COUNT };
+    }
+
+    catalogue_view<metric_info> get_metrics()
+    {
+        return { k_metrics, METRIC_COUNT };
+    }
+
+    const event_info* find_event(std::wstring_view name)
+    {
+        const size_t index = k_event_table.find(k_events, name);
+        return index == NOT_FOUND ? nullptr : &k_events[index];
+    }
+
+    const metric_info* find_metric(std::wstring_view name)
+    {
+        const size_t index = k_metric_table.find(k_metrics, name);
+        return index == NOT_FOUND ? nullptr : &k_metrics[index];
+    }
+
+    bool is_raw_event(std::wstring_view name)
+    {
+        if (name.size() < 2 || name.size() > 5 || name[0] != L'r') return false;
+        for (size_t i = 1; i < name.size(); ++i)
+        {
+            const wchar_t c = name[i];
+            if (!((c >= L'0' && c <= L'9') || (c >= L'a' && c <= L'f') || (c >= L'A' && c <= L'F')))
+                return false;
+        }
+        return true;
+    }
+
+    void write_catalogue(utf8_writer& output)
+    {
+        output << "List of pre-defined events:\n\n";
+        for (auto& event : k_events)
+        {
+            output << "    ";
+            write_padded(output, event.m_name, 26);
+            write_hex(output, event.m_index);
+            output << "  " << event.m_description << "\n";
+        }
+        output << "\nList of metrics:\n\n";
+        for (auto& metric : k_metrics)
+        {
+            output << "    ";
+            write_padded(output, metric.m_name, 12);
+            output << metric.m_events << "\n";
+        }
+    }
+
+    void write_catalogue(json_writer& json)
+    {
+        json.begin_object().key("events").begin_array();
+        for (auto& event : k_events)
+            write_event_json(json, event);
+        json.end_array().key("metrics").begin_array();
+        for (auto& metric : k_metrics)
+            write_metric_json(json, metric);
+        json.end_array().end_object();
+    }
+
+    bool write_manual(std::wstring_view name, utf8_writer& output)
+    {
+        if (const event_info* event = find_event(name))
+        {
+            output << "NAME\n    " << event->m_name << " - " << event->m_description << "\n"
+                << "INDEX\n    ";
+            write_hex(output, event->m_index);
+            output << "\n";
+            return true;
+        }
+        if (const metric_info* metric = find_metric(name))
+        {
+            output << "NAME\n    " << metric->m_name << " - " << metric->m_description << "\n"
+                << "EVENTS\n    " << metric->m_events << "\n";
+            return true;
+        }
+        return false;
+    }
+
+    bool write_manual(std::wstring_view name, json_writer& json)
+    {
+        if (const event_info* event = find_event(name))
+        {
+            write_event_json(json, *event);
+            return true;
+        }
+        if (const metric_info* metric = find_metric(name))
+        {
+            write_metric_json(json, *metric);
+            return true;
+        }
+        return false;
+    }
+}
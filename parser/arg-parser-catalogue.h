@@ -0,0 +1,86 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "arg-parser-json.h"
+#include "arg-parser-utf8.h"
+
+// Built-in catalogue of the Arm PMU events and metrics accepted by `-e`, `-m`, `list` and `man`.
+// The tables and the perfect hashes over their names are constexpr, so they are generated by the
+// compiler and live in read-only data; nothing is built or allocated at run time.
+
+namespace ArgParser {
+    struct event_info {
+        std::wstring_view m_name;
+        std::uint16_t m_index;
+        std::wstring_view m_description;
+    };
+
+    struct metric_info {
+        std::wstring_view m_name;
+        // comma separated names of the events the metric is computed from
+        std::wstring_view m_events;
+        std::wstring_view m_description;
+    };
+
+    template <class T>
+    struct catalogue_view {
+        const T* m_data;
+        size_t m_size;
+
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+        size_t size() const { return m_size; }
+    };
+
+    catalogue_view<event_info> get_events();
+    catalogue_view<metric_info> get_metrics();
+
+    // O(1) lookups through a CHD perfect hash; nullptr when the name is not in the catalogue.
+    const event_info* find_event(std::wstring_view name);
+    const metric_info* find_metric(std::wstring_view name);
+
+    // Raw events are written `r<VALUE>` with VALUE a 16-bit hexadecimal event index, for example r1b.
+    bool is_raw_event(std::wstring_view name);
+
+    // `list`: every event and metric, streamed straight from the tables.
+    void write_catalogue(utf8_writer& output);
+    void write_catalogue(json_writer& json);
+
+    // `man`: the entry for one event or metric name. Return false when the name is unknown.
+    bool write_manual(std::wstring_view name, utf8_writer& output);
+    bool write_manual(std::wstring_view name, json_writer& json);
+}
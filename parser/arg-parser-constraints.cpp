@@ -0,0 +1,186 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-constraints.h"
+#include "arg-parser-utf8.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace ArgParser {
+    flag_constraints::flag_constraints(const flag_rule* rules, size_t count, const arg_finder& find_flag, const arg_finder& find_command)
+    {
+        const auto find = [](const arg_finder& finder, std::wstring_view name) {
+            arg_parser_arg* arg = finder(name);
+            if (arg == nullptr)
+                throw std::invalid_argument("Flag rule names unknown flag or command `" + wide_to_utf8(name) + "`.");
+            return arg;
+        };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const flag_rule& rule = rules[i];
+            const size_t flag = flag_bit(find(find_flag, rule.m_flag));
+            if (rule.m_kind == FLAG_RULE::ONLY_WITH_COMMAND)
+            {
+                m_allowed_commands[flag] |= std::uint64_t(1) << command_bit(find(find_command, rule.m_other));
+                m_command_bound |= std::uint64_t(1) << flag;
+                continue;
+            }
+
+            const size_t other = flag_bit(find(find_flag, rule.m_other));
+            if (other == flag)
+                throw std::invalid_argument("Flag rule relates `" + wide_to_utf8(rule.m_flag) + "` with itself.");
+            switch (rule.m_kind)
+            {
+            case FLAG_RULE::IMPLIES:
+                m_implies[flag] |= std::uint64_t(1) << other;
+                break;
+            case FLAG_RULE::REQUIRES:
+                m_requires[flag] |= std::uint64_t(1) << other;
+                break;
+            case FLAG_RULE::CONFLICTS:
+                // kept on both sides, a violation is reported for the flag that comes first
+                m_conflicts[flag] |= std::uint64_t(1) << other;
+                m_conflicts[other] |= std::uint64_t(1) << flag;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    size_t flag_constraints::flag_bit(arg_parser_arg* flag)
+    {
+        const auto found = std::find(m_flags.begin(), m_flags.end(), flag);
+        if (found != m_flags.end())
+            return found - m_flags.begin();
+        if (m_flags.size() == MAX_ARGS)
+            throw std::invalid_argument("Flag rules can relate at most 64 flags.");
+        m_flags.push_back(flag);
+        return m_flags.size() - 1;
+    }
+
+    size_t flag_constraints::command_bit(const arg_parser_arg* command)
+    {
+        const auto found = std::find(m_commands.begin(), m_commands.end(), command);
+        if (found != m_commands.end())
+            return found - m_commands.begin();
+        if (m_commands.size() == MAX_ARGS)
+            throw std::invalid_argument("Flag rules can name at most 64 commands.");
+        m_commands.push_back(command);
+        return m_commands.size() - 1;
+    }
+
+    void flag_constraints::evaluate(const arg_parser_arg* command, std::vector<rule_violation>& violations) const
+    {
+        std::uint64_t parsed = 0;
+        for (size_t i = 0; i < m_flags.size(); ++i)
+        {
+            if (m_flags[i]->m_is_implied) m_flags[i]->reset();
+            if (m_flags[i]->m_is_parsed) parsed |= std::uint64_t(1) << i;
+        }
+        const std::uint64_t given = parsed;
+
+        // implications are followed transitively, every round adds the flags implied by the last one
+        for (std::uint64_t added = parsed; added != 0;)
+        {
+            std::uint64_t implied = 0;
+            for (size_t i = 0; i < m_flags.size(); ++i)
+            {
+                if (added & (std::uint64_t(1) << i)) implied |= m_implies[i];
+            }
+            added = implied & ~parsed;
+            parsed |= added;
+        }
+        for (size_t i = 0; i < m_flags.size(); ++i)
+        {
+            if ((parsed & ~given) & (std::uint64_t(1) << i))
+            {
+                m_flags[i]->set_is_parsed();
+                m_flags[i]->m_is_implied = true;
+            }
+        }
+
+        const auto found = std::find(m_commands.begin(), m_commands.end(), command);
+        const std::uint64_t command_mask = found != m_commands.end() ? std::uint64_t(1) << (found - m_commands.begin()) : 0;
+        for (size_t i = 0; i < m_flags.size(); ++i)
+        {
+            const std::uint64_t bit = std::uint64_t(1) << i;
+            if ((given & bit) == 0) continue;
+
+            if ((m_command_bound & bit) && (m_allowed_commands[i] & command_mask) == 0)
+                violations.push_back({ FLAG_RULE::ONLY_WITH_COMMAND, m_flags[i], nullptr });
+
+            const std::uint64_t missing = m_requires[i] & ~parsed;
+            const std::uint64_t conflicting = m_conflicts[i] & parsed;
+            for (size_t other = 0; other < m_flags.size(); ++other)
+            {
+                const std::uint64_t other_bit = std::uint64_t(1) << other;
+                if (missing & other_bit)
+                    violations.push_back({ FLAG_RULE::REQUIRES, m_flags[i], m_flags[other] });
+                // conflicts are stored on both sides, a pair of given flags is reported from its first one
+                if ((conflicting & other_bit) && ((given & other_bit) == 0 || other > i))
+                    violations.push_back({ FLAG_RULE::CONFLICTS, m_flags[i], m_flags[other] });
+            }
+        }
+    }
+
+    bool flag_constraints::is_constrained(const arg_parser_arg* flag) const
+    {
+        return std::find(m_flags.begin(), m_flags.end(), flag) != m_flags.end();
+    }
+
+    std::wstring flag_constraints::describe(const rule_violation& violation) const
+    {
+        switch (violation.m_kind)
+        {
+        case FLAG_RULE::REQUIRES:
+            return violation.m_flag->get_name() + L" requires " + violation.m_other->get_name();
+        case FLAG_RULE::CONFLICTS:
+            return violation.m_flag->get_name() + L" cannot be used with " + violation.m_other->get_name();
+        case FLAG_RULE::ONLY_WITH_COMMAND:
+        {
+            const size_t flag = std::find(m_flags.begin(), m_flags.end(), violation.m_flag) - m_flags.begin();
+            std::wstring commands;
+            for (size_t i = 0; i < m_commands.size(); ++i)
+            {
+                if ((m_allowed_commands[flag] & (std::uint64_t(1) << i)) == 0) continue;
+                if (!commands.empty()) commands += L", ";
+                commands += m_commands[i]->get_name();
+            }
+            return violation.m_flag->get_name() + L" is only valid with " + commands;
+        }
+        default:
+            return violation.m_flag->get_name() + L" is used incorrectly";
+        }
+    }
+}
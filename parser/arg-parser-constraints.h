@@ -0,0 +1,102 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arg-parser-arg.h"
+
+using namespace ArgParserArg;
+
+namespace ArgParser {
+    enum class FLAG_RULE {
+        IMPLIES,            // the flag also sets the other flag
+        REQUIRES,           // the flag is only valid together with the other flag
+        CONFLICTS,          // the two flags are never valid together
+        ONLY_WITH_COMMAND   // the flag is only valid with the named command, or any of them given in several rules
+    };
+
+    // One declarative rule between a flag and another flag or command, both given by any of their names
+    struct flag_rule {
+        FLAG_RULE m_kind;
+        std::wstring_view m_flag;
+        std::wstring_view m_other;
+    };
+
+    struct rule_violation {
+        FLAG_RULE m_kind;
+        const arg_parser_arg* m_flag;
+        const arg_parser_arg* m_other; // nullptr for ONLY_WITH_COMMAND
+    };
+
+    // A rule table compiled into one bitmask per constrained flag and rule kind, so checking the
+    // parsed flags against every rule is a few mask operations per flag that takes part in a rule.
+    // At most 64 flags and 64 commands can take part in the rules of one table.
+    class flag_constraints {
+    public:
+        typedef std::function<arg_parser_arg*(std::wstring_view)> arg_finder;
+
+        flag_constraints() = default;
+        // Resolves every name through find_flag or find_command; throws std::invalid_argument for
+        // a name neither knows, a rule of a flag with itself, or more than 64 flags or commands.
+        flag_constraints(const flag_rule* rules, size_t count, const arg_finder& find_flag, const arg_finder& find_command);
+
+        // Marks the flags implied by the parsed ones as parsed and appends a violation for every
+        // broken rule, in table order of the flags. Flags implied by an earlier call that were not
+        // parsed since are reset first, so this can run again after the flags changed. Rules
+        // are only checked for flags that were parsed, implied flags satisfy the rules of others.
+        void evaluate(const arg_parser_arg* command, std::vector<rule_violation>& violations) const;
+        // Whether evaluate reads the flag
+        bool is_constrained(const arg_parser_arg* flag) const;
+        // Human readable form of a violation, such as "--pdb_file requires --pe_file"
+        std::wstring describe(const rule_violation& violation) const;
+
+    private:
+        static constexpr size_t MAX_ARGS = 64;
+
+        size_t flag_bit(arg_parser_arg* flag);
+        size_t command_bit(const arg_parser_arg* command);
+
+        std::vector<arg_parser_arg*> m_flags;            // bit i of a flag mask is m_flags[i]
+        std::vector<const arg_parser_arg*> m_commands;   // bit i of a command mask is m_commands[i]
+        std::array<std::uint64_t, MAX_ARGS> m_implies{};
+        std::array<std::uint64_t, MAX_ARGS> m_requires{};
+        std::array<std::uint64_t, MAX_ARGS> m_conflicts{};
+        std::array<std::uint64_t, MAX_ARGS> m_allowed_commands{};
+        std::uint64_t m_command_bound = 0; // flags with ONLY_WITH_COMMAND rules
+    };
+}
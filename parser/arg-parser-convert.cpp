@@ -0,0 +1,130 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-convert.h"
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <system_error>
+
+namespace ArgParserArg {
+    namespace {
+        constexpr size_t MAX_NUMBER_LENGTH = 64;
+
+        // Numbers are ASCII, so anything else, or anything too long to be a number, is rejected here.
+        bool narrow_number(std::wstring_view text, char (&buffer)[MAX_NUMBER_LENGTH], size_t& length)
+        {
+            if (text.empty() || text.size() > MAX_NUMBER_LENGTH) return false;
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                if (text[i] <= 0x20 || text[i] >= 0x7F) return false;
+                buffer[i] = static_cast<char>(text[i]);
+            }
+            length = text.size();
+            return true;
+        }
+
+        template <class T>
+        bool convert_number(std::wstring_view text, T& value)
+        {
+            char buffer[MAX_NUMBER_LENGTH];
+            size_t length;
+            if (!narrow_number(text, buffer, length)) return false;
+            T parsed{};
+            auto result = std::from_chars(buffer, buffer + length, parsed);
+            if (result.ec != std::errc() || result.ptr != buffer + length) return false;
+            value = parsed;
+            return true;
+        }
+    }
+
+    bool convert_value(std::wstring_view text, int& value)
+    {
+        return convert_number(text, value);
+    }
+
+    bool convert_value(std::wstring_view text, long long& value)
+    {
+        return convert_number(text, value);
+    }
+
+    bool convert_value(std::wstring_view text, double& value)
+    {
+        return convert_number(text, value) && std::isfinite(value);
+    }
+
+    bool convert_value(std::wstring_view text, std::filesystem::path& value)
+    {
+        if (text.empty()) return false;
+        value = std::filesystem::path(text);
+        return true;
+    }
+
+    bool convert_value(std::wstring_view text, std::chrono::nanoseconds& value)
+    {
+        constexpr unsigned long long max = static_cast<unsigned long long>((std::numeric_limits<long long>::max)());
+        size_t pos = 0;
+        unsigned long long whole = 0;
+        for (; pos < text.size() && text[pos] >= L'0' && text[pos] <= L'9'; ++pos)
+        {
+            const unsigned digit = text[pos] - L'0';
+            if (whole > (max - digit) / 10) return false;
+            whole = whole * 10 + digit;
+        }
+        if (pos == 0) return false;
+
+        unsigned long long hundredths = 0;
+        if (pos < text.size() && text[pos] == L'.')
+        {
+            const size_t decimals_start = ++pos;
+            for (; pos < text.size() && pos - decimals_start < 2 && text[pos] >= L'0' && text[pos] <= L'9'; ++pos)
+                hundredths = hundredths * 10 + (text[pos] - L'0');
+            if (pos == decimals_start) return false;
+            if (pos - decimals_start == 1) hundredths *= 10;
+        }
+
+        const std::wstring_view unit = text.substr(pos);
+        unsigned long long scale;
+        if (unit.empty() || unit == L"s") scale = 1'000'000'000ull;
+        else if (unit == L"ms") scale = 1'000'000ull;
+        else if (unit == L"m") scale = 60'000'000'000ull;
+        else if (unit == L"h") scale = 3'600'000'000'000ull;
+        else if (unit == L"d") scale = 86'400'000'000'000ull;
+        else return false;
+
+        if (whole > max / scale) return false;
+        const unsigned long long fraction = hundredths * scale / 100;
+        if (fraction > max - whole * scale) return false;
+        value = std::chrono::nanoseconds(static_cast<long long>(whole * scale + fraction));
+        return true;
+    }
+}
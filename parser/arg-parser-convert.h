@@ -0,0 +1,76 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <type_traits>
+
+namespace ArgParserArg {
+    // Read-only view over a contiguous run of converted values, std::span<const T> for C++17.
+    template <class T>
+    class arg_span {
+    public:
+        using element_type = T;
+
+        constexpr arg_span() = default;
+        constexpr arg_span(T* data, size_t size) : m_data(data), m_size(size) {}
+
+        constexpr T* begin() const { return m_data; }
+        constexpr T* end() const { return m_data + m_size; }
+        constexpr T* data() const { return m_data; }
+        constexpr size_t size() const { return m_size; }
+        constexpr bool empty() const { return m_size == 0; }
+        constexpr T& operator[](size_t index) const { return m_data[index]; }
+
+    private:
+        T* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    template <class T> struct is_arg_span : std::false_type {};
+    template <class T> struct is_arg_span<arg_span<T>> : std::true_type {};
+
+    // Converts one flag value without allocating: the wide text is narrowed into a stack buffer
+    // and handed to std::from_chars, which must consume all of it. Return false on anything else,
+    // including out of range and non-finite numbers.
+    bool convert_value(std::wstring_view text, int& value);
+    bool convert_value(std::wstring_view text, long long& value);
+    bool convert_value(std::wstring_view text, double& value);
+    bool convert_value(std::wstring_view text, std::filesystem::path& value);
+    // A duration as validators::is_duration accepts it, seconds when there is no unit. The
+    // arithmetic is on integers, so 0.1 is exactly 100 ms.
+    bool convert_value(std::wstring_view text, std::chrono::nanoseconds& value);
+}
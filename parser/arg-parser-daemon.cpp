@@ -0,0 +1,544 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include "arg-parser-daemon.h"
+#include "arg-parser-result.h"
+
+namespace ArgParser {
+    namespace {
+#ifdef _WIN32
+        const daemon_socket INVALID_DAEMON_SOCKET = INVALID_SOCKET;
+        constexpr int SHUTDOWN_BOTH = SD_BOTH;
+        constexpr int SEND_FLAGS = 0;
+        constexpr int CONNECTION_REFUSED = WSAECONNREFUSED;
+
+        void start_sockets()
+        {
+            static const bool started = [] {
+                WSADATA data;
+                return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+            }();
+            if (!started)
+                throw std::runtime_error("Winsock could not be started.");
+        }
+
+        void close_socket(daemon_socket socket)
+        {
+            closesocket(static_cast<SOCKET>(socket));
+        }
+
+        int last_socket_error()
+        {
+            return WSAGetLastError();
+        }
+
+        // std::filesystem reports no file_type::socket on Windows; an AF_UNIX socket file is a
+        // reparse point with its own tag
+        bool is_socket_file(const std::filesystem::path& path)
+        {
+            WIN32_FIND_DATAW data;
+            const HANDLE find = FindFirstFileW(path.c_str(), &data);
+            if (find == INVALID_HANDLE_VALUE) return false;
+            FindClose(find);
+            return (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0 && data.dwReserved0 == IO_REPARSE_TAG_AF_UNIX;
+        }
+#else
+        const daemon_socket INVALID_DAEMON_SOCKET = -1;
+        constexpr int SHUTDOWN_BOTH = SHUT_RDWR;
+        constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+        constexpr int CONNECTION_REFUSED = ECONNREFUSED;
+
+        void start_sockets()
+        {
+        }
+
+        void close_socket(daemon_socket socket)
+        {
+            ::close(socket);
+        }
+
+        int last_socket_error()
+        {
+            return errno;
+        }
+
+        bool is_socket_file(const std::filesystem::path& path)
+        {
+            std::error_code error;
+            return std::filesystem::is_socket(std::filesystem::symlink_status(path, error));
+        }
+#endif
+
+        constexpr size_t RECEIVE_CHUNK = 16 * 1024;
+
+        sockaddr_un make_address(const std::string& socket_path)
+        {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+                throw std::invalid_argument("Socket path is empty or too long.");
+            std::memcpy(address.sun_path, socket_path.data(), socket_path.size());
+            return address;
+        }
+
+        daemon_socket open_socket()
+        {
+            start_sockets();
+            daemon_socket result = static_cast<daemon_socket>(::socket(AF_UNIX, SOCK_STREAM, 0));
+            if (result == INVALID_DAEMON_SOCKET)
+                throw std::runtime_error("Unix domain socket could not be created.");
+            return result;
+        }
+
+        // A socket file left behind by a daemon that did not shut down cleanly refuses connections,
+        // one a running daemon listens on accepts them
+        bool is_stale_socket(const sockaddr_un& address)
+        {
+            const daemon_socket probe = open_socket();
+            const bool refused = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+                && last_socket_error() == CONNECTION_REFUSED;
+            close_socket(probe);
+            return refused;
+        }
+
+        bool send_all(daemon_socket socket, const std::string& data)
+        {
+            size_t sent = 0;
+            while (sent < data.size())
+            {
+                const int chunk = static_cast<int>((std::min)(data.size() - sent, size_t(1) << 30));
+                const auto result = ::send(socket, data.data() + sent, chunk, SEND_FLAGS);
+                if (result <= 0) return false;
+                sent += static_cast<size_t>(result);
+            }
+            return true;
+        }
+
+        // Appends what is available, false when the peer closed the connection or it failed
+        bool receive_some(daemon_socket socket, std::string& buffer)
+        {
+            char chunk[RECEIVE_CHUNK];
+            const auto result = ::recv(socket, chunk, static_cast<int>(sizeof(chunk)), 0);
+            if (result <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(result));
+            return true;
+        }
+
+        void put_u32(char* out, size_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+                out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+
+        size_t get_u32(const char* in)
+        {
+            size_t value = 0;
+            for (int i = 0; i < 4; ++i)
+                value |= static_cast<size_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+            return value;
+        }
+    }
+
+    void append_daemon_request(std::string& buffer, DAEMON_FORMAT format, const std::vector<std::string>& args)
+    {
+        size_t size = 0;
+        for (auto& arg : args) size += arg.size() + 1;
+        if (size > DAEMON_MAX_PAYLOAD)
+            throw std::length_error("Command line is too long for one daemon request.");
+
+        const size_t header = buffer.size();
+        buffer.resize(header + DAEMON_FRAME_HEADER_SIZE);
+        put_u32(&buffer[header], size);
+        buffer[header + 4] = static_cast<char>(format);
+        for (auto& arg : args)
+        {
+            buffer += arg;
+            buffer.push_back('\0');
+        }
+    }
+
+    void handle_daemon_request(arg_parser& parser, buffer_sink& errors, std::uint8_t format, std::string_view payload, std::string& response)
+    {
+        errors.clear();
+        parser.set_error_sink(errors);
+        const size_t header = response.size();
+        response.resize(header + DAEMON_FRAME_HEADER_SIZE);
+        DAEMON_STATUS status = DAEMON_STATUS::OK;
+
+        if (format > static_cast<std::uint8_t>(DAEMON_FORMAT::JSON) || (!payload.empty() && payload.back() != '\0'))
+        {
+            status = DAEMON_STATUS::BAD_REQUEST;
+            response += "Malformed request.";
+        }
+        else
+        {
+            // argv points straight into the payload, whose tokens are NUL terminated
+            thread_local std::vector<const char*> argv;
+            argv.assign(1, "wperf");
+            for (size_t i = 0; i < payload.size(); i += std::strlen(payload.data() + i) + 1)
+                argv.push_back(payload.data() + i);
+
+            try
+            {
+                parser.reset();
+                parser.parse(static_cast<int>(argv.size()), argv.data());
+                if (format == static_cast<std::uint8_t>(DAEMON_FORMAT::JSON))
+                {
+                    json_writer json(response);
+                    parser.write_json(json);
+                }
+                else
+                {
+                    // the blob is written with aligned stores, so it is built aside and then copied
+                    thread_local std::vector<std::uint64_t> blob;
+                    const size_t size = write_parse_result(parser, nullptr, 0);
+                    blob.resize((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+                    write_parse_result(parser, blob.data(), size);
+                    response.append(reinterpret_cast<const char*>(blob.data()), size);
+                }
+            }
+            catch (const std::exception& err)
+            {
+                response.resize(header + DAEMON_FRAME_HEADER_SIZE);
+                status = DAEMON_STATUS::INVALID_ARGUMENT;
+                if (errors.get_buffer().empty())
+                    response += err.what();
+                else
+                    response += errors.get_buffer();
+            }
+        }
+
+        put_u32(&response[header], response.size() - header - DAEMON_FRAME_HEADER_SIZE);
+        response[header + 4] = static_cast<char>(status);
+    }
+
+    daemon_server::daemon_server(std::string socket_path, size_t max_connections)
+        : m_socket_path(std::move(socket_path)), m_max_connections(max_connections), m_listen_socket(INVALID_DAEMON_SOCKET)
+    {
+    }
+
+    daemon_server::~daemon_server()
+    {
+        stop();
+    }
+
+    void daemon_server::listen()
+    {
+        const sockaddr_un address = make_address(m_socket_path);
+
+        // a stale socket file blocks bind and is replaced; the socket of a running daemon, or
+        // anything that is not a socket, is not ours to delete
+        const std::filesystem::path path = std::filesystem::u8path(m_socket_path);
+        std::error_code error;
+        if (std::filesystem::exists(std::filesystem::symlink_status(path, error)) || is_socket_file(path))
+        {
+            if (!is_socket_file(path))
+                throw std::runtime_error("Cannot listen on " + m_socket_path + ", the path exists and is not a socket.");
+            if (!is_stale_socket(address))
+                throw std::runtime_error("Cannot listen on " + m_socket_path + ", a daemon is already listening on it.");
+            if (!std::filesystem::remove(path, error))
+                throw std::runtime_error("Cannot listen on " + m_socket_path + ", the stale socket cannot be removed.");
+        }
+
+        m_listen_socket = open_socket();
+#ifdef _WIN32
+        const bool bound = ::bind(m_listen_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+#else
+        // only the user running the daemon may connect to it: the socket file is created without
+        // group and other permissions, so there is no window in which it is open to them
+        const mode_t previous_mask = ::umask(S_IRWXG | S_IRWXO);
+        const bool bound = ::bind(m_listen_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        ::umask(previous_mask);
+#endif
+        if (!bound
+#ifndef _WIN32
+            || ::chmod(m_socket_path.c_str(), S_IRUSR | S_IWUSR) != 0
+#endif
+            || ::listen(m_listen_socket, SOMAXCONN) != 0)
+        {
+            close_socket(m_listen_socket);
+            m_listen_socket = INVALID_DAEMON_SOCKET;
+            throw std::runtime_error("Cannot listen on " + m_socket_path + ".");
+        }
+    }
+
+    void daemon_server::run()
+    {
+        while (!m_stopping)
+        {
+            const daemon_socket client = static_cast<daemon_socket>(::accept(m_listen_socket, nullptr, nullptr));
+            if (client == INVALID_DAEMON_SOCKET)
+            {
+                if (m_stopping) break;
+                throw std::runtime_error("Cannot accept connections on " + m_socket_path + ".");
+            }
+
+            reap_connections(false);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping || m_connections.size() >= m_max_connections)
+            {
+                close_socket(client);
+                continue;
+            }
+            m_connections.emplace_back();
+            connection& added = m_connections.back();
+            added.m_socket = client;
+            added.m_thread = std::thread(&daemon_server::serve, this, std::ref(added));
+        }
+    }
+
+    void daemon_server::stop()
+    {
+        // a second caller, such as the destructor after an interrupt handler stopped the daemon,
+        // returns only once the first has joined every connection
+        std::lock_guard<std::mutex> stopping(m_stop_mutex);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            if (m_listen_socket != INVALID_DAEMON_SOCKET)
+            {
+                // shutdown wakes a thread blocked in accept, closing alone does not everywhere
+                ::shutdown(m_listen_socket, SHUTDOWN_BOTH);
+                close_socket(m_listen_socket);
+                m_listen_socket = INVALID_DAEMON_SOCKET;
+                std::error_code ignored;
+                std::filesystem::remove(std::filesystem::u8path(m_socket_path), ignored);
+            }
+        }
+        reap_connections(true);
+    }
+
+    void daemon_server::serve(connection& client)
+    {
+        // one warm parser per connection, reset between requests so its buffers are reused; it
+        // never writes to the console, errors are sent back to the client
+        arg_parser parser;
+        buffer_sink errors;
+        parser.set_output_sink(get_null_sink());
+        std::string input;
+        std::string output;
+
+        while (!m_stopping)
+        {
+            // every complete frame already received is answered, with one send for the batch
+            size_t offset = 0;
+            bool malformed = false;
+            while (input.size() - offset >= DAEMON_FRAME_HEADER_SIZE)
+            {
+                const size_t size = get_u32(&input[offset]);
+                if (size > DAEMON_MAX_PAYLOAD)
+                {
+                    malformed = true;
+                    break;
+                }
+                if (input.size() - offset - DAEMON_FRAME_HEADER_SIZE < size) break;
+                handle_daemon_request(parser, errors, static_cast<std::uint8_t>(input[offset + 4]),
+                    std::string_view(input.data() + offset + DAEMON_FRAME_HEADER_SIZE, size), output);
+                offset += DAEMON_FRAME_HEADER_SIZE + size;
+            }
+            if (!output.empty())
+            {
+                if (!send_all(client.m_socket, output)) break;
+                output.clear();
+            }
+            if (malformed) break;
+            input.erase(0, offset);
+            if (!receive_some(client.m_socket, input)) break;
+        }
+        client.m_done = true;
+    }
+
+    void daemon_server::reap_connections(bool all)
+    {
+        std::list<connection> finished;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto it = m_connections.begin(); it != m_connections.end();)
+            {
+                auto current = it++;
+                if (all || current->m_done)
+                    finished.splice(finished.end(), m_connections, current);
+            }
+        }
+        // sockets are closed only after their thread is gone, so a handle is never reused under it
+        for (auto& client : finished)
+        {
+            if (all) ::shutdown(client.m_socket, SHUTDOWN_BOTH);
+            client.m_thread.join();
+            close_socket(client.m_socket);
+        }
+    }
+
+    daemon_client::daemon_client(const std::string& socket_path)
+    {
+        const sockaddr_un address = make_address(socket_path);
+        m_socket = open_socket();
+        if (::connect(m_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            close_socket(m_socket);
+            throw std::runtime_error("Cannot connect to " + socket_path + ".");
+        }
+    }
+
+    daemon_client::~daemon_client()
+    {
+        close_socket(m_socket);
+    }
+
+    void daemon_client::send_request(DAEMON_FORMAT format, const std::vector<std::string>& args)
+    {
+        append_daemon_request(m_output, format, args);
+    }
+
+    void daemon_client::flush()
+    {
+        if (!send_all(m_socket, m_output))
+            throw std::runtime_error("Daemon connection lost.");
+        m_output.clear();
+    }
+
+    bool daemon_client::read_response(DAEMON_STATUS& status, std::string& payload)
+    {
+        while (true)
+        {
+            const size_t available = m_input.size() - m_input_offset;
+            if (available >= DAEMON_FRAME_HEADER_SIZE)
+            {
+                const size_t size = get_u32(&m_input[m_input_offset]);
+                if (available - DAEMON_FRAME_HEADER_SIZE >= size)
+                {
+                    status = static_cast<DAEMON_STATUS>(m_input[m_input_offset + 4]);
+                    payload.assign(m_input, m_input_offset + DAEMON_FRAME_HEADER_SIZE, size);
+                    m_input_offset += DAEMON_FRAME_HEADER_SIZE + size;
+                    return true;
+                }
+            }
+            m_input.erase(0, m_input_offset);
+            m_input_offset = 0;
+            if (!receive_some(m_socket, m_input)) return false;
+        }
+    }
+
+    double daemon_load_report::get_requests_per_second() const
+    {
+        return m_seconds > 0 ? m_requests / m_seconds : 0;
+    }
+
+    daemon_load_report run_daemon_load(
+        const std::string& socket_path,
+        const std::vector<std::string>& args,
+        DAEMON_FORMAT format,
+        size_t connections,
+        size_t requests,
+        size_t pipeline_depth
+    )
+    {
+        typedef std::chrono::steady_clock clock;
+        pipeline_depth = (std::max)(pipeline_depth, size_t(1));
+
+        std::vector<std::vector<double>> latencies(connections);
+        std::vector<size_t> errors(connections, 0);
+        std::vector<std::thread> clients;
+        const auto start = clock::now();
+        for (size_t i = 0; i < connections; ++i)
+        {
+            clients.emplace_back([&, i]() {
+                try
+                {
+                    daemon_client client(socket_path);
+                    DAEMON_STATUS status;
+                    std::string payload;
+                    latencies[i].reserve(requests);
+                    for (size_t sent = 0; sent < requests;)
+                    {
+                        const size_t batch = (std::min)(pipeline_depth, requests - sent);
+                        for (size_t j = 0; j < batch; ++j)
+                            client.send_request(format, args);
+                        const auto flushed = clock::now();
+                        client.flush();
+                        for (size_t j = 0; j < batch; ++j)
+                        {
+                            if (!client.read_response(status, payload))
+                                throw std::runtime_error("Daemon closed the connection.");
+                            latencies[i].push_back(std::chrono::duration<double, std::micro>(clock::now() - flushed).count());
+                            if (status != DAEMON_STATUS::OK) ++errors[i];
+                        }
+                        sent += batch;
+                    }
+                }
+                catch (const std::exception&)
+                {
+                    // requests that never got a response count as errors
+                    errors[i] += requests - latencies[i].size();
+                }
+            });
+        }
+        for (auto& client : clients)
+            client.join();
+
+        daemon_load_report report;
+        report.m_seconds = std::chrono::duration<double>(clock::now() - start).count();
+        std::vector<double> all;
+        for (size_t i = 0; i < connections; ++i)
+        {
+            all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+            report.m_errors += errors[i];
+        }
+        report.m_requests = all.size();
+        if (!all.empty())
+        {
+            std::sort(all.begin(), all.end());
+            report.m_p50_us = all[all.size() / 2];
+            report.m_p99_us = all[(std::min)(all.size() - 1, all.size() * 99 / 100)];
+        }
+        return report;
+    }
+}
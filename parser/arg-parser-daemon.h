@@ -0,0 +1,164 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "arg-parser.h"
+#include "arg-parser-output.h"
+
+namespace ArgParser {
+    // Daemon mode (`wperf --daemon <socket>`): command lines are parsed by warm parsers behind a
+    // Unix domain socket, AF_UNIX on Windows 10 1803 and later too. Frames on the wire are
+    //
+    //   request:  u32 payload size | u8 DAEMON_FORMAT | argv[1..] as NUL terminated UTF-8 strings
+    //   response: u32 payload size | u8 DAEMON_STATUS | parse_result blob, JSON, or the parse error
+    //
+    // with sizes in little-endian byte order. A client may send any number of requests without
+    // waiting, responses come back in request order. Connections are served concurrently, each
+    // by its own thread and arg_parser.
+    enum class DAEMON_FORMAT : std::uint8_t {
+        BINARY = 0,     // write_parse_result blob
+        JSON = 1        // arg_parser::write_json
+    };
+
+    enum class DAEMON_STATUS : std::uint8_t {
+        OK = 0,
+        INVALID_ARGUMENT = 1,   // the command line did not parse, the payload is the message
+        BAD_REQUEST = 2         // the frame itself was malformed
+    };
+
+    constexpr size_t DAEMON_FRAME_HEADER_SIZE = 5;
+    constexpr size_t DAEMON_MAX_PAYLOAD = 1024 * 1024;
+
+    // Appends one request frame for args (without the program name) to buffer
+    void append_daemon_request(std::string& buffer, DAEMON_FORMAT format, const std::vector<std::string>& args);
+    // Parses one request payload with parser and appends the response frame to response. The
+    // parser's error sink is pointed at errors, a failed parse is answered with what it wrote.
+    // Requests are only parsed: nothing on the daemon host is created or opened for a client, see
+    // arg_parser::open_timeline_outputs.
+    void handle_daemon_request(arg_parser& parser, buffer_sink& errors, std::uint8_t format, std::string_view payload, std::string& response);
+
+#ifdef _WIN32
+    typedef std::uintptr_t daemon_socket;
+#else
+    typedef int daemon_socket;
+#endif
+
+    class daemon_server {
+    public:
+        explicit daemon_server(std::string socket_path, size_t max_connections = 64);
+        ~daemon_server();
+        daemon_server(const daemon_server&) = delete;
+        daemon_server& operator=(const daemon_server&) = delete;
+
+        // Binds the socket, replacing a socket file that refuses connections. Throws
+        // std::runtime_error when the path is anything else or a daemon is listening on it. On
+        // POSIX the socket file is created 0600; the process umask is narrowed around bind, so
+        // call it before starting threads that create files.
+        void listen();
+        // Accepts connections until stop(); connections over max_connections are closed at once
+        void run();
+        // Safe to call from any thread, for example an interrupt handler; returns once every
+        // connection has been closed and the socket file removed
+        void stop();
+
+    private:
+        struct connection {
+            daemon_socket m_socket;
+            std::thread m_thread;
+            std::atomic<bool> m_done{ false };
+        };
+
+        void serve(connection& client);
+        void reap_connections(bool all);
+
+        std::string m_socket_path;
+        size_t m_max_connections;
+        daemon_socket m_listen_socket;
+        std::atomic<bool> m_stopping{ false };
+        std::mutex m_mutex;
+        std::mutex m_stop_mutex;
+        std::list<connection> m_connections;
+    };
+
+    // Pipelining client: queue requests with send_request, put them on the wire with flush and
+    // collect the responses in order with read_response.
+    class daemon_client {
+    public:
+        explicit daemon_client(const std::string& socket_path);
+        ~daemon_client();
+        daemon_client(const daemon_client&) = delete;
+        daemon_client& operator=(const daemon_client&) = delete;
+
+        void send_request(DAEMON_FORMAT format, const std::vector<std::string>& args);
+        void flush();
+        // Returns false when the daemon closed the connection
+        bool read_response(DAEMON_STATUS& status, std::string& payload);
+
+    private:
+        daemon_socket m_socket;
+        std::string m_output;
+        std::string m_input;
+        size_t m_input_offset = 0;
+    };
+
+    struct daemon_load_report {
+        size_t m_requests = 0;
+        size_t m_errors = 0;
+        double m_seconds = 0;
+        double m_p50_us = 0;
+        double m_p99_us = 0;
+
+        double get_requests_per_second() const;
+    };
+
+    // Load generator: `connections` clients each send `requests` copies of args, keeping
+    // `pipeline_depth` requests in flight. Latency is measured per request, from the flush of
+    // its batch to the arrival of its response.
+    daemon_load_report run_daemon_load(
+        const std::string& socket_path,
+        const std::vector<std::string>& args,
+        DAEMON_FORMAT format,
+        size_t connections,
+        size_t requests,
+        size_t pipeline_depth
+    );
+}
@@ -0,0 +1,284 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "arg-parser-incremental.h"
+#include "arg-parser-utf8.h"
+
+namespace ArgParser {
+    namespace {
+        std::wstring exception_message(const std::exception& err)
+        {
+            std::wstring message;
+            utf8_to_wide(err.what(), message, true);
+            return message;
+        }
+    }
+
+    token_edit token_edit::insert(size_t position, wstr_vec tokens)
+    {
+        return token_edit{ position, 0, std::move(tokens) };
+    }
+
+    token_edit token_edit::erase(size_t position, size_t count)
+    {
+        return token_edit{ position, count, {} };
+    }
+
+    token_edit token_edit::replace(size_t position, std::wstring token)
+    {
+        token_edit edit{ position, 1, {} };
+        edit.m_insert.push_back(std::move(token));
+        return edit;
+    }
+
+    void incremental_parser::parse(
+        _In_ const int argc,
+        _In_reads_(argc) const wchar_t* argv[]
+    )
+    {
+        m_arg_array.clear();
+        if (argc > 1)
+            m_arg_array.assign(argv + 1, argv + argc);
+        parse_all();
+    }
+
+    void incremental_parser::apply(const token_edit& edit)
+    {
+        if (edit.m_position > m_arg_array.size() || edit.m_erase > m_arg_array.size() - edit.m_position)
+            throw std::out_of_range("Edit is outside of the token stream.");
+
+        const bool was_valid = m_is_valid;
+        const auto first = m_arg_array.begin() + edit.m_position;
+        // the erased tokens are kept to undo the edit when the result does not parse; a
+        // replacement of as many tokens as it erases is done in place, without shifting the rest
+        wstr_vec erased(std::make_move_iterator(first), std::make_move_iterator(first + edit.m_erase));
+        if (edit.m_erase == edit.m_insert.size())
+        {
+            std::copy(edit.m_insert.begin(), edit.m_insert.end(), first);
+        }
+        else
+        {
+            m_arg_array.erase(first, first + edit.m_erase);
+            m_arg_array.insert(m_arg_array.begin() + edit.m_position, edit.m_insert.begin(), edit.m_insert.end());
+        }
+
+        try
+        {
+            if (was_valid && m_command != COMMAND_CLASS::HELP && edit.m_position >= m_flags_begin)
+                apply_incremental(edit);
+            else
+                parse_all();
+        }
+        catch (...)
+        {
+            m_is_valid = false;
+            const auto inserted = m_arg_array.begin() + edit.m_position;
+            if (edit.m_erase == edit.m_insert.size())
+            {
+                std::move(erased.begin(), erased.end(), inserted);
+            }
+            else
+            {
+                m_arg_array.erase(inserted, inserted + edit.m_insert.size());
+                m_arg_array.insert(m_arg_array.begin() + edit.m_position, std::make_move_iterator(erased.begin()), std::make_move_iterator(erased.end()));
+            }
+            // the previous command line parsed, so this brings its result back
+            if (was_valid) parse_all();
+            throw;
+        }
+    }
+
+    const wstr_vec& incremental_parser::get_tokens() const
+    {
+        return m_arg_array;
+    }
+
+    size_t incremental_parser::get_reparsed_token_count() const
+    {
+        return m_reparsed_tokens;
+    }
+
+    void incremental_parser::parse_all()
+    {
+        m_is_valid = false;
+        m_segments.clear();
+        m_occurrences.clear();
+        {
+            // reset() drops the tokens too, these are the ones to parse
+            wstr_vec tokens;
+            tokens.swap(m_arg_array);
+            reset();
+            m_arg_array.swap(tokens);
+        }
+        m_reparsed_tokens = m_arg_array.size();
+
+        if (m_arg_array.empty())
+            throw_invalid_arg(L"", L"warning: No arguments were found!");
+
+        m_flags_begin = parse_command(0);
+        if (m_command != COMMAND_CLASS::HELP)
+        {
+            for (size_t position = m_flags_begin; position < m_arg_array.size(); position = m_segments.back().m_end)
+                m_segments.push_back(match_segment(position));
+            for (auto& segment : m_segments)
+            {
+                parse_segment(segment);
+                ++m_occurrences[segment.m_flag];
+            }
+            validate_parsed_args();
+        }
+        m_is_valid = true;
+    }
+
+    void incremental_parser::apply_incremental(const token_edit& edit)
+    {
+        const size_t count = m_segments.size();
+        const size_t edit_end = edit.m_position + edit.m_erase;
+        // where an old segment after the edit starts in the edited token stream
+        const auto shifted = [&](size_t begin) { return begin - edit.m_erase + edit.m_insert.size(); };
+
+        // the first segment the edit can change is the one holding m_position; a variadic flag
+        // before an insertion at the end also takes the inserted tokens
+        size_t first = std::upper_bound(m_segments.begin(), m_segments.end(), edit.m_position,
+            [](size_t position, const flag_segment& segment) { return position < segment.m_begin; }) - m_segments.begin();
+        if (first > 0) --first;
+        if (first < count && m_segments[first].m_end <= edit.m_position && !m_segments[first].m_flag->m_is_variadic) ++first;
+
+        // match tokens until the cursor lands where an old segment after the edit now starts,
+        // from there on every token is consumed by the same flag as before
+        m_new_segments.clear();
+        size_t last = first;
+        size_t cursor = first < count ? m_segments[first].m_begin : edit.m_position;
+        while (true)
+        {
+            while (last < count && (m_segments[last].m_begin < edit_end || shifted(m_segments[last].m_begin) < cursor)) ++last;
+            if (cursor >= m_arg_array.size() || (last < count && shifted(m_segments[last].m_begin) == cursor))
+                break;
+            m_new_segments.push_back(match_segment(cursor));
+            cursor = m_new_segments.back().m_end;
+        }
+
+        // the flags that lost or gained a segment, plus a trailing variadic flag whose view
+        // points into token storage that has just moved
+        m_affected_flags.clear();
+        const auto add_affected = [this](arg_parser_arg* flag) {
+            if (std::find(m_affected_flags.begin(), m_affected_flags.end(), flag) == m_affected_flags.end())
+                m_affected_flags.push_back(flag);
+        };
+        for (size_t i = first; i < last; ++i) add_affected(m_segments[i].m_flag);
+        for (auto& segment : m_new_segments) add_affected(segment.m_flag);
+
+        for (size_t i = first; i < last; ++i) --m_occurrences[m_segments[i].m_flag];
+        for (auto& segment : m_new_segments) ++m_occurrences[segment.m_flag];
+
+        // an edit that keeps the token count leaves the segments after it where they are
+        if (edit.m_erase != edit.m_insert.size())
+        {
+            for (size_t i = last; i < count; ++i)
+            {
+                m_segments[i].m_begin = shifted(m_segments[i].m_begin);
+                m_segments[i].m_end = m_segments[i].m_flag->m_is_variadic ? m_arg_array.size() : shifted(m_segments[i].m_end);
+            }
+        }
+        if (last - first == m_new_segments.size())
+        {
+            std::copy(m_new_segments.begin(), m_new_segments.end(), m_segments.begin() + first);
+        }
+        else
+        {
+            m_segments.erase(m_segments.begin() + first, m_segments.begin() + last);
+            m_segments.insert(m_segments.begin() + first, m_new_segments.begin(), m_new_segments.end());
+        }
+        if (!m_segments.empty() && m_segments.back().m_flag->m_is_variadic) add_affected(m_segments.back().m_flag);
+
+        // values accumulate over repeated flags, so an affected flag is parsed again from all of
+        // its segments in token order. Those are usually just the new ones; a variadic flag only
+        // ever has the last segment, and anything else needs a walk over the whole command line.
+        m_reparsed_tokens = 0;
+        const auto window_begin = m_segments.begin() + first;
+        const auto window_end = window_begin + m_new_segments.size();
+        for (auto* flag : m_affected_flags)
+        {
+            flag->reset();
+            const size_t occurrences = m_occurrences[flag];
+            if (occurrences == 0) continue;
+
+            auto begin = m_segments.begin();
+            auto end = m_segments.end();
+            if (flag->m_is_variadic)
+                begin = end - 1;
+            else if (static_cast<size_t>(std::count_if(window_begin, window_end, [flag](const flag_segment& segment) { return segment.m_flag == flag; })) == occurrences)
+                begin = window_begin, end = window_end;
+
+            for (auto segment = begin; segment != end; ++segment)
+            {
+                if (segment->m_flag != flag) continue;
+                parse_segment(*segment);
+                m_reparsed_tokens += segment->m_end - segment->m_begin;
+            }
+        }
+
+        // the flag rules are a few mask operations, the rest of the validation scans every value
+        if (std::any_of(m_affected_flags.begin(), m_affected_flags.end(), [this](const arg_parser_arg* flag) { return is_validated_flag(flag); }))
+            validate_parsed_args();
+        else if (std::any_of(m_affected_flags.begin(), m_affected_flags.end(), [this](const arg_parser_arg* flag) { return m_constraints.is_constrained(flag); }))
+            check_flag_rules();
+    }
+
+    incremental_parser::flag_segment incremental_parser::match_segment(size_t position) const
+    {
+        arg_parser_arg* flag = match_flag(m_arg_array[position]);
+        if (flag == nullptr)
+            throw_invalid_arg(m_arg_array[position], L"Error: Unrecognized command");
+
+        // a flag short of values is reported by its own parse, the segment just ends with the tokens
+        size_t end = m_arg_array.size();
+        if (!flag->m_is_variadic)
+            end = (std::min)(end, position + 1 + flag->get_arg_count());
+        return flag_segment{ flag, position, end };
+    }
+
+    void incremental_parser::parse_segment(const flag_segment& segment)
+    {
+        try
+        {
+            segment.m_flag->parse(m_arg_array, segment.m_begin);
+        }
+        catch (const std::exception& err)
+        {
+            throw_invalid_arg(m_arg_array[segment.m_begin], L"Error: " + exception_message(err));
+        }
+    }
+}
@@ -0,0 +1,97 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arg-parser.h"
+
+namespace ArgParser {
+    // One edit to the token stream of an incremental_parser: m_erase tokens at m_position are
+    // replaced by m_insert. Positions index the tokens after the program name, so the command
+    // is at 0. Insert, delete and replace are the three shapes of the same edit.
+    struct token_edit {
+        size_t m_position = 0;
+        size_t m_erase = 0;
+        wstr_vec m_insert;
+
+        static token_edit insert(size_t position, wstr_vec tokens);
+        static token_edit erase(size_t position, size_t count = 1);
+        static token_edit replace(size_t position, std::wstring token);
+    };
+
+    // Parser for an interactive session, where the same command line is edited and parsed
+    // again. parse() remembers which flag consumed which tokens; apply() then only matches the
+    // tokens from the edited flag up to the first unchanged flag after the edit, parses the flags
+    // involved again and runs validate_parsed_args only when it reads one of them. Edits that
+    // touch the command, or a parser whose last parse failed, fall back to a full parse.
+    //
+    // Flag values keep the token order of a full parse, so after apply() the parser is in the
+    // state a fresh arg_parser would be in after parsing get_tokens(). When apply() throws, the
+    // edit is undone and the previous result restored.
+    class incremental_parser : public arg_parser {
+    public:
+        void parse(
+            _In_ const int argc,
+            _In_reads_(argc) const wchar_t* argv[]
+        );
+        void apply(const token_edit& edit);
+
+        const wstr_vec& get_tokens() const;
+        // Tokens whose flags were parsed again by the last parse() or apply()
+        size_t get_reparsed_token_count() const;
+
+    private:
+        // Tokens [m_begin, m_end) consumed by m_flag, the flag name included
+        struct flag_segment {
+            arg_parser_arg* m_flag;
+            size_t m_begin;
+            size_t m_end;
+        };
+
+        void parse_all();
+        void apply_incremental(const token_edit& edit);
+        flag_segment match_segment(size_t position) const;
+        void parse_segment(const flag_segment& segment);
+
+        std::vector<flag_segment> m_segments;
+        std::vector<flag_segment> m_new_segments;
+        std::vector<arg_parser_arg*> m_affected_flags;
+        // number of segments per flag
+        std::unordered_map<const arg_parser_arg*, size_t> m_occurrences;
+        size_t m_flags_begin = 0;
+        size_t m_reparsed_tokens = 0;
+        bool m_is_valid = false;
+    };
+}
@@ -0,0 +1,222 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-json.h"
+#include "arg-parser-utf8.h"
+#include <charconv>
+#include <stdexcept>
+
+namespace ArgParser {
+    namespace {
+        template <class CharT>
+        inline bool needs_escape(CharT c)
+        {
+            return static_cast<std::make_unsigned_t<CharT>>(c) < 0x20 || c == CharT('"') || c == CharT('\\');
+        }
+
+        void append_escape(std::string& buffer, unsigned c)
+        {
+            static const char hex[] = "0123456789abcdef";
+            switch (c)
+            {
+            case '"': buffer.append("\\\"", 2); break;
+            case '\\': buffer.append("\\\\", 2); break;
+            case '\b': buffer.append("\\b", 2); break;
+            case '\f': buffer.append("\\f", 2); break;
+            case '\n': buffer.append("\\n", 2); break;
+            case '\r': buffer.append("\\r", 2); break;
+            case '\t': buffer.append("\\t", 2); break;
+            default:
+            {
+                const char escape[] = { '\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF] };
+                buffer.append(escape, sizeof(escape));
+                break;
+            }
+            }
+        }
+    }
+
+    json_writer::json_writer(std::string& buffer) : m_buffer(buffer)
+    {
+    }
+
+    void json_writer::begin_value()
+    {
+        if (m_after_key)
+        {
+            m_after_key = false;
+            return;
+        }
+        if (m_depth == 0) return;
+        const std::uint64_t bit = 1ULL << (m_depth - 1);
+        if (m_has_elements & bit) m_buffer.push_back(',');
+        m_has_elements |= bit;
+    }
+
+    void json_writer::begin_scope(char open)
+    {
+        if (m_depth == MAX_DEPTH)
+            throw std::length_error("JSON nesting is deeper than json_writer::MAX_DEPTH");
+        begin_value();
+        m_buffer.push_back(open);
+        ++m_depth;
+        m_has_elements &= ~(1ULL << (m_depth - 1));
+    }
+
+    void json_writer::end_scope(char close)
+    {
+        if (m_depth == 0)
+            throw std::logic_error("json_writer: end without a matching begin");
+        --m_depth;
+        m_buffer.push_back(close);
+    }
+
+    json_writer& json_writer::begin_object()
+    {
+        begin_scope('{');
+        return *this;
+    }
+
+    json_writer& json_writer::end_object()
+    {
+        end_scope('}');
+        return *this;
+    }
+
+    json_writer& json_writer::begin_array()
+    {
+        begin_scope('[');
+        return *this;
+    }
+
+    json_writer& json_writer::end_array()
+    {
+        end_scope(']');
+        return *this;
+    }
+
+    json_writer& json_writer::key(std::string_view name)
+    {
+        begin_value();
+        write_escaped(name);
+        m_buffer.push_back(':');
+        m_after_key = true;
+        return *this;
+    }
+
+    json_writer& json_writer::key(std::wstring_view name)
+    {
+        begin_value();
+        write_escaped(name);
+        m_buffer.push_back(':');
+        m_after_key = true;
+        return *this;
+    }
+
+    json_writer& json_writer::value(std::string_view text)
+    {
+        begin_value();
+        write_escaped(text);
+        return *this;
+    }
+
+    json_writer& json_writer::value(std::wstring_view text)
+    {
+        begin_value();
+        write_escaped(text);
+        return *this;
+    }
+
+    json_writer& json_writer::value(bool flag)
+    {
+        begin_value();
+        if (flag) m_buffer.append("true", 4);
+        else m_buffer.append("false", 5);
+        return *this;
+    }
+
+    json_writer& json_writer::null()
+    {
+        begin_value();
+        m_buffer.append("null", 4);
+        return *this;
+    }
+
+    json_writer& json_writer::write_int(long long number)
+    {
+        begin_value();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        m_buffer.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    json_writer& json_writer::write_uint(unsigned long long number)
+    {
+        begin_value();
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), number);
+        m_buffer.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    void json_writer::write_escaped(std::string_view text)
+    {
+        m_buffer.push_back('"');
+        size_t run = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (!needs_escape(text[i])) continue;
+            m_buffer.append(text.data() + run, i - run);
+            append_escape(m_buffer, static_cast<unsigned char>(text[i]));
+            run = i + 1;
+        }
+        m_buffer.append(text.data() + run, text.size() - run);
+        m_buffer.push_back('"');
+    }
+
+    void json_writer::write_escaped(std::wstring_view text)
+    {
+        // runs that need no escaping are transcoded in one call
+        m_buffer.push_back('"');
+        size_t run = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (!needs_escape(text[i])) continue;
+            wide_to_utf8(text.substr(run, i - run), m_buffer, true);
+            append_escape(m_buffer, static_cast<unsigned>(text[i]));
+            run = i + 1;
+        }
+        wide_to_utf8(text.substr(run), m_buffer, true);
+        m_buffer.push_back('"');
+    }
+}
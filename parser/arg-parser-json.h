@@ -0,0 +1,93 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ArgParser {
+    // Streaming JSON writer. Tokens are appended as UTF-8 straight into a caller-owned buffer, so
+    // a buffer that is cleared and reused between records stops allocating once it has grown to
+    // the record size. Commas and colons are inserted automatically; the caller only has to nest
+    // begin/end calls correctly and put a key() before every value inside an object.
+    class json_writer {
+    public:
+        static constexpr unsigned MAX_DEPTH = 64;
+
+        explicit json_writer(std::string& buffer);
+
+        json_writer& begin_object();
+        json_writer& end_object();
+        json_writer& begin_array();
+        json_writer& end_array();
+
+        json_writer& key(std::string_view name);
+        json_writer& key(std::wstring_view name);
+
+        // Narrow strings are expected to be UTF-8, wide strings are transcoded.
+        json_writer& value(std::string_view text);
+        json_writer& value(std::wstring_view text);
+        json_writer& value(const char* text) { return value(std::string_view(text)); }
+        json_writer& value(const wchar_t* text) { return value(std::wstring_view(text)); }
+        json_writer& value(const std::string& text) { return value(std::string_view(text)); }
+        json_writer& value(const std::wstring& text) { return value(std::wstring_view(text)); }
+        json_writer& value(bool flag);
+        template <class T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+        json_writer& value(T number)
+        {
+            if constexpr (std::is_signed_v<T>)
+                return write_int(static_cast<long long>(number));
+            else
+                return write_uint(static_cast<unsigned long long>(number));
+        }
+        json_writer& null();
+
+        unsigned get_depth() const { return m_depth; }
+
+    private:
+        void begin_value();
+        void begin_scope(char open);
+        void end_scope(char close);
+        void write_escaped(std::string_view text);
+        void write_escaped(std::wstring_view text);
+        json_writer& write_int(long long number);
+        json_writer& write_uint(unsigned long long number);
+
+        std::string& m_buffer;
+        std::uint64_t m_has_elements = 0; // one bit per nesting level
+        unsigned m_depth = 0;
+        bool m_after_key = false;
+    };
+}
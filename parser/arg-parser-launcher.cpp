@@ -0,0 +1,289 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-launcher.h"
+#include "arg-parser-utf8.h"
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace ArgParser {
+    namespace {
+        using clock = std::chrono::steady_clock;
+
+        // Waits out the spawn delay from the moment the child was running
+        std::chrono::nanoseconds wait_spawn_delay(clock::time_point exec, const launch_options& options, const cancellation_token* token)
+        {
+            if (options.m_spawn_delay.count() > 0)
+                timeline_scheduler::sleep_until(exec + std::chrono::duration_cast<clock::duration>(options.m_spawn_delay), token);
+            return clock::now() - exec;
+        }
+
+    #ifdef _WIN32
+        std::runtime_error launch_error(const std::wstring& command_line, const char* what)
+        {
+            const DWORD error = GetLastError();
+            std::string command;
+            wide_to_utf8(command_line, command, true);
+            return std::runtime_error(std::string(what) + " " + command + ": " + std::system_category().message(static_cast<int>(error)));
+        }
+    #else
+        std::runtime_error launch_error(const char* program, const char* what, int error)
+        {
+            return std::runtime_error(std::string(what) + " " + program + ": " + std::generic_category().message(error));
+        }
+
+    #ifdef __linux__
+        // Pins the calling thread to a set of CPUs until it goes away; what the thread spawns in
+        // the meantime inherits the set before it runs anything
+        class scoped_thread_affinity {
+        public:
+            explicit scoped_thread_affinity(const std::vector<unsigned>& cores)
+            {
+                if (cores.empty()) return;
+                // the current set has to fit in the buffer, machines can have more CPUs than CPU_SETSIZE
+                for (size_t count = (std::max)(static_cast<size_t>(CPU_SETSIZE), static_cast<size_t>(cores.back()) + 1);; count *= 2)
+                {
+                    m_count = count;
+                    m_previous = CPU_ALLOC(count);
+                    if (sched_getaffinity(0, CPU_ALLOC_SIZE(count), m_previous) == 0) break;
+                    CPU_FREE(m_previous);
+                    m_previous = nullptr;
+                    if (errno != EINVAL || count > (1u << 20))
+                        throw std::system_error(errno, std::generic_category(), "Cannot read the CPU affinity");
+                }
+
+                cpu_set_t* pinned = CPU_ALLOC(m_count);
+                CPU_ZERO_S(CPU_ALLOC_SIZE(m_count), pinned);
+                for (unsigned core : cores) CPU_SET_S(core, CPU_ALLOC_SIZE(m_count), pinned);
+                const int result = sched_setaffinity(0, CPU_ALLOC_SIZE(m_count), pinned);
+                const int error = errno;
+                CPU_FREE(pinned);
+                if (result != 0)
+                {
+                    CPU_FREE(m_previous);
+                    throw std::system_error(error, std::generic_category(), "Cannot pin to the requested cores");
+                }
+            }
+            ~scoped_thread_affinity()
+            {
+                if (m_previous == nullptr) return;
+                sched_setaffinity(0, CPU_ALLOC_SIZE(m_count), m_previous);
+                CPU_FREE(m_previous);
+            }
+            scoped_thread_affinity(const scoped_thread_affinity&) = delete;
+            scoped_thread_affinity& operator=(const scoped_thread_affinity&) = delete;
+
+        private:
+            cpu_set_t* m_previous = nullptr;
+            size_t m_count = 0;
+        };
+    #endif
+    #endif
+    }
+
+    launched_process::~launched_process()
+    {
+        close();
+    }
+
+    launched_process::launched_process(launched_process&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    launched_process& launched_process::operator=(launched_process&& other) noexcept
+    {
+        if (this == &other) return *this;
+        close();
+        m_pid = std::exchange(other.m_pid, 0);
+    #ifdef _WIN32
+        m_process = std::exchange(other.m_process, nullptr);
+    #endif
+        m_is_running = std::exchange(other.m_is_running, false);
+        m_spawn_to_exec = other.m_spawn_to_exec;
+        m_spawn_delay = other.m_spawn_delay;
+        return *this;
+    }
+
+    void launched_process::close()
+    {
+    #ifdef _WIN32
+        if (m_process != nullptr) CloseHandle(m_process);
+        m_process = nullptr;
+    #else
+        // reaps a child that has already exited, so dropping it unwaited leaves no zombie behind
+        if (m_is_running)
+        {
+            int status = 0;
+            while (waitpid(static_cast<pid_t>(m_pid), &status, WNOHANG) < 0 && errno == EINTR) {}
+        }
+    #endif
+        m_is_running = false;
+    }
+
+    int launched_process::wait()
+    {
+        if (!m_is_running)
+            throw std::runtime_error("No child process to wait for.");
+        m_is_running = false;
+    #ifdef _WIN32
+        WaitForSingleObject(m_process, INFINITE);
+        DWORD exit_code = 0;
+        GetExitCodeProcess(m_process, &exit_code);
+        return static_cast<int>(exit_code);
+    #else
+        int status = 0;
+        while (waitpid(static_cast<pid_t>(m_pid), &status, 0) < 0)
+        {
+            if (errno != EINTR)
+                throw std::system_error(errno, std::generic_category(), "Cannot wait for the child process");
+        }
+        if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+        return WEXITSTATUS(status);
+    #endif
+    }
+
+    launched_process launch_process(const launch_options& options, const cancellation_token* token)
+    {
+        launched_process process;
+    #ifdef _WIN32
+        // CreateProcessW may write to the command line
+        std::wstring command_line = options.m_command_line;
+        if (command_line.empty())
+            throw std::runtime_error("No command to launch.");
+
+        GROUP_AFFINITY affinity = {};
+        if (!options.m_cores.empty())
+        {
+            constexpr unsigned GROUP_SIZE = static_cast<unsigned>(sizeof(KAFFINITY) * 8);
+            affinity.Group = static_cast<WORD>(options.m_cores.front() / GROUP_SIZE);
+            for (unsigned core : options.m_cores)
+            {
+                if (core / GROUP_SIZE != affinity.Group)
+                    throw std::runtime_error("The cores to pin a process to have to be in one processor group.");
+                affinity.Mask |= KAFFINITY(1) << (core % GROUP_SIZE);
+            }
+        }
+
+        STARTUPINFOW startup = {};
+        startup.cb = sizeof(startup);
+        PROCESS_INFORMATION info = {};
+        const clock::time_point spawn = clock::now();
+        if (!CreateProcessW(nullptr, command_line.data(), nullptr, nullptr, FALSE, CREATE_SUSPENDED, nullptr, nullptr, &startup, &info))
+            throw launch_error(options.m_command_line, "Cannot start");
+
+        if (affinity.Mask != 0)
+        {
+            const BOOL is_pinned = affinity.Group == 0
+                ? SetProcessAffinityMask(info.hProcess, affinity.Mask)
+                : SetThreadGroupAffinity(info.hThread, &affinity, nullptr);
+            if (!is_pinned)
+            {
+                const std::runtime_error error = launch_error(options.m_command_line, "Cannot pin");
+                TerminateProcess(info.hProcess, 1);
+                CloseHandle(info.hThread);
+                CloseHandle(info.hProcess);
+                throw error;
+            }
+        }
+        ResumeThread(info.hThread);
+        const clock::time_point exec = clock::now();
+        CloseHandle(info.hThread);
+
+        process.m_pid = info.dwProcessId;
+        process.m_process = info.hProcess;
+    #else
+        if (options.m_argv == nullptr || options.m_argv[0] == nullptr)
+            throw std::runtime_error("No command to launch.");
+        const char* program = options.m_argv[0];
+
+    #ifndef __linux__
+        if (!options.m_cores.empty())
+            throw std::runtime_error("Pinning a launched process to cores is only supported on Linux and Windows.");
+    #endif
+
+        int exec_pipe[2];
+        pid_t pid = 0;
+        clock::time_point spawn;
+        int error = 0;
+        {
+    #ifdef __linux__
+            scoped_thread_affinity affinity(options.m_cores);
+            // the write end closes when the child execs (or dies trying), EOF on the read end marks exec
+            if (pipe2(exec_pipe, O_CLOEXEC) != 0)
+                throw launch_error(program, "Cannot start", errno);
+    #else
+            if (pipe(exec_pipe) != 0)
+                throw launch_error(program, "Cannot start", errno);
+            fcntl(exec_pipe[0], F_SETFD, FD_CLOEXEC);
+            fcntl(exec_pipe[1], F_SETFD, FD_CLOEXEC);
+    #endif
+            spawn = clock::now();
+            error = posix_spawnp(&pid, program, nullptr, nullptr, options.m_argv, environ);
+        }
+        ::close(exec_pipe[1]);
+        if (error != 0)
+        {
+            ::close(exec_pipe[0]);
+            throw launch_error(program, "Cannot start", error);
+        }
+
+        char byte;
+        while (read(exec_pipe[0], &byte, 1) < 0 && errno == EINTR) {}
+        const clock::time_point exec = clock::now();
+        ::close(exec_pipe[0]);
+
+        process.m_pid = static_cast<unsigned long>(pid);
+    #endif
+        process.m_is_running = true;
+        process.m_spawn_to_exec = exec - spawn;
+        process.m_spawn_delay = wait_spawn_delay(exec, options, token);
+        return process;
+    }
+}
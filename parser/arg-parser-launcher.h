@@ -0,0 +1,100 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "arg-parser-scheduler.h"
+
+namespace ArgParser {
+    // What `record` starts, see arg_parser::get_launch_options
+    struct launch_options {
+        // argv of the child, nullptr terminated; a program without a '/' is looked up on PATH (POSIX)
+        char* const* m_argv = nullptr;
+        // the same command as one command line (Windows)
+        std::wstring m_command_line;
+        // the CPUs the child runs on from its first instruction, empty to inherit the parent's
+        std::vector<unsigned> m_cores;
+        // how long launch_process waits once the child runs the new image
+        std::chrono::nanoseconds m_spawn_delay{ 0 };
+    };
+
+    class launched_process;
+
+    // Starts the command with its CPU affinity in place before it runs a single instruction, then
+    // waits out the spawn delay against an absolute deadline from exec, ending early when token is
+    // cancelled. Throws std::runtime_error when the command cannot be started or pinned.
+    //
+    // On Linux the child comes from posix_spawnp, which hands it the affinity of the calling
+    // thread: that thread is pinned to the cores for the duration of the call. A close-on-exec
+    // pipe reports the moment the new image replaced the child. On Windows the process is created
+    // suspended, pinned with SetProcessAffinityMask (SetThreadGroupAffinity outside group 0) and
+    // resumed; the cores have to be in one processor group.
+    launched_process launch_process(const launch_options& options, const cancellation_token* token = nullptr);
+
+    // A child started by launch_process. It is not killed when this goes away; wait() reaps it.
+    // On POSIX, going away reaps a child that has already exited, but one that is still running
+    // stays a zombie from its exit until wperf exits unless wait() was called.
+    class launched_process {
+    public:
+        launched_process() = default;
+        ~launched_process();
+        launched_process(launched_process&& other) noexcept;
+        launched_process& operator=(launched_process&& other) noexcept;
+        launched_process(const launched_process&) = delete;
+        launched_process& operator=(const launched_process&) = delete;
+
+        unsigned long get_pid() const { return m_pid; }
+        // Waits for the child to exit and returns its exit code, 128 + the signal number for a
+        // POSIX child killed by a signal. Throws std::runtime_error when there is no child.
+        int wait();
+        // From the spawn call until the child was running the new image (POSIX) or was resumed (Windows)
+        std::chrono::nanoseconds get_spawn_to_exec() const { return m_spawn_to_exec; }
+        // The spawn delay as it was waited, from exec until launch_process returned
+        std::chrono::nanoseconds get_spawn_delay() const { return m_spawn_delay; }
+
+    private:
+        friend launched_process launch_process(const launch_options& options, const cancellation_token* token);
+
+        void close();
+
+        unsigned long m_pid = 0;
+    #ifdef _WIN32
+        void* m_process = nullptr;
+    #endif
+        bool m_is_running = false;
+        std::chrono::nanoseconds m_spawn_to_exec{ 0 };
+        std::chrono::nanoseconds m_spawn_delay{ 0 };
+    };
+}
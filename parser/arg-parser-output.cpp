@@ -0,0 +1,97 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-output.h"
+#include <stdexcept>
+
+namespace ArgParser {
+    void stream_sink::write(const char* data, size_t size)
+    {
+        std::fwrite(data, 1, size, m_stream);
+    }
+
+    void stream_sink::flush()
+    {
+        std::fflush(m_stream);
+    }
+
+    file_sink::file_sink(const std::filesystem::path& path)
+    {
+#ifdef _WIN32
+        if (_wfopen_s(&m_file, path.c_str(), L"wb") != 0) m_file = nullptr;
+#else
+        m_file = std::fopen(path.c_str(), "wb");
+#endif
+        if (m_file == nullptr)
+            throw std::runtime_error("Cannot open " + path.u8string() + " for writing.");
+        // writes arrive in large chunks already, a second buffer in the C runtime would only copy them
+        std::setvbuf(m_file, nullptr, _IONBF, 0);
+    }
+
+    file_sink::~file_sink()
+    {
+        std::fclose(m_file);
+    }
+
+    void file_sink::write(const char* data, size_t size)
+    {
+        std::fwrite(data, 1, size, m_file);
+    }
+
+    void file_sink::flush()
+    {
+        std::fflush(m_file);
+    }
+
+    void buffer_sink::write(const char* data, size_t size)
+    {
+        m_buffer.append(data, size);
+    }
+
+    output_sink& get_stdout_sink()
+    {
+        static stream_sink sink(stdout);
+        return sink;
+    }
+
+    output_sink& get_stderr_sink()
+    {
+        static stream_sink sink(stderr);
+        return sink;
+    }
+
+    output_sink& get_null_sink()
+    {
+        static null_sink sink;
+        return sink;
+    }
+}
@@ -0,0 +1,102 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+namespace ArgParser {
+    // Destination for UTF-8 text. Sinks are handed whole chunks by utf8_writer, which does the
+    // buffering, so an implementation can pass each write straight to the OS.
+    class output_sink {
+    public:
+        virtual ~output_sink() = default;
+
+        virtual void write(const char* data, size_t size) = 0;
+        virtual void flush() {}
+        // false for sinks that drop everything, writers then skip transcoding as well
+        virtual bool is_enabled() const { return true; }
+    };
+
+    // A C stream such as stdout or stderr; the stream stays owned by the caller
+    class stream_sink : public output_sink {
+    public:
+        explicit stream_sink(FILE* stream) : m_stream(stream) {}
+
+        void write(const char* data, size_t size) override;
+        void flush() override;
+
+    private:
+        FILE* m_stream;
+    };
+
+    // Creates or truncates the file, throws std::runtime_error when it cannot be opened
+    class file_sink : public output_sink {
+    public:
+        explicit file_sink(const std::filesystem::path& path);
+        ~file_sink() override;
+        file_sink(const file_sink&) = delete;
+        file_sink& operator=(const file_sink&) = delete;
+
+        void write(const char* data, size_t size) override;
+        void flush() override;
+
+    private:
+        FILE* m_file;
+    };
+
+    // Collects everything in memory, for embedding applications, tests and the daemon
+    class buffer_sink : public output_sink {
+    public:
+        void write(const char* data, size_t size) override;
+
+        const std::string& get_buffer() const { return m_buffer; }
+        void clear() { m_buffer.clear(); }
+
+    private:
+        std::string m_buffer;
+    };
+
+    // Drops everything, used for -q
+    class null_sink : public output_sink {
+    public:
+        void write(const char*, size_t) override {}
+        bool is_enabled() const override { return false; }
+    };
+
+    // Process-wide sinks, thread-safe as far as the C streams below them are
+    output_sink& get_stdout_sink();
+    output_sink& get_stderr_sink();
+    output_sink& get_null_sink();
+}
@@ -0,0 +1,152 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "arg-parser-path-validator.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+namespace ArgParser {
+    bool probe_file_system(const std::wstring& path)
+    {
+        std::error_code error;
+        return std::filesystem::exists(std::filesystem::path(path), error);
+    }
+
+    path_probe_cache::path_probe_cache(std::chrono::milliseconds ttl) : m_ttl(ttl) {}
+
+    path_probe_cache& path_probe_cache::instance()
+    {
+        static path_probe_cache cache;
+        return cache;
+    }
+
+    bool path_probe_cache::lookup(const std::wstring& path, bool& exists)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_entries.find(path);
+        if (found == m_entries.end())
+            return false;
+        if (found->second.m_expiry <= std::chrono::steady_clock::now())
+        {
+            m_entries.erase(found);
+            return false;
+        }
+        exists = found->second.m_exists;
+        return true;
+    }
+
+    void path_probe_cache::store(const std::wstring& path, bool exists)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries[path] = { exists, std::chrono::steady_clock::now() + m_ttl };
+    }
+
+    void path_probe_cache::set_ttl(std::chrono::milliseconds ttl)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ttl = ttl;
+    }
+
+    void path_probe_cache::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+    }
+
+    std::vector<std::wstring> probe_paths(
+        const std::vector<std::wstring>& paths,
+        const path_probe& probe,
+        path_probe_cache* cache,
+        size_t max_workers
+    )
+    {
+        // 0: missing, 1: exists. Filled from the cache first, the rest is probed below.
+        std::vector<char> exists(paths.size(), 0);
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            bool cached = false;
+            if (cache != nullptr && cache->lookup(paths[i], cached))
+                exists[i] = cached;
+            else
+                pending.push_back(i);
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t job = next++; job < pending.size(); job = next++)
+            {
+                const size_t index = pending[job];
+                bool found = false;
+                try
+                {
+                    found = probe(paths[index]);
+                }
+                catch (...)
+                {
+                    // a probe that fails is reported as a missing path
+                }
+                exists[index] = found;
+                if (cache != nullptr)
+                    cache->store(paths[index], found);
+            }
+        };
+
+        // The workers only live for this call: a process-wide pool would outlive the module
+        // when the parser is linked into a DLL, and thread start-up is cheap next to one
+        // stat on a network share.
+        const size_t worker_count = (std::min)((std::max<size_t>)(max_workers, 1), pending.size());
+        {
+            struct thread_joiner {
+                std::vector<std::thread> m_threads;
+                ~thread_joiner()
+                {
+                    // join on every exit path: destroying a joinable thread calls std::terminate
+                    for (auto& thread : m_threads)
+                        thread.join();
+                }
+            } workers;
+            workers.m_threads.reserve(worker_count);
+            for (size_t i = 1; i < worker_count; ++i)
+                workers.m_threads.emplace_back(worker);
+            worker();
+        }
+
+        std::vector<std::wstring> missing;
+        for (size_t i = 0; i < paths.size(); ++i)
+        {
+            if (!exists[i]) missing.push_back(paths[i]);
+        }
+        return missing;
+    }
+}
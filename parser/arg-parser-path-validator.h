@@ -0,0 +1,81 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ArgParser {
+    // Returns true when the path exists. Probes may be called concurrently from several threads.
+    typedef std::function<bool(const std::wstring&)> path_probe;
+
+    bool probe_file_system(const std::wstring& path);
+
+    // Memoizes probe results for a limited time, so repeated invocations in one process do not
+    // hit slow (network) file systems again for the same path.
+    class path_probe_cache {
+    public:
+        explicit path_probe_cache(std::chrono::milliseconds ttl = std::chrono::seconds(5));
+
+        static path_probe_cache& instance();
+
+        bool lookup(const std::wstring& path, bool& exists);
+        void store(const std::wstring& path, bool exists);
+        void set_ttl(std::chrono::milliseconds ttl);
+        void clear();
+
+    private:
+        struct entry {
+            bool m_exists;
+            std::chrono::steady_clock::time_point m_expiry;
+        };
+
+        std::mutex m_mutex;
+        std::chrono::milliseconds m_ttl;
+        std::unordered_map<std::wstring, entry> m_entries;
+    };
+
+    constexpr size_t MAX_PATH_PROBE_WORKERS = 4;
+
+    // Probes every path, at most max_workers at a time, and returns the missing ones in input
+    // order. Paths found in the cache are not probed again; pass nullptr to bypass the cache.
+    std::vector<std::wstring> probe_paths(
+        const std::vector<std::wstring>& paths,
+        const path_probe& probe,
+        path_probe_cache* cache,
+        size_t max_workers = MAX_PATH_PROBE_WORKERS
+    );
+}
@@ -0,0 +1,241 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "arg-parser-result.h"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace ArgParser {
+    namespace {
+        constexpr size_t RESULT_ALIGNMENT = alignof(std::uint64_t);
+
+        size_t align_up(size_t value)
+        {
+            return (value + RESULT_ALIGNMENT - 1) & ~(RESULT_ALIGNMENT - 1);
+        }
+
+        std::uint32_t to_u32(size_t value)
+        {
+            if (value > std::numeric_limits<std::uint32_t>::max())
+                throw std::length_error("Parse result does not fit in a 32-bit blob.");
+            return static_cast<std::uint32_t>(value);
+        }
+
+        struct result_layout {
+            size_t m_value_count = 0;
+            size_t m_pool_length = 0;
+            size_t m_bitset_offset = 0;
+            size_t m_flags_offset = 0;
+            size_t m_values_offset = 0;
+            size_t m_pool_offset = 0;
+            size_t m_total_size = 0;
+        };
+
+        result_layout compute_layout(const std::vector<arg_parser_arg*>& flags)
+        {
+            result_layout layout;
+            for (auto& flag : flags)
+            {
+                layout.m_pool_length += flag->m_name.size() + 1;
+                layout.m_value_count += flag->get_value_count();
+                for (size_t i = 0; i < flag->get_value_count(); ++i)
+                    layout.m_pool_length += flag->get_value(i).size() + 1;
+            }
+
+            layout.m_bitset_offset = align_up(sizeof(parse_result_header));
+            layout.m_flags_offset = layout.m_bitset_offset + align_up(((flags.size() + 63) / 64) * sizeof(std::uint64_t));
+            layout.m_values_offset = layout.m_flags_offset + align_up(flags.size() * sizeof(parse_result_flag));
+            layout.m_pool_offset = layout.m_values_offset + align_up(layout.m_value_count * sizeof(parse_result_value));
+            layout.m_total_size = align_up(layout.m_pool_offset + layout.m_pool_length * sizeof(wchar_t));
+            return layout;
+        }
+    }
+
+    size_t write_parse_result(const arg_parser& parser, void* buffer, size_t buffer_size)
+    {
+        const auto& flags = parser.m_flags_list;
+        const result_layout layout = compute_layout(flags);
+        if (buffer == nullptr || buffer_size < layout.m_total_size)
+            return layout.m_total_size;
+
+        std::uint8_t* data = static_cast<std::uint8_t*>(buffer);
+        std::memset(data, 0, layout.m_total_size);
+
+        parse_result_header header = {};
+        header.m_magic = PARSE_RESULT_MAGIC;
+        header.m_version = PARSE_RESULT_VERSION;
+        header.m_char_size = static_cast<std::uint16_t>(sizeof(wchar_t));
+        header.m_total_size = to_u32(layout.m_total_size);
+        header.m_command = static_cast<std::uint32_t>(parser.m_command);
+        header.m_flag_count = to_u32(flags.size());
+        header.m_value_count = to_u32(layout.m_value_count);
+        header.m_bitset_offset = to_u32(layout.m_bitset_offset);
+        header.m_flags_offset = to_u32(layout.m_flags_offset);
+        header.m_values_offset = to_u32(layout.m_values_offset);
+        header.m_pool_offset = to_u32(layout.m_pool_offset);
+        header.m_pool_length = to_u32(layout.m_pool_length);
+        std::memcpy(data, &header, sizeof(header));
+
+        std::uint64_t* bitset = reinterpret_cast<std::uint64_t*>(data + layout.m_bitset_offset);
+        parse_result_flag* flag_table = reinterpret_cast<parse_result_flag*>(data + layout.m_flags_offset);
+        parse_result_value* value_table = reinterpret_cast<parse_result_value*>(data + layout.m_values_offset);
+        wchar_t* pool = reinterpret_cast<wchar_t*>(data + layout.m_pool_offset);
+
+        size_t pool_pos = 0;
+        auto append_string = [&](const std::wstring& str) {
+            parse_result_string entry = { to_u32(pool_pos), to_u32(str.size()) };
+            std::memcpy(pool + pool_pos, str.data(), str.size() * sizeof(wchar_t));
+            pool_pos += str.size() + 1; // the terminator is already zeroed
+            return entry;
+        };
+
+        size_t value_pos = 0;
+        for (size_t i = 0; i < flags.size(); ++i)
+        {
+            const arg_parser_arg& flag = *flags[i];
+            if (flag.m_is_parsed)
+                bitset[i / 64] |= std::uint64_t(1) << (i % 64);
+
+            flag_table[i].m_name = append_string(flag.m_name);
+            flag_table[i].m_first_value = to_u32(value_pos);
+            flag_table[i].m_value_count = to_u32(flag.get_value_count());
+            for (size_t value = 0; value < flag.get_value_count(); ++value)
+                value_table[value_pos++] = append_string(flag.get_value(value));
+        }
+
+        return layout.m_total_size;
+    }
+
+    std::vector<std::uint8_t> export_parse_result(const arg_parser& parser)
+    {
+        std::vector<std::uint8_t> blob(write_parse_result(parser, nullptr, 0));
+        write_parse_result(parser, blob.data(), blob.size());
+        return blob;
+    }
+
+    parse_result_view::parse_result_view(const void* data, size_t size)
+        : m_data(static_cast<const std::uint8_t*>(data))
+    {
+        if (m_data == nullptr || size < sizeof(parse_result_header))
+            throw std::invalid_argument("Parse result blob is too small.");
+        if (reinterpret_cast<std::uintptr_t>(m_data) % RESULT_ALIGNMENT != 0)
+            throw std::invalid_argument("Parse result blob is not 8-byte aligned.");
+
+        m_header = reinterpret_cast<const parse_result_header*>(m_data);
+        if (m_header->m_magic != PARSE_RESULT_MAGIC || m_header->m_version != PARSE_RESULT_VERSION)
+            throw std::invalid_argument("Parse result blob has an unknown format.");
+        if (m_header->m_char_size != sizeof(wchar_t))
+            throw std::invalid_argument("Parse result blob was written with a different wchar_t size.");
+        if (m_header->m_total_size > size)
+            throw std::invalid_argument("Parse result blob is truncated.");
+
+        const size_t flag_count = m_header->m_flag_count;
+        const size_t value_count = m_header->m_value_count;
+        const size_t total_size = m_header->m_total_size;
+        auto check_section = [total_size](size_t offset, size_t bytes) {
+            if (offset % RESULT_ALIGNMENT != 0 || offset > total_size || bytes > total_size - offset)
+                throw std::invalid_argument("Parse result blob has an invalid section.");
+        };
+        check_section(m_header->m_bitset_offset, ((flag_count + 63) / 64) * sizeof(std::uint64_t));
+        check_section(m_header->m_flags_offset, flag_count * sizeof(parse_result_flag));
+        check_section(m_header->m_values_offset, value_count * sizeof(parse_result_value));
+        check_section(m_header->m_pool_offset, size_t(m_header->m_pool_length) * sizeof(wchar_t));
+
+        m_bitset = reinterpret_cast<const std::uint64_t*>(m_data + m_header->m_bitset_offset);
+        m_flags = reinterpret_cast<const parse_result_flag*>(m_data + m_header->m_flags_offset);
+        m_values = reinterpret_cast<const parse_result_value*>(m_data + m_header->m_values_offset);
+        m_pool = reinterpret_cast<const wchar_t*>(m_data + m_header->m_pool_offset);
+
+        // Validate every table entry up front so the accessors never have to.
+        const size_t pool_length = m_header->m_pool_length;
+        auto check_string = [pool_length](const parse_result_string& str) {
+            if (str.m_offset > pool_length || str.m_length >= pool_length - str.m_offset)
+                throw std::invalid_argument("Parse result blob has an invalid string.");
+        };
+        for (size_t i = 0; i < flag_count; ++i)
+        {
+            check_string(m_flags[i].m_name);
+            if (m_flags[i].m_first_value > value_count || m_flags[i].m_value_count > value_count - m_flags[i].m_first_value)
+                throw std::invalid_argument("Parse result blob has an invalid value range.");
+        }
+        for (size_t i = 0; i < value_count; ++i)
+            check_string(m_values[i]);
+    }
+
+    COMMAND_CLASS parse_result_view::get_command() const
+    {
+        return static_cast<COMMAND_CLASS>(m_header->m_command);
+    }
+
+    size_t parse_result_view::get_flag_count() const
+    {
+        return m_header->m_flag_count;
+    }
+
+    bool parse_result_view::is_flag_parsed(size_t flag_index) const
+    {
+        if (flag_index >= get_flag_count()) return false;
+        return (m_bitset[flag_index / 64] >> (flag_index % 64)) & 1;
+    }
+
+    std::wstring_view parse_result_view::get_flag_name(size_t flag_index) const
+    {
+        if (flag_index >= get_flag_count()) throw std::out_of_range("Flag index out of range.");
+        return get_string(m_flags[flag_index].m_name);
+    }
+
+    size_t parse_result_view::get_value_count(size_t flag_index) const
+    {
+        if (flag_index >= get_flag_count()) return 0;
+        return m_flags[flag_index].m_value_count;
+    }
+
+    std::wstring_view parse_result_view::get_value(size_t flag_index, size_t value_index) const
+    {
+        if (value_index >= get_value_count(flag_index)) throw std::out_of_range("Value index out of range.");
+        return get_string(m_values[m_flags[flag_index].m_first_value + value_index]);
+    }
+
+    size_t parse_result_view::find_flag(std::wstring_view name) const
+    {
+        for (size_t i = 0; i < get_flag_count(); ++i)
+        {
+            if (get_string(m_flags[i].m_name) == name) return i;
+        }
+        return get_flag_count();
+    }
+
+    std::wstring_view parse_result_view::get_string(const parse_result_string& str) const
+    {
+        return std::wstring_view(m_pool + str.m_offset, str.m_length);
+    }
+}
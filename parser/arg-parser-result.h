@@ -0,0 +1,115 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "arg-parser.h"
+
+namespace ArgParser {
+    // Flat, trivially copyable snapshot of a parsed command line. The blob is laid out as
+    //
+    //   parse_result_header | flag bitset words | parse_result_flag[] | parse_result_value[] | string pool
+    //
+    // All offsets are in bytes from the start of the blob, so it can be written once into
+    // shared memory (or a pipe) and read in place by another process with parse_result_view.
+    constexpr std::uint32_t PARSE_RESULT_MAGIC = 0x52505057; // "WPPR"
+    constexpr std::uint16_t PARSE_RESULT_VERSION = 1;
+
+    struct parse_result_header {
+        std::uint32_t m_magic;
+        std::uint16_t m_version;
+        std::uint16_t m_char_size;      // sizeof(wchar_t) of the writer, pools are not portable across it
+        std::uint32_t m_total_size;
+        std::uint32_t m_command;        // COMMAND_CLASS
+        std::uint32_t m_flag_count;
+        std::uint32_t m_value_count;
+        std::uint32_t m_bitset_offset;
+        std::uint32_t m_flags_offset;
+        std::uint32_t m_values_offset;
+        std::uint32_t m_pool_offset;
+        std::uint32_t m_pool_length;    // in characters
+        std::uint32_t m_reserved;
+    };
+
+    struct parse_result_string {
+        std::uint32_t m_offset;         // in characters from the start of the pool
+        std::uint32_t m_length;         // in characters, the pool entry is also null terminated
+    };
+
+    struct parse_result_flag {
+        parse_result_string m_name;
+        std::uint32_t m_first_value;
+        std::uint32_t m_value_count;
+    };
+
+    typedef parse_result_string parse_result_value;
+
+    static_assert(std::is_trivially_copyable<parse_result_header>::value, "parse_result_header must be trivially copyable");
+    static_assert(std::is_trivially_copyable<parse_result_flag>::value, "parse_result_flag must be trivially copyable");
+    static_assert(std::is_trivially_copyable<parse_result_value>::value, "parse_result_value must be trivially copyable");
+
+    // Returns the number of bytes needed to hold the blob. When buffer_size is large enough
+    // the blob is also written into buffer, otherwise buffer is left untouched.
+    size_t write_parse_result(const arg_parser& parser, void* buffer, size_t buffer_size);
+    std::vector<std::uint8_t> export_parse_result(const arg_parser& parser);
+
+    // Zero-copy reader over a blob produced by write_parse_result. Construction validates
+    // the header and the tables once; accessors afterwards are plain pointer arithmetic.
+    class parse_result_view {
+    public:
+        parse_result_view(const void* data, size_t size);
+
+        COMMAND_CLASS get_command() const;
+        size_t get_flag_count() const;
+        bool is_flag_parsed(size_t flag_index) const;
+        std::wstring_view get_flag_name(size_t flag_index) const;
+        size_t get_value_count(size_t flag_index) const;
+        std::wstring_view get_value(size_t flag_index, size_t value_index) const;
+
+        // Returns get_flag_count() when no flag has this name.
+        size_t find_flag(std::wstring_view name) const;
+
+    private:
+        std::wstring_view get_string(const parse_result_string& str) const;
+
+        const std::uint8_t* m_data;
+        const parse_result_header* m_header;
+        const std::uint64_t* m_bitset;
+        const parse_result_flag* m_flags;
+        const parse_result_value* m_values;
+        const wchar_t* m_pool;
+    };
+}
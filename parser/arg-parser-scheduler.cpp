@@ -0,0 +1,220 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-scheduler.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <csignal>
+#include <ctime>
+#endif
+
+namespace ArgParser {
+    namespace {
+        using clock = timeline_scheduler::clock;
+        using std::chrono::nanoseconds;
+
+        // Deadlines of an UNTIL_CANCELLED schedule run past the end of the clock, they stop there
+        nanoseconds saturating_add(nanoseconds a, nanoseconds b)
+        {
+            return a > (nanoseconds::max)() - b ? (nanoseconds::max)() : a + b;
+        }
+
+        nanoseconds saturating_multiply(nanoseconds a, size_t factor)
+        {
+            if (factor == 0 || a.count() == 0) return nanoseconds(0);
+            if (static_cast<unsigned long long>(a.count()) > static_cast<unsigned long long>((nanoseconds::max)().count()) / factor)
+                return (nanoseconds::max)();
+            return a * static_cast<long long>(factor);
+        }
+
+        clock::time_point deadline_at(clock::time_point start, nanoseconds offset)
+        {
+            if (offset > (clock::time_point::max)() - start) return (clock::time_point::max)();
+            return start + std::chrono::duration_cast<clock::duration>(offset);
+        }
+
+        std::atomic<cancellation_token*> g_interrupt_token{ nullptr };
+
+    #ifdef _WIN32
+        BOOL WINAPI on_console_event(DWORD event)
+        {
+            if (event != CTRL_C_EVENT && event != CTRL_BREAK_EVENT) return FALSE;
+            if (cancellation_token* token = g_interrupt_token.load()) token->cancel();
+            return TRUE;
+        }
+
+        // One timer per thread, high resolution where the system has it (Windows 10 1803 on)
+        struct waitable_timer {
+            waitable_timer()
+            {
+                m_handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+                if (m_handle == nullptr) m_handle = CreateWaitableTimerW(nullptr, TRUE, nullptr);
+            }
+            ~waitable_timer()
+            {
+                if (m_handle != nullptr) CloseHandle(m_handle);
+            }
+            HANDLE m_handle;
+        };
+
+        void sleep_until_deadline(clock::time_point deadline)
+        {
+            static thread_local waitable_timer timer;
+            const auto remaining = std::chrono::duration_cast<nanoseconds>(deadline - clock::now());
+            if (remaining.count() <= 0) return;
+            // Absolute due times follow the system clock, which can be set back or forward, so the
+            // timer gets the time left on the monotonic clock and sleep_until re-checks the deadline.
+            // Relative due times are negative, in 100 ns units; an hour at a time keeps it in range.
+            LARGE_INTEGER due;
+            due.QuadPart = -static_cast<LONGLONG>((std::min)(remaining, nanoseconds(std::chrono::hours(1))).count() / 100);
+            if (timer.m_handle == nullptr || due.QuadPart == 0 || !SetWaitableTimer(timer.m_handle, &due, 0, nullptr, nullptr, FALSE))
+            {
+                std::this_thread::sleep_until(deadline);
+                return;
+            }
+            WaitForSingleObject(timer.m_handle, INFINITE);
+        }
+    #else
+        struct sigaction g_previous_action;
+
+        extern "C" void on_interrupt(int)
+        {
+            if (cancellation_token* token = g_interrupt_token.load()) token->cancel();
+        }
+
+        void sleep_until_deadline(clock::time_point deadline)
+        {
+        #ifdef __linux__
+            // steady_clock is CLOCK_MONOTONIC, so its time points are absolute deadlines as they are;
+            // a signal ends the sleep with EINTR and the caller looks at its token again
+            const auto since_epoch = std::chrono::duration_cast<nanoseconds>(deadline.time_since_epoch()).count();
+            timespec due;
+            due.tv_sec = static_cast<time_t>(since_epoch / 1'000'000'000);
+            due.tv_nsec = static_cast<long>(since_epoch % 1'000'000'000);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, nullptr);
+        #else
+            std::this_thread::sleep_until(deadline);
+        #endif
+        }
+    #endif
+    }
+
+    interrupt_guard::interrupt_guard(cancellation_token& token)
+    {
+        cancellation_token* expected = nullptr;
+        if (!g_interrupt_token.compare_exchange_strong(expected, &token))
+            throw std::logic_error("An interrupt_guard is already installed.");
+    #ifdef _WIN32
+        SetConsoleCtrlHandler(on_console_event, TRUE);
+    #else
+        struct sigaction action = {};
+        action.sa_handler = on_interrupt;
+        sigemptyset(&action.sa_mask);
+        // no SA_RESTART: an interrupted sleep returns at once
+        action.sa_flags = 0;
+        sigaction(SIGINT, &action, &g_previous_action);
+    #endif
+    }
+
+    interrupt_guard::~interrupt_guard()
+    {
+    #ifdef _WIN32
+        SetConsoleCtrlHandler(on_console_event, FALSE);
+    #else
+        sigaction(SIGINT, &g_previous_action, nullptr);
+    #endif
+        g_interrupt_token.store(nullptr);
+    }
+
+    timeline_scheduler::timeline_scheduler(const timeline_schedule& schedule, const cancellation_token* token)
+        : m_schedule(schedule), m_token(token)
+    {
+    }
+
+    timeline_run timeline_scheduler::run(const window_callback& on_start, const window_callback& on_stop) const
+    {
+        timeline_run result;
+        const bool is_bounded = m_schedule.m_iterations != 0;
+        if (is_bounded) result.m_iterations.reserve(m_schedule.m_iterations);
+        const nanoseconds period = saturating_add(m_schedule.m_window, m_schedule.m_interval);
+
+        result.m_start = clock::now();
+        for (size_t iteration = 0; !is_bounded || iteration < m_schedule.m_iterations; ++iteration)
+        {
+            timeline_iteration record;
+            record.m_intended_start = saturating_multiply(period, iteration);
+            record.m_intended_end = saturating_add(record.m_intended_start, m_schedule.m_window);
+            if (!sleep_until(deadline_at(result.m_start, record.m_intended_start), m_token))
+            {
+                result.m_is_cancelled = true;
+                break;
+            }
+            record.m_actual_start = clock::now() - result.m_start;
+            on_start(iteration);
+
+            const bool is_completed = sleep_until(deadline_at(result.m_start, record.m_intended_end), m_token);
+            record.m_actual_end = clock::now() - result.m_start;
+            on_stop(iteration);
+            result.m_iterations.push_back(record);
+            if (!is_completed)
+            {
+                result.m_is_cancelled = true;
+                break;
+            }
+        }
+        return result;
+    }
+
+    bool timeline_scheduler::sleep_until(clock::time_point deadline, const cancellation_token* token)
+    {
+        for (;;)
+        {
+            if (token != nullptr && token->is_cancelled()) return false;
+            const clock::time_point now = clock::now();
+            if (now >= deadline) return true;
+            // without a token there is nothing to wake up for before the deadline
+            const bool is_near = token == nullptr || deadline - now <= MAX_SLEEP;
+            sleep_until_deadline(is_near ? deadline : now + MAX_SLEEP);
+        }
+    }
+}
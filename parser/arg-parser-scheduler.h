@@ -0,0 +1,128 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace ArgParser {
+    // The timeline loop described by -t, -i, -n and --timeout, see arg_parser::get_timeline_schedule
+    struct timeline_schedule {
+        static constexpr std::chrono::nanoseconds UNTIL_CANCELLED = (std::chrono::nanoseconds::max)();
+        // -i when it is not given
+        static constexpr std::chrono::nanoseconds DEFAULT_INTERVAL = std::chrono::seconds(60);
+
+        // how long each count lasts
+        std::chrono::nanoseconds m_window = UNTIL_CANCELLED;
+        // the pause between the end of one count and the start of the next
+        std::chrono::nanoseconds m_interval{ 0 };
+        // number of counts, 0 to count until cancelled
+        size_t m_iterations = 1;
+    };
+
+    // Stops a timeline_scheduler run from another thread or from a Ctrl+C handler; cancel() is a
+    // lock-free atomic store and safe to call from a signal handler.
+    class cancellation_token {
+    public:
+        void cancel() noexcept { m_is_cancelled.store(true, std::memory_order_release); }
+        bool is_cancelled() const noexcept { return m_is_cancelled.load(std::memory_order_acquire); }
+        void reset() noexcept { m_is_cancelled.store(false, std::memory_order_release); }
+
+    private:
+        static_assert(std::atomic<bool>::is_always_lock_free, "cancel() has to be async-signal-safe");
+        std::atomic<bool> m_is_cancelled{ false };
+    };
+
+    // Cancels a token on Ctrl+C while it lives: SIGINT on POSIX, the console control handler on
+    // Windows. The previous handling comes back with the destructor. Guards do not nest, a second
+    // one throws std::logic_error while the first is alive.
+    class interrupt_guard {
+    public:
+        explicit interrupt_guard(cancellation_token& token);
+        ~interrupt_guard();
+        interrupt_guard(const interrupt_guard&) = delete;
+        interrupt_guard& operator=(const interrupt_guard&) = delete;
+    };
+
+    // One count window as it was scheduled and as it happened, measured from the start of the run
+    struct timeline_iteration {
+        std::chrono::nanoseconds m_intended_start;
+        std::chrono::nanoseconds m_actual_start;
+        std::chrono::nanoseconds m_intended_end;
+        std::chrono::nanoseconds m_actual_end;
+    };
+
+    struct timeline_run {
+        std::chrono::steady_clock::time_point m_start;
+        std::vector<timeline_iteration> m_iterations;
+        bool m_is_cancelled = false;
+    };
+
+    // Runs the windows of a timeline_schedule against absolute deadlines on the monotonic clock.
+    // Window k is due to open k * (window + interval) after the run starts and to close one window
+    // later, whatever the earlier windows and callbacks cost, so a late wakeup delays one boundary
+    // and is never carried into the next. A window that opens late still closes on time.
+    //
+    // On Linux sleeps are absolute (clock_nanosleep with TIMER_ABSTIME). Windows only takes absolute
+    // due times on the wall clock, so there the high resolution waitable timer is armed with the time
+    // left to the deadline, recomputed on every wakeup until the deadline has passed. Either way the
+    // sleep wakes at least every MAX_SLEEP to look at the cancellation token; on Linux a SIGINT ends
+    // the sleep at once.
+    //
+    //   cancellation_token token;
+    //   interrupt_guard guard(token);
+    //   timeline_scheduler scheduler(parser.get_timeline_schedule(), &token);
+    //   timeline_run run = scheduler.run(start_counting, stop_and_read_counters);
+    class timeline_scheduler {
+    public:
+        using clock = std::chrono::steady_clock;
+        typedef std::function<void(size_t iteration)> window_callback;
+
+        static constexpr std::chrono::milliseconds MAX_SLEEP{ 50 };
+
+        explicit timeline_scheduler(const timeline_schedule& schedule, const cancellation_token* token = nullptr);
+
+        // Calls on_start as each window opens and on_stop as it closes, also for a window cut short
+        // by cancellation, and records every window. Returns once the schedule is done or cancelled.
+        timeline_run run(const window_callback& on_start, const window_callback& on_stop) const;
+
+        // Sleeps until deadline; false as soon as the token is cancelled, which may be null
+        static bool sleep_until(clock::time_point deadline, const cancellation_token* token);
+
+    private:
+        timeline_schedule m_schedule;
+        const cancellation_token* m_token;
+    };
+}
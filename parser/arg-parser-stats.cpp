@@ -0,0 +1,87 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "arg-parser-stats.h"
+
+namespace ArgParser {
+    void parse_stats::reset()
+    {
+        *this = parse_stats();
+    }
+
+    void parse_stats::write_json(json_writer& json) const
+    {
+        json.begin_object()
+            .key("enabled").value(parse_stats_enabled())
+            .key("tokens").value(m_tokens)
+            .key("flag_probes").value(m_flag_probes)
+            .key("check_calls").value(m_check_calls)
+            .key("phases").begin_object();
+        for (size_t i = 0; i < PARSE_PHASE_COUNT; ++i)
+        {
+            json.key(get_parse_phase_name(static_cast<PARSE_PHASE>(i))).begin_object()
+                .key("calls").value(m_phase_calls[i])
+                .key("ns").value(m_phase_ns[i])
+                .end_object();
+        }
+        json.end_object().end_object();
+    }
+
+    std::string parse_stats::to_json() const
+    {
+        std::string buffer;
+        json_writer json(buffer);
+        write_json(json);
+        return buffer;
+    }
+
+    bool parse_stats_enabled()
+    {
+    #ifdef ARG_PARSER_ENABLE_STATS
+        return true;
+    #else
+        return false;
+    #endif
+    }
+
+    const wchar_t* get_parse_phase_name(PARSE_PHASE phase)
+    {
+        switch (phase)
+        {
+        case PARSE_PHASE::ARGV_INGESTION: return L"argv_ingestion";
+        case PARSE_PHASE::COMMAND_SELECTION: return L"command_selection";
+        case PARSE_PHASE::FLAG_LOOP: return L"flag_loop";
+        case PARSE_PHASE::VALIDATION: return L"validation";
+        case PARSE_PHASE::PRINT_HELP: return L"print_help";
+        default: return L"unknown";
+        }
+    }
+}
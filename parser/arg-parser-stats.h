@@ -0,0 +1,101 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "arg-parser-json.h"
+
+// Parse-phase instrumentation. Counting and timing are compiled in only when the parser
+// project defines ARG_PARSER_ENABLE_STATS; otherwise the macros below expand to nothing and
+// parse_stats stays zeroed. The struct layout never depends on the define, so translation
+// units built with and without it can be linked together.
+
+namespace ArgParser {
+    enum class PARSE_PHASE {
+        ARGV_INGESTION,
+        COMMAND_SELECTION,
+        FLAG_LOOP,
+        VALIDATION,
+        PRINT_HELP,
+        PHASE_COUNT
+    };
+    constexpr size_t PARSE_PHASE_COUNT = static_cast<size_t>(PARSE_PHASE::PHASE_COUNT);
+
+    struct parse_stats {
+        std::uint64_t m_tokens = 0;
+        std::uint64_t m_flag_probes = 0;
+        std::uint64_t m_check_calls = 0;
+        std::array<std::uint64_t, PARSE_PHASE_COUNT> m_phase_calls{};
+        std::array<std::uint64_t, PARSE_PHASE_COUNT> m_phase_ns{};
+
+        void reset();
+        void write_json(json_writer& json) const;
+        // UTF-8 JSON object, see write_json
+        std::string to_json() const;
+    };
+
+    // True when the parser library was built with ARG_PARSER_ENABLE_STATS.
+    bool parse_stats_enabled();
+    const wchar_t* get_parse_phase_name(PARSE_PHASE phase);
+
+    class parse_phase_timer {
+    public:
+        parse_phase_timer(parse_stats& stats, PARSE_PHASE phase)
+            : m_stats(stats), m_phase(static_cast<size_t>(phase)), m_start(std::chrono::steady_clock::now()) {}
+        ~parse_phase_timer()
+        {
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            m_stats.m_phase_calls[m_phase] += 1;
+            m_stats.m_phase_ns[m_phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+        parse_phase_timer(const parse_phase_timer&) = delete;
+        parse_phase_timer& operator=(const parse_phase_timer&) = delete;
+
+    private:
+        parse_stats& m_stats;
+        size_t m_phase;
+        std::chrono::steady_clock::time_point m_start;
+    };
+}
+
+#ifdef ARG_PARSER_ENABLE_STATS
+#define ARG_PARSER_STATS_PHASE(stats, phase) ::ArgParser::parse_phase_timer parse_phase_timer_scope((stats), (phase))
+#define ARG_PARSER_STATS_ADD(stats, counter, count) ((stats).counter += (count))
+#define ARG_PARSER_STATS_RESET(stats) ((stats).reset())
+#else
+#define ARG_PARSER_STATS_PHASE(stats, phase) ((void)0)
+#define ARG_PARSER_STATS_ADD(stats, counter, count) ((void)0)
+#define ARG_PARSER_STATS_RESET(stats) ((void)0)
+#endif
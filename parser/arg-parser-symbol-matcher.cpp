@@ -0,0 +1,352 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "arg-parser-symbol-matcher.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace ArgParser {
+    namespace {
+        enum class GLOB_ELEMENT : std::uint8_t { LITERAL, ANY, STAR, END };
+
+        struct glob_position {
+            GLOB_ELEMENT m_kind;
+            wchar_t m_char;
+            std::uint32_t m_pattern;
+        };
+
+        // Flattens all patterns into one array of positions; every pattern ends with an END
+        // position, which is where a match is accepted.
+        std::vector<glob_position> flatten_patterns(const std::vector<std::wstring>& patterns)
+        {
+            std::vector<glob_position> positions;
+            std::set<std::wstring_view> seen;
+            for (std::uint32_t p = 0; p < patterns.size(); ++p)
+            {
+                const std::wstring& pattern = patterns[p];
+                // a repeated pattern never matches first, so it adds nothing to the automaton
+                if (!seen.insert(pattern).second) continue;
+                for (size_t i = 0; i < pattern.size(); ++i)
+                {
+                    wchar_t c = pattern[i];
+                    if (c == L'*')
+                    {
+                        // consecutive stars are equivalent to a single one
+                        if (!positions.empty() && positions.back().m_pattern == p && positions.back().m_kind == GLOB_ELEMENT::STAR)
+                            continue;
+                        positions.push_back({ GLOB_ELEMENT::STAR, 0, p });
+                    }
+                    else if (c == L'?')
+                    {
+                        positions.push_back({ GLOB_ELEMENT::ANY, 0, p });
+                    }
+                    else
+                    {
+                        if (c == L'\\' && i + 1 < pattern.size()) c = pattern[++i];
+                        positions.push_back({ GLOB_ELEMENT::LITERAL, c, p });
+                    }
+                }
+                positions.push_back({ GLOB_ELEMENT::END, 0, p });
+            }
+            return positions;
+        }
+
+        void add_with_closure(const std::vector<glob_position>& positions, std::uint32_t pos, std::vector<std::uint32_t>& set)
+        {
+            set.push_back(pos);
+            // a star may also match the empty string, so the position after it is reachable too
+            if (positions[pos].m_kind == GLOB_ELEMENT::STAR)
+                set.push_back(pos + 1);
+        }
+
+        void normalize(std::vector<std::uint32_t>& set)
+        {
+            std::sort(set.begin(), set.end());
+            set.erase(std::unique(set.begin(), set.end()), set.end());
+        }
+
+        // Moore partition refinement: merges states that accept the same pattern and move to
+        // equivalent states on every class. The dead state stays 0 and the start state 1.
+        void minimize(std::vector<std::uint32_t>& transitions, std::vector<std::uint32_t>& accepting, size_t class_count)
+        {
+            const size_t state_count = accepting.size();
+            std::vector<std::uint32_t> block(state_count);
+            size_t block_count = 0;
+            {
+                std::map<std::uint32_t, std::uint32_t> initial;
+                for (size_t state = 0; state < state_count; ++state)
+                    block[state] = initial.emplace(accepting[state], static_cast<std::uint32_t>(initial.size())).first->second;
+                block_count = initial.size();
+            }
+
+            std::vector<std::uint32_t> signature(class_count + 1);
+            while (true)
+            {
+                std::map<std::vector<std::uint32_t>, std::uint32_t> refined;
+                std::vector<std::uint32_t> next_block(state_count);
+                for (size_t state = 0; state < state_count; ++state)
+                {
+                    signature[0] = block[state];
+                    for (size_t cls = 0; cls < class_count; ++cls)
+                        signature[cls + 1] = block[transitions[state * class_count + cls]];
+                    next_block[state] = refined.emplace(signature, static_cast<std::uint32_t>(refined.size())).first->second;
+                }
+                block.swap(next_block);
+                if (refined.size() == block_count) break;
+                block_count = refined.size();
+            }
+
+            // renumber blocks so that the dead and start states keep their ids
+            std::vector<std::uint32_t> new_id(block_count, 0xFFFFFFFF);
+            std::uint32_t next_id = 0;
+            new_id[block[0]] = next_id++;
+            if (new_id[block[1]] == 0xFFFFFFFF) new_id[block[1]] = next_id++;
+            for (size_t state = 0; state < state_count; ++state)
+            {
+                if (new_id[block[state]] == 0xFFFFFFFF) new_id[block[state]] = next_id++;
+            }
+
+            std::vector<std::uint32_t> min_transitions(block_count * class_count);
+            std::vector<std::uint32_t> min_accepting(block_count);
+            for (size_t state = 0; state < state_count; ++state)
+            {
+                const std::uint32_t id = new_id[block[state]];
+                min_accepting[id] = accepting[state];
+                for (size_t cls = 0; cls < class_count; ++cls)
+                    min_transitions[id * class_count + cls] = new_id[block[transitions[state * class_count + cls]]];
+            }
+            transitions.swap(min_transitions);
+            accepting.swap(min_accepting);
+        }
+    }
+
+    symbol_matcher::symbol_matcher() {}
+
+    symbol_matcher::symbol_matcher(const std::vector<std::wstring>& patterns) : m_pattern_count(patterns.size())
+    {
+        if (patterns.empty()) return;
+        const std::vector<glob_position> positions = flatten_patterns(patterns);
+        const size_t length = std::count_if(positions.begin(), positions.end(),
+            [](const glob_position& position) { return position.m_kind != GLOB_ELEMENT::END; });
+        if (length > MAX_PATTERN_LENGTH)
+            throw std::invalid_argument("--symbol patterns are longer than " + std::to_string(MAX_PATTERN_LENGTH) + " characters together.");
+
+        // Character classes: every distinct literal gets its own class, class 0 stands for
+        // every character that no pattern names literally.
+        std::vector<wchar_t> literals;
+        for (auto& position : positions)
+        {
+            if (position.m_kind == GLOB_ELEMENT::LITERAL) literals.push_back(position.m_char);
+        }
+        std::sort(literals.begin(), literals.end());
+        literals.erase(std::unique(literals.begin(), literals.end()), literals.end());
+        if (literals.size() >= 0xFFFF)
+            throw std::invalid_argument("Too many distinct characters in --symbol patterns.");
+        for (auto c : literals)
+        {
+            std::uint16_t cls = static_cast<std::uint16_t>(m_class_count++);
+            if (static_cast<std::uint32_t>(c) < m_ascii_classes.size())
+            {
+                m_ascii_classes[static_cast<size_t>(c)] = cls;
+            }
+            else
+            {
+                m_wide_chars.push_back(c);
+                m_wide_classes.push_back(cls);
+            }
+        }
+        std::vector<std::uint16_t> literal_class(positions.size(), 0);
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            if (positions[i].m_kind == GLOB_ELEMENT::LITERAL) literal_class[i] = static_cast<std::uint16_t>(classify(positions[i].m_char));
+        }
+
+        // Subset construction. State 0 is the dead state (empty set).
+        std::map<std::vector<std::uint32_t>, std::uint32_t> state_ids;
+        std::vector<std::vector<std::uint32_t>> states;
+        auto intern = [&](std::vector<std::uint32_t>& set) -> std::uint32_t {
+            normalize(set);
+            auto found = state_ids.find(set);
+            if (found != state_ids.end()) return found->second;
+            // checked before the state exists, so the table never grows past the limit
+            if (states.size() >= MAX_STATES || (states.size() + 1) * m_class_count > MAX_TABLE_CELLS)
+                throw std::invalid_argument("--symbol patterns are too complex to compile.");
+            std::uint32_t id = static_cast<std::uint32_t>(states.size());
+            state_ids.emplace(set, id);
+            states.push_back(set);
+            return id;
+        };
+
+        std::vector<std::uint32_t> set;
+        intern(set);
+        for (std::uint32_t pos = 0; pos < positions.size(); ++pos)
+        {
+            if (pos == 0 || positions[pos - 1].m_kind == GLOB_ELEMENT::END)
+                add_with_closure(positions, pos, set);
+        }
+        intern(set);
+
+        // pattern positions carried over all transitions built so far
+        size_t work = 0;
+        for (std::uint32_t state = 0; state < states.size(); ++state)
+        {
+            std::uint32_t accepting = NO_MATCH;
+            for (auto pos : states[state])
+            {
+                if (positions[pos].m_kind == GLOB_ELEMENT::END)
+                    accepting = std::min(accepting, positions[pos].m_pattern);
+            }
+            m_accepting.push_back(accepting);
+
+            for (std::uint32_t cls = 0; cls < m_class_count; ++cls)
+            {
+                set.clear();
+                for (auto pos : states[state])
+                {
+                    switch (positions[pos].m_kind)
+                    {
+                    case GLOB_ELEMENT::STAR:
+                        add_with_closure(positions, pos, set);
+                        break;
+                    case GLOB_ELEMENT::ANY:
+                        add_with_closure(positions, pos + 1, set);
+                        break;
+                    case GLOB_ELEMENT::LITERAL:
+                        if (cls != 0 && literal_class[pos] == cls) add_with_closure(positions, pos + 1, set);
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                work += set.size();
+                if (work > MAX_SUBSET_WORK)
+                    throw std::invalid_argument("--symbol patterns are too complex to compile.");
+                // states may grow while interning, so index the table only afterwards
+                std::uint32_t next = intern(set);
+                m_transitions.resize(states.size() * m_class_count, 0);
+                m_transitions[state * m_class_count + cls] = next;
+            }
+        }
+
+        minimize(m_transitions, m_accepting, m_class_count);
+
+        m_accepts_rest.resize(m_accepting.size(), 0);
+        for (std::uint32_t state = 0; state < m_accepting.size(); ++state)
+        {
+            if (m_accepting[state] == NO_MATCH) continue;
+            bool loops = true;
+            for (std::uint32_t cls = 0; cls < m_class_count && loops; ++cls)
+                loops = m_transitions[state * m_class_count + cls] == state;
+            m_accepts_rest[state] = loops;
+        }
+    }
+
+    bool symbol_matcher::empty() const
+    {
+        return m_pattern_count == 0;
+    }
+
+    size_t symbol_matcher::get_pattern_count() const
+    {
+        return m_pattern_count;
+    }
+
+    size_t symbol_matcher::get_state_count() const
+    {
+        return m_accepting.size();
+    }
+
+    bool symbol_matcher::match(std::wstring_view name) const
+    {
+        if (empty()) return true;
+        return match_index(name) != NO_MATCH;
+    }
+
+    std::uint32_t symbol_matcher::match_index(std::wstring_view name) const
+    {
+        if (empty()) return NO_MATCH;
+
+        std::uint32_t state = 1;
+        const std::uint32_t* transitions = m_transitions.data();
+        for (wchar_t c : name)
+        {
+            if (m_accepts_rest[state]) break;
+            state = transitions[state * m_class_count + classify(c)];
+            if (state == 0) return NO_MATCH;
+        }
+        return m_accepting[state];
+    }
+
+    std::uint32_t symbol_matcher::classify(wchar_t c) const
+    {
+        if (static_cast<std::uint32_t>(c) < m_ascii_classes.size())
+            return m_ascii_classes[static_cast<size_t>(c)];
+        auto found = std::lower_bound(m_wide_chars.begin(), m_wide_chars.end(), c);
+        if (found == m_wide_chars.end() || *found != c) return 0;
+        return m_wide_classes[found - m_wide_chars.begin()];
+    }
+
+    std::vector<std::wstring> symbol_matcher::split_patterns(const std::vector<std::wstring>& values)
+    {
+        // an empty pattern would leave a matcher that accepts every symbol, which is never what
+        // `--symbol ","` or `--symbol "main,"` meant
+        const auto add = [](std::vector<std::wstring>& patterns, std::wstring& pattern) {
+            if (pattern.empty()) throw std::invalid_argument("--symbol contains an empty pattern.");
+            patterns.push_back(std::move(pattern));
+            pattern.clear();
+        };
+        std::vector<std::wstring> patterns;
+        for (auto& value : values)
+        {
+            std::wstring current;
+            for (size_t i = 0; i < value.size(); ++i)
+            {
+                if (value[i] == L'\\' && i + 1 < value.size() && value[i + 1] == L',')
+                {
+                    current += L',';
+                    ++i;
+                }
+                else if (value[i] == L',')
+                {
+                    add(patterns, current);
+                }
+                else
+                {
+                    current += value[i];
+                }
+            }
+            add(patterns, current);
+        }
+        return patterns;
+    }
+}
@@ -0,0 +1,87 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgParser {
+    // Matches resolved symbol names against a set of glob patterns given with --symbol.
+    // `*` matches any run of characters, `?` matches one character and `\` escapes the next
+    // character, so `operator\*` matches the literal name. All patterns are compiled together
+    // into one minimized DFA, so testing a name costs one table lookup per character regardless of how
+    // many patterns were given.
+    class symbol_matcher {
+    public:
+        static constexpr std::uint32_t NO_MATCH = 0xFFFFFFFF;
+        static constexpr size_t MAX_STATES = 1 << 16;
+        // Limits on the work of compiling: the characters of all distinct patterns together, the cells
+        // (states times character classes) of the transition table while it is built, and the
+        // pattern positions the subset construction carries over all of its transitions
+        static constexpr size_t MAX_PATTERN_LENGTH = 1024;
+        static constexpr size_t MAX_TABLE_CELLS = 1 << 20;
+        static constexpr size_t MAX_SUBSET_WORK = 1 << 24;
+
+        // Matches every name: an empty filter means no filtering.
+        symbol_matcher();
+        // Throws std::invalid_argument when the distinct patterns are longer than
+        // MAX_PATTERN_LENGTH together or go over one of the other limits while compiling.
+        explicit symbol_matcher(const std::vector<std::wstring>& patterns);
+
+        bool empty() const;
+        size_t get_pattern_count() const;
+        size_t get_state_count() const;
+
+        bool match(std::wstring_view name) const;
+        // Index of the first pattern (in the given order) that matches, or NO_MATCH.
+        std::uint32_t match_index(std::wstring_view name) const;
+
+        // Splits comma separated --symbol values into patterns; `\,` keeps a literal comma.
+        // Throws std::invalid_argument when a pattern is empty.
+        static std::vector<std::wstring> split_patterns(const std::vector<std::wstring>& values);
+
+    private:
+        std::uint32_t classify(wchar_t c) const;
+
+        size_t m_pattern_count = 0;
+        size_t m_class_count = 1;
+        std::array<std::uint16_t, 128> m_ascii_classes{};
+        std::vector<wchar_t> m_wide_chars;          // sorted literal characters >= 128
+        std::vector<std::uint16_t> m_wide_classes;  // class of m_wide_chars[i]
+        std::vector<std::uint32_t> m_transitions;   // state * m_class_count + class
+        std::vector<std::uint32_t> m_accepting;     // first matching pattern per state, or NO_MATCH
+        std::vector<std::uint8_t> m_accepts_rest;   // accepting and every transition loops back
+    };
+}
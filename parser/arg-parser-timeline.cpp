@@ -0,0 +1,265 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-timeline.h"
+#include "arg-parser-utf8.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ArgParser {
+    std::filesystem::path resolve_output_path(std::wstring_view prefix, std::wstring_view name)
+    {
+        std::filesystem::path path(name);
+        if (prefix.empty() || path.is_absolute()) return path;
+        return std::filesystem::path(prefix) / path;
+    }
+
+    bool can_create_file(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        if (std::filesystem::is_directory(path, error)) return false;
+        const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+        return std::filesystem::is_directory(directory, error);
+    }
+
+    timeline_writer::timeline_writer(output_sink& sink, size_t buffer_size, BACKPRESSURE policy)
+        : m_sink(sink), m_buffer_size(buffer_size), m_policy(policy)
+    {
+        // zero filled, so the pages are touched here rather than while rows are timed
+        for (auto& buffer : m_buffers)
+            buffer.m_data = std::make_unique<char[]>(buffer_size);
+        m_writer = std::thread(&timeline_writer::run_writer, this);
+    }
+
+    timeline_writer::~timeline_writer()
+    {
+        flush();
+        m_is_stopping.store(true, std::memory_order_release);
+        wake_writer();
+        m_writer.join();
+    }
+
+    bool timeline_writer::write(std::string_view record)
+    {
+        begin_record();
+        if (!append_text(record)) return false;
+        ++m_stats.m_rows;
+        return true;
+    }
+
+    void timeline_writer::flush()
+    {
+        m_record_begin = m_size;
+        if (m_size > 0)
+        {
+            wait_until_free(1 - m_active);
+            publish_active();
+            m_active = 1 - m_active;
+            m_size = 0;
+            m_record_begin = 0;
+        }
+
+        const size_t request = m_flush_requested.load(std::memory_order_relaxed) + 1;
+        m_flush_requested.store(request, std::memory_order_release);
+        wake_writer();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_producer_wake.wait(lock, [&] { return m_flush_done.load(std::memory_order_acquire) >= request; });
+    }
+
+    timeline_writer_stats timeline_writer::get_stats() const
+    {
+        timeline_writer_stats stats = m_stats;
+        stats.m_buffers_written = m_buffers_written.load(std::memory_order_relaxed);
+        stats.m_bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void timeline_writer::begin_record()
+    {
+        m_record_begin = m_size;
+        m_is_dropping = false;
+    }
+
+    char* timeline_writer::reserve(size_t size)
+    {
+        if (m_is_dropping) return nullptr;
+        char* active = m_buffers[m_active].m_data.get();
+        if (m_size + size <= m_buffer_size) return active + m_size;
+
+        const size_t record_size = m_size - m_record_begin;
+        if (record_size + size > m_buffer_size)
+        {
+            m_size = m_record_begin;
+            throw std::length_error("timeline record is larger than the writer buffer");
+        }
+
+        // the record so far moves to the other buffer and this one is handed over without it;
+        // m_record_begin > 0 here, a record starting at 0 would not have fit in the first place
+        const size_t other = 1 - m_active;
+        if (m_buffers[other].m_published.load(std::memory_order_acquire) != 0)
+        {
+            if (m_policy == BACKPRESSURE::DROP)
+            {
+                m_size = m_record_begin;
+                m_is_dropping = true;
+                ++m_stats.m_rows_dropped;
+                return nullptr;
+            }
+            ++m_stats.m_stalls;
+            wait_until_free(other);
+        }
+        std::memcpy(m_buffers[other].m_data.get(), active + m_record_begin, record_size);
+        publish_active();
+        m_active = other;
+        m_size = record_size;
+        m_record_begin = 0;
+        return m_buffers[m_active].m_data.get() + m_size;
+    }
+
+    bool timeline_writer::append_separator(bool& first)
+    {
+        if (first)
+        {
+            first = false;
+            return true;
+        }
+        return append_text(",");
+    }
+
+    bool timeline_writer::append_text(std::string_view text)
+    {
+        char* out = reserve(text.size());
+        if (out == nullptr) return false;
+        std::memcpy(out, text.data(), text.size());
+        m_size += text.size();
+        return true;
+    }
+
+    bool timeline_writer::append_quoted(std::string_view text)
+    {
+        if (text.find_first_of(",\"\r\n") == std::string_view::npos)
+            return append_text(text);
+
+        // RFC 4180: the field in quotes, quotes inside it doubled
+        const size_t quotes = std::count(text.begin(), text.end(), '"');
+        char* out = reserve(text.size() + quotes + 2);
+        if (out == nullptr) return false;
+        char* const begin = out;
+        *out++ = '"';
+        for (char c : text)
+        {
+            if (c == '"') *out++ = '"';
+            *out++ = c;
+        }
+        *out++ = '"';
+        m_size += out - begin;
+        return true;
+    }
+
+    bool timeline_writer::append_field(std::string_view text)
+    {
+        return append_quoted(text);
+    }
+
+    bool timeline_writer::append_field(std::wstring_view text)
+    {
+        m_utf8.clear();
+        wide_to_utf8(text, m_utf8, true);
+        return append_quoted(m_utf8);
+    }
+
+    void timeline_writer::publish_active()
+    {
+        m_buffers[m_active].m_published.store(m_record_begin, std::memory_order_release);
+        wake_writer();
+    }
+
+    void timeline_writer::wait_until_free(size_t index)
+    {
+        if (m_buffers[index].m_published.load(std::memory_order_acquire) == 0) return;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_producer_wake.wait(lock, [&] { return m_buffers[index].m_published.load(std::memory_order_acquire) == 0; });
+    }
+
+    void timeline_writer::wake_writer()
+    {
+        // taking the mutex orders the store before the writer's check, so the wakeup is not lost
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_writer_wake.notify_one();
+    }
+
+    void timeline_writer::run_writer()
+    {
+        // buffers are published in turn and only one at a time: the producer does not hand one
+        // over before the other is written
+        size_t next = 0;
+        const auto wake_producer = [this] {
+            { std::lock_guard<std::mutex> lock(m_mutex); }
+            m_producer_wake.notify_one();
+        };
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_writer_wake.wait(lock, [&] {
+                    return m_buffers[next].m_published.load(std::memory_order_acquire) != 0
+                        || m_flush_requested.load(std::memory_order_acquire) != m_flush_done.load(std::memory_order_relaxed)
+                        || m_is_stopping.load(std::memory_order_acquire);
+                });
+            }
+
+            // a flush request is read before the buffer, so the buffer published ahead of it is seen
+            const size_t requested = m_flush_requested.load(std::memory_order_acquire);
+            const bool is_stopping = m_is_stopping.load(std::memory_order_acquire);
+            buffer& ready = m_buffers[next];
+            const size_t size = ready.m_published.load(std::memory_order_acquire);
+            if (size != 0)
+            {
+                m_sink.write(ready.m_data.get(), size);
+                m_bytes_written.fetch_add(size, std::memory_order_relaxed);
+                m_buffers_written.fetch_add(1, std::memory_order_relaxed);
+                ready.m_published.store(0, std::memory_order_release);
+                next = 1 - next;
+                wake_producer();
+                continue;
+            }
+            if (requested != m_flush_done.load(std::memory_order_relaxed))
+            {
+                m_sink.flush();
+                m_flush_done.store(requested, std::memory_order_release);
+                wake_producer();
+                continue;
+            }
+            if (is_stopping) return;
+        }
+    }
+}
@@ -0,0 +1,195 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include "arg-parser-output.h"
+
+namespace ArgParser {
+    // Where a timeline output named `name` goes: under `prefix`, unless the prefix is empty or
+    // the name is already absolute
+    std::filesystem::path resolve_output_path(std::wstring_view prefix, std::wstring_view name);
+
+    // Whether a file can be created at path without creating it: its directory exists and the
+    // path is not a directory itself. Permissions are only found out by opening the file.
+    bool can_create_file(const std::filesystem::path& path);
+
+    // A timeline output file opened by arg_parser::open_timeline_outputs
+    struct timeline_output {
+        std::filesystem::path m_path;
+        std::unique_ptr<file_sink> m_sink;
+    };
+
+    struct timeline_outputs {
+        // --output-csv and --output
+        timeline_output m_csv;
+        timeline_output m_json;
+    };
+
+    // What timeline_writer does with a row when the writer thread still holds the other buffer
+    enum class BACKPRESSURE {
+        // the producer waits until the buffer is written, counted in m_stalls
+        BLOCK,
+        // the row is discarded, counted in m_rows_dropped
+        DROP
+    };
+
+    struct timeline_writer_stats {
+        size_t m_rows = 0;
+        size_t m_rows_dropped = 0;
+        size_t m_stalls = 0;
+        // buffers handed to the sink and the bytes in them
+        size_t m_buffers_written = 0;
+        size_t m_bytes_written = 0;
+    };
+
+    // Writes timeline rows to an output_sink from a background thread, so the thread taking the
+    // measurements never waits for the file system. Rows are formatted straight into one of two
+    // buffers allocated up front; a full buffer is handed to the writer thread with an atomic store
+    // and formatting carries on in the other one. The rows themselves never take a lock, the mutex
+    // only puts a waiting thread to sleep. Memory stays at two buffers however slow the sink is:
+    // once both are taken the BACKPRESSURE policy decides between waiting and dropping the row.
+    //
+    // Buffers only ever hold whole records, so a dropped row leaves no partial line behind.
+    // Rows come from one thread at a time; the sink is only called from the writer thread.
+    //
+    //   timeline_outputs outputs = parser.open_timeline_outputs();
+    //   timeline_writer writer(*outputs.m_csv.m_sink);
+    //   writer.write_row("core", "cycles", "inst_spec");
+    //   writer.write_row(0, 123456789ull, 2.5);
+    class timeline_writer {
+    public:
+        static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+        explicit timeline_writer(output_sink& sink, size_t buffer_size = DEFAULT_BUFFER_SIZE, BACKPRESSURE policy = BACKPRESSURE::BLOCK);
+        // Writes what is left and joins the writer thread
+        ~timeline_writer();
+        timeline_writer(const timeline_writer&) = delete;
+        timeline_writer& operator=(const timeline_writer&) = delete;
+
+        // One CSV row, fields comma separated and the row '\n' terminated. Fields are integers,
+        // floating point numbers (shortest round-trip form), UTF-8 strings or wide strings; text
+        // is quoted when it holds a comma, a quote or a line break. Returns false when the row was
+        // dropped, throws std::length_error for a row that does not fit in one buffer.
+        template <class... Fields>
+        bool write_row(const Fields&... fields)
+        {
+            begin_record();
+            bool first = true;
+            const bool kept = ((append_separator(first) && append_field(fields)) && ...) && append_text("\n");
+            if (kept) ++m_stats.m_rows;
+            return kept;
+        }
+        // A record formatted by the caller, such as a line of JSON, written as it is
+        bool write(std::string_view record);
+        // Hands over the partly filled buffer and returns once the sink has received and flushed
+        // everything written so far
+        void flush();
+        // Counters of the producing thread, read from that thread
+        timeline_writer_stats get_stats() const;
+
+    private:
+        struct buffer {
+            std::unique_ptr<char[]> m_data;
+            // bytes handed to the writer thread, 0 while the producer owns the buffer
+            std::atomic<size_t> m_published{ 0 };
+        };
+
+        void begin_record();
+        // Room for `size` more bytes of the current record, nullptr when the record was dropped
+        char* reserve(size_t size);
+        bool append_separator(bool& first);
+        bool append_text(std::string_view text);
+        bool append_quoted(std::string_view text);
+        bool append_field(std::string_view text);
+        bool append_field(std::wstring_view text);
+        bool append_field(const char* text) { return append_field(std::string_view(text)); }
+        bool append_field(const wchar_t* text) { return append_field(std::wstring_view(text)); }
+        bool append_field(const std::string& text) { return append_field(std::string_view(text)); }
+        bool append_field(const std::wstring& text) { return append_field(std::wstring_view(text)); }
+        template <class Number>
+        bool append_field(Number value)
+        {
+            static_assert(std::is_arithmetic_v<Number>, "timeline fields are numbers or text");
+            // enough for any integer and for the shortest form of a double
+            constexpr size_t MAX_NUMBER_SIZE = 32;
+            char* out = reserve(MAX_NUMBER_SIZE);
+            if (out == nullptr) return false;
+            const auto result = std::to_chars(out, out + MAX_NUMBER_SIZE, value);
+            m_size += result.ptr - out;
+            return true;
+        }
+        bool append_field(bool value) { return append_text(value ? "1" : "0"); }
+
+        // Hands the buffer being filled, up to the current record, to the writer thread
+        void publish_active();
+        void wait_until_free(size_t index);
+        void wake_writer();
+        void run_writer();
+
+        output_sink& m_sink;
+        const size_t m_buffer_size;
+        const BACKPRESSURE m_policy;
+        buffer m_buffers[2];
+
+        // producer side
+        size_t m_active = 0;
+        size_t m_size = 0;
+        size_t m_record_begin = 0;
+        bool m_is_dropping = false;
+        std::string m_utf8;
+        timeline_writer_stats m_stats;
+
+        // writer side, the counters are read by get_stats
+        std::atomic<size_t> m_buffers_written{ 0 };
+        std::atomic<size_t> m_bytes_written{ 0 };
+        std::atomic<size_t> m_flush_requested{ 0 };
+        std::atomic<size_t> m_flush_done{ 0 };
+        std::atomic<bool> m_is_stopping{ false };
+
+        std::mutex m_mutex;
+        std::condition_variable m_writer_wake;
+        std::condition_variable m_producer_wake;
+        std::thread m_writer;
+    };
+}
@@ -0,0 +1,269 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-tokenizer.h"
+#include <cstdint>
+
+#if defined(__AVX2__)
+#define ARG_PARSER_TOKENIZER_AVX2
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define ARG_PARSER_TOKENIZER_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define ARG_PARSER_TOKENIZER_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ArgParser {
+    namespace {
+        template<class CharT>
+        inline bool is_delimiter(CharT c)
+        {
+            return c == CharT(',') || c == CharT('{') || c == CharT('}') || c == CharT(':') || c == CharT('-');
+        }
+
+        inline unsigned count_trailing_zeros(std::uint64_t mask)
+        {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return static_cast<unsigned>(index);
+#elif defined(_MSC_VER)
+            unsigned long index;
+            if (_BitScanForward(&index, static_cast<unsigned long>(mask)))
+                return static_cast<unsigned>(index);
+            _BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+            return static_cast<unsigned>(index) + 32;
+#else
+            return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+        }
+
+        // A kernel compares LANES units at once and returns a mask with BITS set bits per matching unit.
+        template<class Unit>
+        struct delimiter_kernel {
+            static constexpr size_t LANES = 0;
+        };
+
+#if defined(ARG_PARSER_TOKENIZER_AVX2)
+#define ARG_PARSER_TOKENIZER_KERNEL(UNIT, WIDTH, LANE_COUNT)                                        \
+        template<>                                                                                  \
+        struct delimiter_kernel<UNIT> {                                                             \
+            static constexpr size_t LANES = LANE_COUNT;                                             \
+            static constexpr unsigned BITS = sizeof(UNIT);                                          \
+            static std::uint64_t mask(const UNIT* data)                                             \
+            {                                                                                       \
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));       \
+                __m256i m = _mm256_cmpeq_epi##WIDTH(v, _mm256_set1_epi##WIDTH(',')); \
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi##WIDTH(v, _mm256_set1_epi##WIDTH('{'))); \
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi##WIDTH(v, _mm256_set1_epi##WIDTH('}'))); \
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi##WIDTH(v, _mm256_set1_epi##WIDTH(':'))); \
+                m = _mm256_or_si256(m, _mm256_cmpeq_epi##WIDTH(v, _mm256_set1_epi##WIDTH('-'))); \
+                return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));                         \
+            }                                                                                       \
+        };
+        ARG_PARSER_TOKENIZER_KERNEL(std::uint8_t, 8, 32)
+        ARG_PARSER_TOKENIZER_KERNEL(std::uint16_t, 16, 16)
+        ARG_PARSER_TOKENIZER_KERNEL(std::uint32_t, 32, 8)
+#undef ARG_PARSER_TOKENIZER_KERNEL
+#elif defined(ARG_PARSER_TOKENIZER_SSE2)
+#define ARG_PARSER_TOKENIZER_KERNEL(UNIT, WIDTH, LANE_COUNT)                                        \
+        template<>                                                                                  \
+        struct delimiter_kernel<UNIT> {                                                             \
+            static constexpr size_t LANES = LANE_COUNT;                                             \
+            static constexpr unsigned BITS = sizeof(UNIT);                                          \
+            static std::uint64_t mask(const UNIT* data)                                             \
+            {                                                                                       \
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));          \
+                __m128i m = _mm_cmpeq_epi##WIDTH(v, _mm_set1_epi##WIDTH(','));                      \
+                m = _mm_or_si128(m, _mm_cmpeq_epi##WIDTH(v, _mm_set1_epi##WIDTH('{')));             \
+                m = _mm_or_si128(m, _mm_cmpeq_epi##WIDTH(v, _mm_set1_epi##WIDTH('}')));             \
+                m = _mm_or_si128(m, _mm_cmpeq_epi##WIDTH(v, _mm_set1_epi##WIDTH(':')));             \
+                m = _mm_or_si128(m, _mm_cmpeq_epi##WIDTH(v, _mm_set1_epi##WIDTH('-')));             \
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(m));                            \
+            }                                                                                       \
+        };
+        ARG_PARSER_TOKENIZER_KERNEL(std::uint8_t, 8, 16)
+        ARG_PARSER_TOKENIZER_KERNEL(std::uint16_t, 16, 8)
+        ARG_PARSER_TOKENIZER_KERNEL(std::uint32_t, 32, 4)
+#undef ARG_PARSER_TOKENIZER_KERNEL
+#elif defined(ARG_PARSER_TOKENIZER_NEON)
+        // NEON has no movemask; narrowing the compare result packs it into one 64-bit lane instead.
+        template<>
+        struct delimiter_kernel<std::uint8_t> {
+            static constexpr size_t LANES = 16;
+            static constexpr unsigned BITS = 4;
+            static std::uint64_t mask(const std::uint8_t* data)
+            {
+                const uint8x16_t v = vld1q_u8(data);
+                uint8x16_t m = vceqq_u8(v, vdupq_n_u8(','));
+                m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('{')));
+                m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('}')));
+                m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8(':')));
+                m = vorrq_u8(m, vceqq_u8(v, vdupq_n_u8('-')));
+                return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+            }
+        };
+
+        template<>
+        struct delimiter_kernel<std::uint16_t> {
+            static constexpr size_t LANES = 8;
+            static constexpr unsigned BITS = 8;
+            static std::uint64_t mask(const std::uint16_t* data)
+            {
+                const uint16x8_t v = vld1q_u16(data);
+                uint16x8_t m = vceqq_u16(v, vdupq_n_u16(','));
+                m = vorrq_u16(m, vceqq_u16(v, vdupq_n_u16('{')));
+                m = vorrq_u16(m, vceqq_u16(v, vdupq_n_u16('}')));
+                m = vorrq_u16(m, vceqq_u16(v, vdupq_n_u16(':')));
+                m = vorrq_u16(m, vceqq_u16(v, vdupq_n_u16('-')));
+                return vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(m)), 0);
+            }
+        };
+
+        template<>
+        struct delimiter_kernel<std::uint32_t> {
+            static constexpr size_t LANES = 4;
+            static constexpr unsigned BITS = 16;
+            static std::uint64_t mask(const std::uint32_t* data)
+            {
+                const uint32x4_t v = vld1q_u32(data);
+                uint32x4_t m = vceqq_u32(v, vdupq_n_u32(','));
+                m = vorrq_u32(m, vceqq_u32(v, vdupq_n_u32('{')));
+                m = vorrq_u32(m, vceqq_u32(v, vdupq_n_u32('}')));
+                m = vorrq_u32(m, vceqq_u32(v, vdupq_n_u32(':')));
+                m = vorrq_u32(m, vceqq_u32(v, vdupq_n_u32('-')));
+                return vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(m)), 0);
+            }
+        };
+#endif
+
+        template<size_t Size> struct unit_of;
+        template<> struct unit_of<1> { using type = std::uint8_t; };
+        template<> struct unit_of<2> { using type = std::uint16_t; };
+        template<> struct unit_of<4> { using type = std::uint32_t; };
+
+        template<class CharT>
+        inline void emit(std::vector<token_span<CharT>>& spans, const CharT* data, size_t& start, size_t position)
+        {
+            spans.push_back({ std::basic_string_view<CharT>(data + start, position - start), data[position] });
+            start = position + 1;
+        }
+
+        template<class CharT>
+        void tokenize_tail(std::basic_string_view<CharT> text, size_t position, size_t start, std::vector<token_span<CharT>>& spans)
+        {
+            const CharT* data = text.data();
+            for (; position < text.size(); ++position)
+            {
+                if (is_delimiter(data[position]))
+                    emit(spans, data, start, position);
+            }
+            spans.push_back({ std::basic_string_view<CharT>(data + start, text.size() - start), CharT() });
+        }
+
+        template<class CharT>
+        void tokenize_vector(std::basic_string_view<CharT> text, std::vector<token_span<CharT>>& spans)
+        {
+            spans.clear();
+            if (text.empty()) return;
+
+            using unit = typename unit_of<sizeof(CharT)>::type;
+            using kernel = delimiter_kernel<unit>;
+
+            const CharT* data = text.data();
+            size_t position = 0, start = 0;
+            if constexpr (kernel::LANES > 0)
+            {
+                const unit* units = reinterpret_cast<const unit*>(data);
+                constexpr std::uint64_t unit_mask = kernel::BITS == 64 ? ~0ull : (1ull << kernel::BITS) - 1;
+                for (; position + kernel::LANES <= text.size(); position += kernel::LANES)
+                {
+                    std::uint64_t mask = kernel::mask(units + position);
+                    while (mask != 0)
+                    {
+                        const unsigned bit = count_trailing_zeros(mask);
+                        emit(spans, data, start, position + bit / kernel::BITS);
+                        mask &= ~(unit_mask << bit);
+                    }
+                }
+            }
+            tokenize_tail(text, position, start, spans);
+        }
+
+        template<class CharT>
+        void tokenize_reference(std::basic_string_view<CharT> text, std::vector<token_span<CharT>>& spans)
+        {
+            spans.clear();
+            if (text.empty()) return;
+            tokenize_tail(text, 0, 0, spans);
+        }
+    }
+
+    void tokenize(std::string_view text, std::vector<token_span<char>>& spans)
+    {
+        tokenize_vector(text, spans);
+    }
+
+    void tokenize(std::wstring_view text, std::vector<token_span<wchar_t>>& spans)
+    {
+        tokenize_vector(text, spans);
+    }
+
+    void tokenize_scalar(std::string_view text, std::vector<token_span<char>>& spans)
+    {
+        tokenize_reference(text, spans);
+    }
+
+    void tokenize_scalar(std::wstring_view text, std::vector<token_span<wchar_t>>& spans)
+    {
+        tokenize_reference(text, spans);
+    }
+
+    const char* get_tokenizer_isa()
+    {
+#if defined(ARG_PARSER_TOKENIZER_AVX2)
+        return "avx2";
+#elif defined(ARG_PARSER_TOKENIZER_SSE2)
+        return "sse2";
+#elif defined(ARG_PARSER_TOKENIZER_NEON)
+        return "neon";
+#else
+        return "scalar";
+#endif
+    }
+}
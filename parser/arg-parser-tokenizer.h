@@ -0,0 +1,61 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace ArgParser {
+    // Splits flag payloads such as `-e`, `-m`, `-c` and `--dmc` on their structural characters:
+    // `,` `{` `}` `:` and `-`. Delimiters are located with SSE2/AVX2/NEON compares over whole
+    // blocks of characters, with a scalar loop for the tail and for other targets. Tokens are views
+    // into the caller's buffer, so nothing is copied and the buffer must outlive the spans.
+    template<class CharT>
+    struct token_span {
+        std::basic_string_view<CharT> m_text;
+        // The delimiter that ended this token, or CharT() for the last token.
+        CharT m_delimiter;
+    };
+
+    // Replaces the contents of `spans` (reusing its capacity) with the tokens of `text`.
+    // A non-empty text yields one more span than it has delimiters; an empty text yields none.
+    void tokenize(std::string_view text, std::vector<token_span<char>>& spans);
+    void tokenize(std::wstring_view text, std::vector<token_span<wchar_t>>& spans);
+
+    // Reference implementation used by the tests and benchmarks.
+    void tokenize_scalar(std::string_view text, std::vector<token_span<char>>& spans);
+    void tokenize_scalar(std::wstring_view text, std::vector<token_span<wchar_t>>& spans);
+
+    // Name of the instruction set the vectorized tokenizer was built for: "avx2", "sse2", "neon" or "scalar".
+    const char* get_tokenizer_isa();
+}
@@ -0,0 +1,348 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include "arg-parser-topology.h"
+#include "arg-parser-validators.h"
+
+namespace ArgParser {
+    namespace {
+        namespace detail = ArgParserArg::validators::detail;
+
+        bool read_file(const std::filesystem::path& path, std::string& text)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) return false;
+            text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        bool parse_number(std::string_view text, unsigned& value)
+        {
+            while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) text.remove_suffix(1);
+            if (text.empty() || text.size() > 9) return false;
+            value = 0;
+            for (char c : text)
+            {
+                if (c < '0' || c > '9') return false;
+                value = value * 10 + static_cast<unsigned>(c - '0');
+            }
+            return true;
+        }
+
+        // A CPU, node or cluster number in a -c item; the limit keeps the arithmetic in range
+        bool parse_index(std::wstring_view text, unsigned& value)
+        {
+            unsigned long long parsed;
+            if (!detail::parse_uint(text, parsed) || parsed > 0xFFFFFFu) return false;
+            value = static_cast<unsigned>(parsed);
+            return true;
+        }
+    }
+
+    bool cpu_topology::parse_cpu_list(std::string_view text, std::vector<unsigned>& cpus)
+    {
+        while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) text.remove_suffix(1);
+        // an empty list is valid, for example the CPUs of a memory-only node
+        while (!text.empty())
+        {
+            const size_t comma = text.find(',');
+            const std::string_view item = text.substr(0, comma);
+            const size_t dash = item.find('-');
+            unsigned first = 0;
+            unsigned last = 0;
+            if (!parse_number(item.substr(0, dash), first)) return false;
+            last = first;
+            if (dash != std::string_view::npos && (!parse_number(item.substr(dash + 1), last) || last < first)) return false;
+            for (unsigned cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+            text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+        }
+        return true;
+    }
+
+    cpu_info& cpu_topology::get_cpu(unsigned cpu)
+    {
+        if (cpu >= m_cpus.size()) m_cpus.resize(cpu + 1);
+        return m_cpus[cpu];
+    }
+
+    cpu_topology cpu_topology::read_sysfs(const std::filesystem::path& sysfs_root)
+    {
+        cpu_topology topology;
+        const std::filesystem::path cpu_root = sysfs_root / "devices" / "system" / "cpu";
+        std::string text;
+        std::vector<unsigned> present;
+        if (!(read_file(cpu_root / "present", text) || read_file(cpu_root / "possible", text)) || !parse_cpu_list(text, present) || present.empty())
+            return topology;
+
+        // CPUs outside the present list are dropped from every other list
+        const auto keep_present = [&topology](std::vector<unsigned>& cpus) {
+            cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&topology](unsigned cpu) {
+                return cpu >= topology.m_cpus.size() || !topology.m_cpus[cpu].m_present;
+            }), cpus.end());
+        };
+
+        for (unsigned cpu : present)
+            topology.get_cpu(cpu).m_present = true;
+
+        std::vector<unsigned> online;
+        if (read_file(cpu_root / "online", text) && parse_cpu_list(text, online))
+            keep_present(online);
+        else
+            online = present;
+        for (unsigned cpu : online)
+            topology.m_cpus[cpu].m_online = true;
+
+        for (unsigned cpu : present)
+        {
+            cpu_info& info = topology.m_cpus[cpu];
+            const std::filesystem::path cpu_dir = cpu_root / ("cpu" + std::to_string(cpu));
+
+            // cluster_id is -1 where the firmware does not describe clusters, the package stands in
+            if (!(read_file(cpu_dir / "topology" / "cluster_id", text) && parse_number(text, info.m_cluster))
+                && !(read_file(cpu_dir / "topology" / "physical_package_id", text) && parse_number(text, info.m_cluster)))
+                info.m_cluster = cpu_info::NO_CLUSTER;
+
+            if (read_file(cpu_dir / "topology" / "thread_siblings_list", text))
+                parse_cpu_list(text, info.m_smt_siblings);
+
+            unsigned best_level = 0;
+            for (unsigned index = 0; read_file(cpu_dir / "cache" / ("index" + std::to_string(index)) / "level", text); ++index)
+            {
+                unsigned level = 0;
+                std::vector<unsigned> shared;
+                if (!parse_number(text, level) || level < best_level) continue;
+                if (!read_file(cpu_dir / "cache" / ("index" + std::to_string(index)) / "shared_cpu_list", text) || !parse_cpu_list(text, shared)) continue;
+                best_level = level;
+                info.m_cache_domain.swap(shared);
+            }
+        }
+
+        std::error_code error;
+        for (auto& entry : std::filesystem::directory_iterator(sysfs_root / "devices" / "system" / "node", error))
+        {
+            const std::string name = entry.path().filename().string();
+            unsigned node = 0;
+            std::vector<unsigned> cpus;
+            if (name.compare(0, 4, "node") != 0 || !parse_number(std::string_view(name).substr(4), node)) continue;
+            if (!read_file(entry.path() / "cpulist", text) || !parse_cpu_list(text, cpus)) continue;
+            keep_present(cpus);
+            for (unsigned cpu : cpus)
+                topology.m_cpus[cpu].m_node = node;
+        }
+
+        for (size_t cpu = 0; cpu < topology.m_cpus.size(); ++cpu)
+        {
+            cpu_info& info = topology.m_cpus[cpu];
+            keep_present(info.m_smt_siblings);
+            keep_present(info.m_cache_domain);
+            if (info.m_present && info.m_smt_siblings.empty()) info.m_smt_siblings.push_back(static_cast<unsigned>(cpu));
+            if (info.m_present && info.m_cache_domain.empty()) info.m_cache_domain.push_back(static_cast<unsigned>(cpu));
+        }
+        return topology;
+    }
+
+    cpu_topology cpu_topology::read_host()
+    {
+#ifdef _WIN32
+        DWORD length = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+        // the records hold 64-bit masks, so the buffer is kept 8-byte aligned
+        std::vector<std::uint64_t> buffer((length + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+        if (length == 0 || !GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+            return cpu_topology();
+
+        const auto cpus_of = [](const GROUP_AFFINITY& affinity, std::vector<unsigned>& cpus) {
+            for (unsigned bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit)
+            {
+                if (affinity.Mask & (KAFFINITY(1) << bit))
+                    cpus.push_back(affinity.Group * static_cast<unsigned>(sizeof(KAFFINITY) * 8) + bit);
+            }
+        };
+
+        cpu_topology topology;
+        std::vector<unsigned> cache_levels;
+        unsigned package = 0;
+        const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(buffer.data());
+        for (DWORD offset = 0; offset < length;)
+        {
+            const auto* info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(data + offset);
+            std::vector<unsigned> cpus;
+            switch (info->Relationship)
+            {
+            case RelationProcessorCore:
+                for (WORD group = 0; group < info->Processor.GroupCount; ++group)
+                    cpus_of(info->Processor.GroupMask[group], cpus);
+                for (unsigned cpu : cpus)
+                {
+                    cpu_info& cpu_entry = topology.get_cpu(cpu);
+                    // Windows does not report parked or offline processors separately
+                    cpu_entry.m_present = true;
+                    cpu_entry.m_online = true;
+                    cpu_entry.m_smt_siblings = cpus;
+                }
+                break;
+            case RelationNumaNode:
+                cpus_of(info->NumaNode.GroupMask, cpus);
+                for (unsigned cpu : cpus)
+                    topology.get_cpu(cpu).m_node = info->NumaNode.NodeNumber;
+                break;
+            case RelationCache:
+                cpus_of(info->Cache.GroupMask, cpus);
+                for (unsigned cpu : cpus)
+                {
+                    if (cpu >= cache_levels.size()) cache_levels.resize(cpu + 1, 0);
+                    if (info->Cache.Level < cache_levels[cpu]) continue;
+                    cache_levels[cpu] = info->Cache.Level;
+                    topology.get_cpu(cpu).m_cache_domain = cpus;
+                }
+                break;
+            case RelationProcessorPackage:
+                // Windows has no cluster relation, packages are numbered in the order they are reported
+                for (WORD group = 0; group < info->Processor.GroupCount; ++group)
+                    cpus_of(info->Processor.GroupMask[group], cpus);
+                for (unsigned cpu : cpus)
+                    topology.get_cpu(cpu).m_cluster = package;
+                ++package;
+                break;
+            default:
+                break;
+            }
+            offset += info->Size;
+        }
+
+        for (size_t cpu = 0; cpu < topology.m_cpus.size(); ++cpu)
+        {
+            cpu_info& info = topology.m_cpus[cpu];
+            if (info.m_present && info.m_cache_domain.empty()) info.m_cache_domain.push_back(static_cast<unsigned>(cpu));
+        }
+        return topology;
+#else
+        return read_sysfs("/sys");
+#endif
+    }
+
+    const cpu_topology& cpu_topology::host()
+    {
+        static const cpu_topology topology = read_host();
+        return topology;
+    }
+
+    const cpu_topology& cpu_topology::cached(const std::filesystem::path& sysfs_root)
+    {
+        static std::mutex mutex;
+        static std::map<std::filesystem::path, cpu_topology> topologies;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = topologies.find(sysfs_root);
+        if (found == topologies.end())
+            found = topologies.emplace(sysfs_root, read_sysfs(sysfs_root)).first;
+        return found->second;
+    }
+
+    bool cpu_topology::is_online(unsigned cpu) const
+    {
+        return cpu < m_cpus.size() && m_cpus[cpu].m_online;
+    }
+
+    bool cpu_topology::select(std::wstring_view item, std::vector<unsigned>& cpus) const
+    {
+        const auto is_present = [this](unsigned cpu) { return cpu < m_cpus.size() && m_cpus[cpu].m_present; };
+        // a group exists when it has a present CPU, but only its online CPUs are selected
+        const auto select_if = [this, &cpus](auto predicate) {
+            bool exists = false;
+            for (unsigned cpu = 0; cpu < m_cpus.size(); ++cpu)
+            {
+                if (!m_cpus[cpu].m_present || !predicate(m_cpus[cpu])) continue;
+                exists = true;
+                if (m_cpus[cpu].m_online) cpus.push_back(cpu);
+            }
+            return exists;
+        };
+        const auto select_online = [this, &cpus](const std::vector<unsigned>& group) {
+            for (unsigned cpu : group)
+            {
+                if (is_online(cpu)) cpus.push_back(cpu);
+            }
+            return true;
+        };
+        const auto select_index = [&item](std::wstring_view keyword, unsigned& index) {
+            return item.substr(0, keyword.size()) == keyword && parse_index(item.substr(keyword.size()), index);
+        };
+
+        unsigned index = 0;
+        if (item == L"all")
+            return select_if([](const cpu_info&) { return true; });
+        if (item == L"online")
+            return select_if([](const cpu_info& info) { return info.m_online; });
+        if (select_index(L"node", index))
+            return select_if([index](const cpu_info& info) { return info.m_node == index; });
+        if (select_index(L"cluster", index))
+            return select_if([index](const cpu_info& info) { return info.m_cluster == index; });
+        if (select_index(L"smt-siblings-of:", index))
+        {
+            if (!is_present(index)) return false;
+            return select_online(m_cpus[index].m_smt_siblings);
+        }
+        if (select_index(L"cache-domain-of:", index))
+        {
+            if (!is_present(index)) return false;
+            return select_online(m_cpus[index].m_cache_domain);
+        }
+
+        const size_t dash = item.find(L'-');
+        unsigned last = 0;
+        if (!parse_index(item.substr(0, dash), index)) return false;
+        last = index;
+        if (dash != std::wstring_view::npos && (!parse_index(item.substr(dash + 1), last) || last < index)) return false;
+        for (unsigned cpu = index; cpu <= last; ++cpu)
+        {
+            if (!is_present(cpu)) return false;
+        }
+        for (unsigned cpu = index; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+        return true;
+    }
+}
@@ -0,0 +1,85 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ArgParser {
+    // The CPUs of a host, indexed by logical CPU number, with what the -c selectors need to know
+    // about each of them.
+    struct cpu_info {
+        static constexpr unsigned NO_CLUSTER = ~0u; // sysfs drops the topology of offline CPUs
+
+        bool m_present = false;
+        bool m_online = false;
+        unsigned m_node = 0;
+        unsigned m_cluster = NO_CLUSTER;
+        std::vector<unsigned> m_smt_siblings;  // hardware threads of the same core, the CPU included
+        std::vector<unsigned> m_cache_domain;  // CPUs sharing its last level cache, the CPU included
+    };
+
+    class cpu_topology {
+    public:
+        // Reads <sysfs_root>/devices/system/cpu and <sysfs_root>/devices/system/node, so tests can
+        // point it at a fake tree. A CPU without topology files is its own SMT core and cache
+        // domain, in no cluster and in node 0 unless a node lists it. Returns an empty topology
+        // when the root has no CPU list.
+        static cpu_topology read_sysfs(const std::filesystem::path& sysfs_root);
+        // The topology of the running host, read once per process: sysfs under /sys, or
+        // GetLogicalProcessorInformationEx on Windows, where every present CPU is online.
+        static const cpu_topology& host();
+        // One topology per sysfs root, each read once per process.
+        static const cpu_topology& cached(const std::filesystem::path& sysfs_root);
+
+        const std::vector<cpu_info>& get_cpus() const { return m_cpus; }
+        bool is_online(unsigned cpu) const;
+
+        // Appends the CPUs one element of a -c list names: an index, a range or a selector (see
+        // validators::is_core_list). Returns false when it names a node, cluster or CPU the host
+        // does not have. Selectors append only their online CPUs, indexes and ranges are appended
+        // as given and not checked for being online here.
+        bool select(std::wstring_view item, std::vector<unsigned>& cpus) const;
+
+        // Parses a kernel CPU list such as "0-3,8,10-11"
+        static bool parse_cpu_list(std::string_view text, std::vector<unsigned>& cpus);
+
+    private:
+        static cpu_topology read_host();
+        cpu_info& get_cpu(unsigned cpu);
+
+        std::vector<cpu_info> m_cpus;
+    };
+}
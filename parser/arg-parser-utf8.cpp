@@ -0,0 +1,406 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include "arg-parser-utf8.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define ARG_PARSER_UTF8_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define ARG_PARSER_UTF8_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ArgParser {
+    namespace {
+        constexpr char32_t REPLACEMENT_CHARACTER = 0xFFFD;
+        constexpr size_t ASCII_BLOCK = 16;
+
+        inline bool is_surrogate(char32_t code_point)
+        {
+            return code_point >= 0xD800 && code_point <= 0xDFFF;
+        }
+
+        inline wchar_t* put_wide(wchar_t* out, char32_t code_point)
+        {
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                if (code_point >= 0x10000)
+                {
+                    code_point -= 0x10000;
+                    *out++ = static_cast<wchar_t>(0xD800 + (code_point >> 10));
+                    *out++ = static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+                    return out;
+                }
+            }
+            *out++ = static_cast<wchar_t>(code_point);
+            return out;
+        }
+
+        inline char* put_utf8(char* out, char32_t code_point)
+        {
+            if (code_point < 0x80)
+            {
+                *out++ = static_cast<char>(code_point);
+            }
+            else if (code_point < 0x800)
+            {
+                *out++ = static_cast<char>(0xC0 | (code_point >> 6));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            else if (code_point < 0x10000)
+            {
+                *out++ = static_cast<char>(0xE0 | (code_point >> 12));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            else
+            {
+                *out++ = static_cast<char>(0xF0 | (code_point >> 18));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                *out++ = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                *out++ = static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            return out;
+        }
+
+        // Decodes one UTF-8 sequence at in[i]; returns its length, or 0 when it is malformed.
+        size_t decode_utf8(const unsigned char* in, size_t i, size_t size, char32_t& code_point)
+        {
+            const unsigned char lead = in[i];
+            size_t length;
+            char32_t minimum;
+            if (lead < 0x80) { code_point = lead; return 1; }
+            else if ((lead & 0xE0) == 0xC0) { length = 2; code_point = lead & 0x1F; minimum = 0x80; }
+            else if ((lead & 0xF0) == 0xE0) { length = 3; code_point = lead & 0x0F; minimum = 0x800; }
+            else if ((lead & 0xF8) == 0xF0) { length = 4; code_point = lead & 0x07; minimum = 0x10000; }
+            else return 0;
+
+            if (size - i < length) return 0;
+            for (size_t k = 1; k < length; ++k)
+            {
+                const unsigned char next = in[i + k];
+                if ((next & 0xC0) != 0x80) return 0;
+                code_point = (code_point << 6) | (next & 0x3F);
+            }
+            if (code_point < minimum || code_point > 0x10FFFF || is_surrogate(code_point)) return 0;
+            return length;
+        }
+
+        // Decodes one wchar_t code point at in[i]; returns the number of units used, or 0 when it is malformed.
+        size_t decode_wide(const wchar_t* in, size_t i, size_t size, char32_t& code_point)
+        {
+            code_point = static_cast<char32_t>(in[i]);
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                code_point &= 0xFFFF;
+                if (code_point >= 0xD800 && code_point <= 0xDBFF && i + 1 < size)
+                {
+                    const char32_t low = static_cast<char32_t>(in[i + 1]) & 0xFFFF;
+                    if (low >= 0xDC00 && low <= 0xDFFF)
+                    {
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                        return 2;
+                    }
+                }
+            }
+            if (code_point > 0x10FFFF || is_surrogate(code_point)) return 0;
+            return 1;
+        }
+
+        // Widens 16 ASCII bytes; returns false without writing when any of them is not ASCII.
+        inline bool widen_ascii_block(const char* in, wchar_t* out)
+        {
+#if defined(ARG_PARSER_UTF8_SSE2)
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            if (_mm_movemask_epi8(bytes) != 0) return false;
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            __m128i* dst = reinterpret_cast<__m128i*>(out);
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                _mm_storeu_si128(dst, low);
+                _mm_storeu_si128(dst + 1, high);
+            }
+            else
+            {
+                _mm_storeu_si128(dst, _mm_unpacklo_epi16(low, zero));
+                _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(low, zero));
+                _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(high, zero));
+                _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(high, zero));
+            }
+            return true;
+#elif defined(ARG_PARSER_UTF8_NEON)
+            const uint8x16_t bytes = vld1q_u8(reinterpret_cast<const std::uint8_t*>(in));
+            if (vmaxvq_u8(bytes) >= 0x80) return false;
+            const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+            const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                std::uint16_t* dst = reinterpret_cast<std::uint16_t*>(out);
+                vst1q_u16(dst, low);
+                vst1q_u16(dst + 8, high);
+            }
+            else
+            {
+                std::uint32_t* dst = reinterpret_cast<std::uint32_t*>(out);
+                vst1q_u32(dst, vmovl_u16(vget_low_u16(low)));
+                vst1q_u32(dst + 4, vmovl_u16(vget_high_u16(low)));
+                vst1q_u32(dst + 8, vmovl_u16(vget_low_u16(high)));
+                vst1q_u32(dst + 12, vmovl_u16(vget_high_u16(high)));
+            }
+            return true;
+#else
+            for (size_t k = 0; k < ASCII_BLOCK; ++k)
+            {
+                if (static_cast<unsigned char>(in[k]) >= 0x80) return false;
+            }
+            for (size_t k = 0; k < ASCII_BLOCK; ++k) out[k] = static_cast<wchar_t>(in[k]);
+            return true;
+#endif
+        }
+
+        // Narrows 16 ASCII wchar_t units; returns false without writing when any of them is not ASCII.
+        inline bool narrow_ascii_block(const wchar_t* in, char* out)
+        {
+#if defined(ARG_PARSER_UTF8_SSE2)
+            const __m128i* src = reinterpret_cast<const __m128i*>(in);
+            __m128i packed;
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                const __m128i a = _mm_loadu_si128(src);
+                const __m128i b = _mm_loadu_si128(src + 1);
+                const __m128i high_bits = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, _mm_setzero_si128())) != 0xFFFF) return false;
+                packed = _mm_packus_epi16(a, b);
+            }
+            else
+            {
+                const __m128i a = _mm_loadu_si128(src);
+                const __m128i b = _mm_loadu_si128(src + 1);
+                const __m128i c = _mm_loadu_si128(src + 2);
+                const __m128i d = _mm_loadu_si128(src + 3);
+                const __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+                const __m128i high_bits = _mm_and_si128(any, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(high_bits, _mm_setzero_si128())) != 0xFFFF) return false;
+                packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+            return true;
+#elif defined(ARG_PARSER_UTF8_NEON)
+            uint8x16_t packed;
+            if constexpr (sizeof(wchar_t) == 2)
+            {
+                const std::uint16_t* src = reinterpret_cast<const std::uint16_t*>(in);
+                const uint16x8_t a = vld1q_u16(src);
+                const uint16x8_t b = vld1q_u16(src + 8);
+                if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80) return false;
+                packed = vcombine_u8(vmovn_u16(a), vmovn_u16(b));
+            }
+            else
+            {
+                const std::uint32_t* src = reinterpret_cast<const std::uint32_t*>(in);
+                const uint32x4_t a = vld1q_u32(src);
+                const uint32x4_t b = vld1q_u32(src + 4);
+                const uint32x4_t c = vld1q_u32(src + 8);
+                const uint32x4_t d = vld1q_u32(src + 12);
+                if (vmaxvq_u32(vorrq_u32(vorrq_u32(a, b), vorrq_u32(c, d))) >= 0x80) return false;
+                const uint16x8_t ab = vcombine_u16(vmovn_u32(a), vmovn_u32(b));
+                const uint16x8_t cd = vcombine_u16(vmovn_u32(c), vmovn_u32(d));
+                packed = vcombine_u8(vmovn_u16(ab), vmovn_u16(cd));
+            }
+            vst1q_u8(reinterpret_cast<std::uint8_t*>(out), packed);
+            return true;
+#else
+            for (size_t k = 0; k < ASCII_BLOCK; ++k)
+            {
+                if (static_cast<std::uint32_t>(in[k]) >= 0x80) return false;
+            }
+            for (size_t k = 0; k < ASCII_BLOCK; ++k) out[k] = static_cast<char>(in[k]);
+            return true;
+#endif
+        }
+    }
+
+    bool utf8_to_wide(std::string_view in, std::wstring& out, bool replace_invalid)
+    {
+        // every UTF-8 byte produces at most one wchar_t unit, so the output is sized once up front
+        const size_t base = out.size();
+        out.resize(base + in.size());
+        wchar_t* dst = &out[0] + base;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(in.data());
+        bool valid = true;
+
+        size_t i = 0;
+        while (i < in.size())
+        {
+            if (in.size() - i >= ASCII_BLOCK && widen_ascii_block(in.data() + i, dst))
+            {
+                i += ASCII_BLOCK;
+                dst += ASCII_BLOCK;
+                continue;
+            }
+
+            // decode up to the end of the block that failed the fast path
+            const size_t block_end = (std::min)(in.size(), i + ASCII_BLOCK);
+            while (i < block_end)
+            {
+                char32_t code_point;
+                const size_t length = decode_utf8(bytes, i, in.size(), code_point);
+                if (length == 0)
+                {
+                    valid = false;
+                    if (!replace_invalid)
+                    {
+                        out.resize(dst - out.data());
+                        return false;
+                    }
+                    code_point = REPLACEMENT_CHARACTER;
+                    i += 1;
+                }
+                else
+                {
+                    i += length;
+                }
+                dst = put_wide(dst, code_point);
+            }
+        }
+        out.resize(dst - out.data());
+        return valid;
+    }
+
+    bool wide_to_utf8(std::wstring_view in, std::string& out, bool replace_invalid)
+    {
+        // a BMP unit needs at most 3 bytes; a UTF-32 unit at most 4
+        constexpr size_t max_bytes_per_unit = sizeof(wchar_t) == 2 ? 3 : 4;
+        const size_t base = out.size();
+        out.resize(base + in.size() * max_bytes_per_unit);
+        char* dst = &out[0] + base;
+        bool valid = true;
+
+        size_t i = 0;
+        while (i < in.size())
+        {
+            if (in.size() - i >= ASCII_BLOCK && narrow_ascii_block(in.data() + i, dst))
+            {
+                i += ASCII_BLOCK;
+                dst += ASCII_BLOCK;
+                continue;
+            }
+
+            const size_t block_end = (std::min)(in.size(), i + ASCII_BLOCK);
+            while (i < block_end)
+            {
+                char32_t code_point;
+                const size_t length = decode_wide(in.data(), i, in.size(), code_point);
+                if (length == 0)
+                {
+                    valid = false;
+                    if (!replace_invalid)
+                    {
+                        out.resize(dst - out.data());
+                        return false;
+                    }
+                    code_point = REPLACEMENT_CHARACTER;
+                    i += 1;
+                }
+                else
+                {
+                    i += length;
+                }
+                dst = put_utf8(dst, code_point);
+            }
+        }
+        out.resize(dst - out.data());
+        return valid;
+    }
+
+    std::wstring utf8_to_wide(std::string_view in)
+    {
+        std::wstring out;
+        if (!utf8_to_wide(in, out, false))
+            throw std::invalid_argument("malformed UTF-8 input");
+        return out;
+    }
+
+    std::string wide_to_utf8(std::wstring_view in)
+    {
+        std::string out;
+        if (!wide_to_utf8(in, out, false))
+            throw std::invalid_argument("malformed UTF-16/UTF-32 input");
+        return out;
+    }
+
+    utf8_writer::utf8_writer(FILE* stream) : m_stream_sink(stream), m_sink(m_stream_sink), m_is_enabled(true)
+    {
+    }
+
+    utf8_writer::utf8_writer(output_sink& sink) : m_stream_sink(nullptr), m_sink(sink), m_is_enabled(sink.is_enabled())
+    {
+    }
+
+    utf8_writer::~utf8_writer()
+    {
+        flush();
+    }
+
+    utf8_writer& utf8_writer::operator<<(std::wstring_view text)
+    {
+        if (!m_is_enabled) return *this;
+        wide_to_utf8(text, m_buffer, true);
+        if (m_buffer.size() >= FLUSH_THRESHOLD) flush();
+        return *this;
+    }
+
+    utf8_writer& utf8_writer::operator<<(std::string_view text)
+    {
+        if (!m_is_enabled) return *this;
+        m_buffer.append(text);
+        if (m_buffer.size() >= FLUSH_THRESHOLD) flush();
+        return *this;
+    }
+
+    void utf8_writer::flush()
+    {
+        if (!m_is_enabled) return;
+        if (!m_buffer.empty())
+        {
+            m_sink.write(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+        m_sink.flush();
+    }
+}
@@ -0,0 +1,80 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "arg-parser-output.h"
+
+namespace ArgParser {
+    // Validating transcoder between UTF-8 and wchar_t text, which is UTF-16 where wchar_t is 16 bits
+    // (Windows) and UTF-32 where it is 32 bits. Runs of ASCII are converted 16 characters at a time
+    // with SSE2 or NEON; everything else goes through a scalar codec that rejects overlong forms,
+    // unpaired surrogates and code points above U+10FFFF.
+    //
+    // The functions append to `out` and return false when the input was malformed. With
+    // `replace_invalid` every malformed sequence is written as U+FFFD and conversion carries on;
+    // without it conversion stops at the first malformed sequence.
+    bool utf8_to_wide(std::string_view in, std::wstring& out, bool replace_invalid = false);
+    bool wide_to_utf8(std::wstring_view in, std::string& out, bool replace_invalid = false);
+
+    // Throw std::invalid_argument on malformed input.
+    std::wstring utf8_to_wide(std::string_view in);
+    std::string wide_to_utf8(std::wstring_view in);
+
+    // Buffers text as UTF-8 and hands it to an output_sink (or a C stream) in chunks of up to
+    // FLUSH_THRESHOLD bytes, so output does not depend on the locale and codecvt facets behind
+    // std::wcout. Malformed wide text is written as U+FFFD. The buffer is flushed when it fills,
+    // on flush() and on destruction; nothing is buffered for a sink that is not enabled.
+    class utf8_writer {
+    public:
+        explicit utf8_writer(FILE* stream);
+        explicit utf8_writer(output_sink& sink);
+        ~utf8_writer();
+        utf8_writer(const utf8_writer&) = delete;
+        utf8_writer& operator=(const utf8_writer&) = delete;
+
+        utf8_writer& operator<<(std::wstring_view text);
+        utf8_writer& operator<<(std::string_view text);
+        void flush();
+
+    private:
+        static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+        stream_sink m_stream_sink;
+        output_sink& m_sink;
+        const bool m_is_enabled;
+        std::string m_buffer;
+    };
+}
@@ -0,0 +1,276 @@
+// BSD 3-Clause License
+//
+// Copyright (c) 2024, Arm Limited
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+//    contributors may be used to endorse or promote products derived from
+//    this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Compile-time validator pipeline for flag values. A validator is a type with
+//
+//   static constexpr const char* name;
+//   static bool check(std::wstring_view value, validation_error& error);
+//
+// and validators compose through all_of<...> / any_of<...>. arg_parser_arg::set_validator<V>()
+// instantiates validate_values<V>, so the whole composed check is inlined into the loop that
+// consumes the values of one flag occurrence instead of going through std::function per value.
+
+namespace ArgParserArg {
+    struct validation_error {
+        const char* m_validator = nullptr;
+        const char* m_reason = nullptr;
+    };
+
+    namespace validators {
+        namespace detail {
+            constexpr bool is_digit(wchar_t c) { return c >= L'0' && c <= L'9'; }
+            constexpr bool is_alpha(wchar_t c) { return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z'); }
+
+            inline bool fail(validation_error& error, const char* validator, const char* reason)
+            {
+                error.m_validator = validator;
+                error.m_reason = reason;
+                return false;
+            }
+
+            // Parses a non-empty run of decimal digits, rejecting anything that overflows.
+            inline bool parse_uint(std::wstring_view value, unsigned long long& result)
+            {
+                if (value.empty()) return false;
+                result = 0;
+                for (wchar_t c : value)
+                {
+                    if (!is_digit(c)) return false;
+                    unsigned long long digit = static_cast<unsigned long long>(c - L'0');
+                    if (result > (~0ULL - digit) / 10) return false;
+                    result = result * 10 + digit;
+                }
+                return true;
+            }
+
+            struct core_selector {
+                std::wstring_view m_keyword;
+                bool m_has_index; // followed by a CPU, node or cluster number
+            };
+
+            constexpr core_selector CORE_SELECTORS[] = {
+                { L"all", false },
+                { L"online", false },
+                { L"node", true },
+                { L"cluster", true },
+                { L"smt-siblings-of:", true },
+                { L"cache-domain-of:", true }
+            };
+
+            // Length of the topology selector value starts with, 0 when it does not start with one
+            inline size_t core_selector_length(std::wstring_view value)
+            {
+                for (auto& selector : CORE_SELECTORS)
+                {
+                    if (value.substr(0, selector.m_keyword.size()) != selector.m_keyword) continue;
+                    size_t pos = selector.m_keyword.size();
+                    if (!selector.m_has_index) return pos;
+                    while (pos < value.size() && is_digit(value[pos])) ++pos;
+                    if (pos > selector.m_keyword.size()) return pos;
+                }
+                return 0;
+            }
+        }
+
+        struct is_uint {
+            static constexpr const char* name = "is_uint";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                unsigned long long parsed;
+                return detail::parse_uint(value, parsed) || detail::fail(error, name, "expected an unsigned integer");
+            }
+        };
+
+        template <unsigned long long Min, unsigned long long Max>
+        struct in_range {
+            static_assert(Min <= Max, "in_range requires Min <= Max");
+            static constexpr const char* name = "in_range";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                unsigned long long parsed;
+                if (!detail::parse_uint(value, parsed)) return detail::fail(error, name, "expected an unsigned integer");
+                return (parsed >= Min && parsed <= Max) || detail::fail(error, name, "value is out of range");
+            }
+        };
+
+        // Values is a reference to a constant array of std::wstring_view (or anything comparable to it).
+        template <const auto& Values>
+        struct one_of {
+            static constexpr const char* name = "one_of";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                for (auto it = std::begin(Values); it != std::end(Values); ++it)
+                {
+                    if (value == *it) return true;
+                }
+                return detail::fail(error, name, "value is not one of the accepted names");
+            }
+        };
+
+        // Number with up to 2 decimals followed by an optional unit: ms, s, m, h or d.
+        struct is_duration {
+            static constexpr const char* name = "is_duration";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                size_t pos = 0;
+                while (pos < value.size() && detail::is_digit(value[pos])) ++pos;
+                if (pos == 0) return detail::fail(error, name, "expected a number");
+                if (pos < value.size() && value[pos] == L'.')
+                {
+                    size_t decimals_start = ++pos;
+                    while (pos < value.size() && detail::is_digit(value[pos])) ++pos;
+                    size_t decimals = pos - decimals_start;
+                    if (decimals == 0 || decimals > 2) return detail::fail(error, name, "expected 1 or 2 decimals");
+                }
+                std::wstring_view unit = value.substr(pos);
+                if (unit.empty() || unit == L"ms" || unit == L"s" || unit == L"m" || unit == L"h" || unit == L"d")
+                    return true;
+                return detail::fail(error, name, "unit must be one of ms, s, m, h or d");
+            }
+        };
+
+        // Comma separated list of core indexes, inclusive ranges and topology selectors, for example
+        // 0,2-5,7 or node1,smt-siblings-of:12. The selectors are all, online, node<N>, cluster<N>,
+        // smt-siblings-of:<CPU> and cache-domain-of:<CPU>; only their shape is checked here, see
+        // arg_parser::resolve_cores for matching them to the host.
+        struct is_core_list {
+            static constexpr const char* name = "is_core_list";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                size_t pos = 0;
+                while (true)
+                {
+                    size_t start = pos;
+                    pos += detail::core_selector_length(value.substr(pos));
+                    if (pos == start)
+                    {
+                        while (pos < value.size() && detail::is_digit(value[pos])) ++pos;
+                        if (pos == start) return detail::fail(error, name, "expected a core index or selector");
+                    }
+                    else if (pos < value.size() && value[pos] == L'-')
+                    {
+                        return detail::fail(error, name, "a selector cannot start a core range");
+                    }
+                    if (pos < value.size() && value[pos] == L'-')
+                    {
+                        size_t range_end = ++pos;
+                        while (pos < value.size() && detail::is_digit(value[pos])) ++pos;
+                        if (pos == range_end) return detail::fail(error, name, "expected the end of a core range");
+                    }
+                    if (pos == value.size()) return true;
+                    if (value[pos] != L',') return detail::fail(error, name, "expected ',' between cores");
+                    ++pos;
+                }
+            }
+        };
+
+        // Shape of a file system path, without touching the file system: no reserved characters
+        // after an optional \\?\ or \\.\ device prefix, and on Windows ':' only as a drive
+        // designator.
+        struct is_path_shape {
+            static constexpr const char* name = "is_path_shape";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                if (value.empty()) return detail::fail(error, name, "path is empty");
+                const size_t start = value.substr(0, 4) == L"\\\\?\\" || value.substr(0, 4) == L"\\\\.\\" ? 4 : 0;
+                for (size_t i = start; i < value.size(); ++i)
+                {
+                    wchar_t c = value[i];
+                    if (c < 0x20) return detail::fail(error, name, "path contains a control character");
+                    switch (c)
+                    {
+                    case L'<': case L'>': case L'"': case L'|': case L'?': case L'*':
+                        return detail::fail(error, name, "path contains a reserved character");
+#ifdef _WIN32
+                    case L':':
+                        if (i != start + 1 || !detail::is_alpha(value[start]))
+                            return detail::fail(error, name, "':' is only allowed after a drive letter");
+                        break;
+#endif
+                    default:
+                        break;
+                    }
+                }
+                return true;
+            }
+        };
+
+        template <class... Validators>
+        struct all_of {
+            static constexpr const char* name = "all_of";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                return (Validators::check(value, error) && ...);
+            }
+        };
+
+        template <class... Validators>
+        struct any_of {
+            static constexpr const char* name = "any_of";
+            static bool check(std::wstring_view value, validation_error& error)
+            {
+                // the error of the last alternative is reported when none of them matches
+                return (Validators::check(value, error) || ...);
+            }
+        };
+
+        // True when a validator only accepts unsigned integers, so its values can be emitted as JSON numbers.
+        template <class Validator> struct yields_uint : std::false_type {};
+        template <> struct yields_uint<is_uint> : std::true_type {};
+        template <unsigned long long Min, unsigned long long Max> struct yields_uint<in_range<Min, Max>> : std::true_type {};
+        template <class... Validators> struct yields_uint<all_of<Validators...>> : std::disjunction<yields_uint<Validators>...> {};
+        template <class... Validators> struct yields_uint<any_of<Validators...>> : std::bool_constant<sizeof...(Validators) != 0 && std::conjunction_v<yields_uint<Validators>...>> {};
+    }
+
+    // Checks every value of one flag occurrence. On failure, failed_index is the offset of the
+    // rejected value and error names the validator that rejected it.
+    template <class Validator>
+    bool validate_values(const std::wstring* values, size_t count, validation_error& error, size_t& failed_index)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!Validator::check(std::wstring_view(values[i]), error))
+            {
+                failed_index = i;
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -29,136 +29,818 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "arg-parser.h"
-#include <iostream>
-#include <codecvt>
-#include <locale>
+#include "arg-parser-tokenizer.h"
+#include "arg-parser-utf8.h"
+#include <algorithm>
 #include <cwchar>
+#include <iterator>
 #include <vector>
-#include <sstream>
 
 namespace ArgParser {
-    arg_parser::arg_parser() {}
+    namespace {
+        // Rules between flags that their descriptions state, checked once after the flag loop.
+        constexpr flag_rule k_flag_rules[] = {
+            { FLAG_RULE::IMPLIES, L"--disassemble", L"--annotate" },
+            { FLAG_RULE::REQUIRES, L"--output-csv", L"-t" },
+            { FLAG_RULE::REQUIRES, L"--pdb_file", L"--pe_file" },
+            { FLAG_RULE::REQUIRES, L"-i", L"-t" },
+            { FLAG_RULE::REQUIRES, L"-n", L"-t" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--annotate", L"sample" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--annotate", L"record" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--disassemble", L"sample" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--disassemble", L"record" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--symbol", L"sample" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--symbol", L"record" },
+            { FLAG_RULE::ONLY_WITH_COMMAND, L"--record_spawn_delay", L"record" }
+        };
+
+        // Column of the caret under the offending argument, or the end of the command line
+        // Where the token arg starts in the command line, or its end when arg is not one of its tokens
+        size_t find_error_position(const std::wstring& command, const std::wstring& arg)
+        {
+            for (std::size_t pos = command.find(L" " + arg); pos != std::wstring::npos; pos = command.find(L" " + arg, pos + 1))
+            {
+                const std::size_t end = pos + 1 + arg.size();
+                if (end == command.size() || command[end] == L' ') return pos + 1;
+            }
+            return command.length();
+        }
+
+        std::wstring exception_message(const std::exception& err)
+        {
+            std::wstring message;
+            utf8_to_wide(err.what(), message, true);
+            return message;
+        }
+    }
+
+    std::wstring command_name(COMMAND_CLASS command)
+    {
+        for (auto& token : k_command_tokens)
+        {
+            if (token.m_command == command) return token.m_token;
+        }
+        return L"";
+    }
+
+    std::vector<std::wstring> command_aliases(COMMAND_CLASS command)
+    {
+        std::vector<std::wstring> aliases;
+        bool named = false;
+        for (auto& token : k_command_tokens)
+        {
+            if (token.m_command != command) continue;
+            if (named) aliases.emplace_back(token.m_token);
+            named = true;
+        }
+        return aliases;
+    }
+
+    arg_parser::arg_parser()
+    {
+        namespace validators = ArgParserArg::validators;
+
+        timeout_arg.set_validator<validators::is_duration>();
+        interval_arg.set_validator<validators::is_duration>();
+        iteration_arg.set_validator<validators::all_of<validators::is_uint, validators::in_range<1, 1'000'000>>>();
+        sample_display_row_arg.set_validator<validators::all_of<validators::is_uint, validators::in_range<1, 1'000'000>>>();
+        record_spawn_delay_arg.set_validator<validators::is_uint>();
+        dmc_arg.set_validator<validators::is_uint>();
+        cores_arg.set_validator<validators::is_core_list>();
+        pe_file_arg.set_validator<validators::is_path_shape>();
+        pdb_file_arg.set_validator<validators::is_path_shape>();
+        metric_config_arg.set_validator<validators::is_path_shape>();
+        output_filename_arg.set_validator<validators::is_path_shape>();
+        output_csv_filename_arg.set_validator<validators::is_path_shape>();
+        output_prefix_arg.set_validator<validators::is_path_shape>();
+        daemon_command.set_validator<validators::is_path_shape>();
+        build_index();
+        m_constraints = flag_constraints(k_flag_rules, std::size(k_flag_rules),
+            [this](std::wstring_view name) { return match_flag(name); },
+            [this](std::wstring_view name) -> arg_parser_arg* {
+                const auto command = m_command_index.find(name);
+                return command != m_command_index.end() ? command->second : nullptr;
+            });
+    }
 
     void arg_parser::parse(
         _In_ const int argc,
         _In_reads_(argc) const wchar_t* argv[]
     )
     {
-        wstr_vec raw_args;
-        for (int i = 1; i < argc; i++)
+        ARG_PARSER_STATS_RESET(m_stats);
+        // tokens are stored once in m_arg_array, which also backs the error messages
+        const size_t first_token = m_arg_array.size();
         {
-            raw_args.push_back(argv[i]);
-            m_arg_array.push_back(argv[i]);
+            ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::ARGV_INGESTION);
+            if (argc > 1)
+                m_arg_array.reserve(first_token + argc - 1);
+            for (int i = 1; i < argc; i++)
+            {
+                m_arg_array.push_back(argv[i]);
+            }
+            ARG_PARSER_STATS_ADD(m_stats, m_tokens, m_arg_array.size() - first_token);
         }
+        parse_tokens(first_token);
+    }
 
-        if (raw_args.size() == 0)
-            throw_invalid_arg(L"", L"warning: No arguments were found!");
-
-    #pragma region Command Selector
-        for (auto& command : m_commands_list)
+    void arg_parser::parse(
+        _In_ const int argc,
+        _In_reads_(argc) const char* argv[]
+    )
+    {
+        ARG_PARSER_STATS_RESET(m_stats);
+        const size_t first_token = m_arg_array.size();
         {
-            if (command->parse(raw_args)) {
-                m_command = command->m_command;
-                raw_args.erase(raw_args.begin());
-
-                break;
+            ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::ARGV_INGESTION);
+            if (argc > 1)
+                m_arg_array.reserve(first_token + argc - 1);
+            for (int i = 1; i < argc; i++)
+            {
+                m_arg_array.emplace_back();
+                if (!utf8_to_wide(argv[i], m_arg_array.back(), true))
+                    throw_invalid_arg(m_arg_array.back(), L"Error: argument is not valid UTF-8");
             }
+            ARG_PARSER_STATS_ADD(m_stats, m_tokens, m_arg_array.size() - first_token);
         }
-        if (m_command == COMMAND_CLASS::NO_COMMAND) {
-            throw_invalid_arg(raw_args.front(), L"warning: command not recognized!");
-        }
+        parse_tokens(first_token);
+    }
+
+    void arg_parser::parse_tokens(size_t first_token)
+    {
+        if (m_arg_array.size() == first_token)
+            throw_invalid_arg(L"", L"warning: No arguments were found!");
+
+        const size_t flags_begin = parse_command(first_token);
         if (m_command == COMMAND_CLASS::HELP) {
             return;
         }
+        parse_flags(flags_begin);
+
+    #ifdef ARG_PARSER_ENABLE_STATS
+        for (auto* flags_list : { &m_flags_list, &m_hidden_flags_list })
+        {
+            for (auto& current_flag : *flags_list)
+            {
+                m_stats.m_check_calls += current_flag->m_check_call_count;
+                current_flag->m_check_call_count = 0;
+            }
+        }
+    #endif
+
+    #pragma region Validation
+        {
+            ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::VALIDATION);
+            validate_parsed_args();
+        }
     #pragma endregion
+    }
 
-        while (raw_args.size() > 0)
+    size_t arg_parser::parse_command(size_t first_token)
+    {
+        const wstr_vec& raw_args = m_arg_array;
+
+    #pragma region Command Selector
+        size_t command_arg_count = 0;
         {
-            size_t initial_size = raw_args.size();
+            ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::COMMAND_SELECTION);
+            ARG_PARSER_STATS_ADD(m_stats, m_flag_probes, 1);
+            const auto command = m_command_index.find(raw_args[first_token]);
+            try
+            {
+                if (command != m_command_index.end() && command->second->parse(raw_args, first_token)) {
+                    m_command = command->second->m_command;
+                    m_command_arg = command->second;
+                    command_arg_count = command->second->get_arg_count();
+                }
+            }
+            catch (const std::exception& err)
+            {
+                throw_invalid_arg(raw_args[first_token], L"Error: " + exception_message(err));
+            }
+            if (m_command == COMMAND_CLASS::NO_COMMAND) {
+                throw_invalid_arg(raw_args[first_token], L"warning: command not recognized!");
+            }
+        }
+    #pragma endregion
+
+        return first_token + 1 + command_arg_count;
+    }
 
-            for (auto& current_flag : m_flags_list)
+    void arg_parser::parse_flags(size_t position)
+    {
+        const wstr_vec& raw_args = m_arg_array;
+
+    #pragma region Flags
+        {
+            ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::FLAG_LOOP);
+            // flags are consumed by moving a cursor over raw_args, the tokens themselves are never copied again or shifted
+            while (position < raw_args.size())
             {
+                ARG_PARSER_STATS_ADD(m_stats, m_flag_probes, 1);
+                arg_parser_arg* current_flag = match_flag(raw_args[position]);
+                bool is_parsed = false;
                 try
                 {
-                    if (current_flag->parse(raw_args)) {
-                        raw_args.erase(raw_args.begin(), raw_args.begin() + current_flag->get_arg_count() + 1);
-                    }
+                    is_parsed = current_flag != nullptr && current_flag->parse(raw_args, position);
                 }
                 catch (const std::exception& err)
                 {
-                    throw_invalid_arg(raw_args.front(), L"Error: " + std::wstring(err.what(), err.what() + std::strlen(err.what())));
+                    throw_invalid_arg(raw_args[position], L"Error: " + exception_message(err));
                 }
+
+                // a token that names no known flag cannot move the cursor, so the command is unknown
+                if (!is_parsed)
+                {
+                    throw_invalid_arg(raw_args[position], L"Error: Unrecognized command");
+                }
+                position += current_flag->get_arg_count() + 1;
             }
+        }
+    #pragma endregion
+    }
+
+    arg_parser_arg* arg_parser::match_flag(std::wstring_view token) const
+    {
+        const auto flag = m_flag_index.find(token);
+        return flag != m_flag_index.end() ? flag->second : nullptr;
+    }
 
-            // if going over all the known arguments doesn't affect the size of the raw_args, then the command is unkown
-            if (initial_size == raw_args.size())
+    void arg_parser::build_index()
+    {
+        const auto add_names = [](auto& index, auto* arg) {
+            // emplace keeps the first arg for a name, empty aliases never match a token
+            if (!arg->m_name.empty()) index.emplace(arg->m_name, arg);
+            for (auto& alias : arg->m_aliases)
             {
-                throw_invalid_arg(raw_args.front(), L"Error: Unrecognized command");
+                if (!alias.empty()) index.emplace(alias, arg);
             }
+        };
+
+        m_command_index.clear();
+        m_command_index.reserve(2 * m_commands_list.size());
+        for (auto& command : m_commands_list)
+            add_names(m_command_index, command);
+
+        m_flag_index.clear();
+        m_flag_index.reserve(2 * (m_flags_list.size() + m_hidden_flags_list.size()));
+        for (auto* flags_list : { &m_flags_list, &m_hidden_flags_list })
+        {
+            for (auto& current_flag : *flags_list)
+                add_names(m_flag_index, current_flag);
+        }
+    }
+
+    void arg_parser::register_plugins(plugin_registry&& registry)
+    {
+        // every name is checked before anything is taken over, so a clash leaves the parser as it was
+        for (const std::wstring_view name : registry.m_names)
+        {
+            if (m_command_index.count(name) != 0 || m_flag_index.count(name) != 0)
+                throw std::invalid_argument("Plugin name `" + wide_to_utf8(name) + "` is already used by the parser.");
+        }
 
+        m_commands_list.reserve(m_commands_list.size() + registry.m_commands.size());
+        m_flags_list.reserve(m_flags_list.size() + registry.m_flags.size());
+        m_plugin_args.reserve(m_plugin_args.size() + registry.m_commands.size() + registry.m_flags.size());
+        for (auto& command : registry.m_commands)
+        {
+            m_commands_list.push_back(command.get());
+            m_plugin_args.push_back(std::move(command));
         }
+        for (auto& flag : registry.m_flags)
+        {
+            m_flags_list.push_back(flag.get());
+            m_plugin_args.push_back(std::move(flag));
+        }
+        registry.m_commands.clear();
+        registry.m_flags.clear();
+        registry.m_names.clear();
+
+        build_index();
+    }
+
+    const arg_parser_arg_command* arg_parser::get_command_arg() const
+    {
+        return m_command_arg;
+    }
+
+    arg_parser_arg_command& plugin_registry::add_command(arg_parser_arg_command command)
+    {
+        auto owned = std::make_unique<arg_parser_arg_command>(std::move(command));
+        reserve_names(*owned);
+        m_commands.push_back(std::move(owned));
+        return *m_commands.back();
+    }
+
+    void plugin_registry::adopt_flag(std::unique_ptr<arg_parser_arg> flag)
+    {
+        reserve_names(*flag);
+        m_flags.push_back(std::move(flag));
+    }
+
+    void plugin_registry::reserve_names(const arg_parser_arg& arg)
+    {
+        bool has_name = false;
+        const auto check = [this, &has_name](const std::wstring& name) {
+            if (name.empty()) return;
+            if (m_names.count(name) != 0)
+                throw std::invalid_argument("Plugin name `" + wide_to_utf8(name) + "` is already registered.");
+            has_name = true;
+        };
+        check(arg.m_name);
+        for (auto& alias : arg.m_aliases)
+            check(alias);
+        if (!has_name)
+            throw std::invalid_argument("Plugin commands and flags need a name.");
+
+        // only once every name is known to be free, so a rejected arg reserves nothing
+        if (!arg.m_name.empty()) m_names.insert(arg.m_name);
+        for (auto& alias : arg.m_aliases)
+        {
+            if (!alias.empty()) m_names.insert(alias);
+        }
+    }
+
+    void arg_parser::reset()
+    {
+        m_arg_array.clear();
+        m_command = COMMAND_CLASS::NO_COMMAND;
+        m_command_arg = nullptr;
+        for (auto& command : m_commands_list)
+            command->reset();
+        for (auto* flags_list : { &m_flags_list, &m_hidden_flags_list })
+        {
+            for (auto& current_flag : *flags_list)
+                current_flag->reset();
+        }
+        m_symbol_matcher = symbol_matcher();
+        ARG_PARSER_STATS_RESET(m_stats);
+    }
+
+    bool arg_parser::is_validated_flag(const arg_parser_arg* flag) const
+    {
+        // keep in sync with the flags validate_parsed_args reads
+        return flag == &symbol_arg || flag == &events_arg || flag == &metrics_arg
+            || flag == &event_config_arg || flag == &metric_config_arg || flag == &timeline_opt
+            || flag == &output_csv_filename_arg || flag == &output_filename_arg || flag == &output_prefix_arg;
+    }
+
+    void arg_parser::check_flag_rules()
+    {
+        // every broken rule is reported in the same error
+        std::vector<rule_violation> violations;
+        m_constraints.evaluate(m_command_arg, violations);
+        if (!violations.empty())
+        {
+            std::wstring message = L"Error: the following flags are used incorrectly:";
+            for (auto& violation : violations)
+                message += L"\n\t" + m_constraints.describe(violation);
+            throw_invalid_arg(violations.front().m_flag->get_name(), message);
+        }
+    }
+
+    void arg_parser::validate_parsed_args()
+    {
+        check_flag_rules();
+
+        if (symbol_arg.m_is_parsed)
+        {
+            try
+            {
+                m_symbol_matcher = symbol_matcher(symbol_matcher::split_patterns(symbol_arg.get_values()));
+            }
+            catch (const std::exception& err)
+            {
+                throw_invalid_arg(symbol_arg.get_values().front(), L"Error: " + exception_message(err));
+            }
+        }
+        else
+        {
+            m_symbol_matcher = symbol_matcher();
+        }
+
+        // names in comma separated lists are looked up in the built-in catalogue; -E and -C
+        // bring their own definitions, so the matching list can only be checked without them
+        std::vector<token_span<wchar_t>> spans;
+        const auto check_names = [this, &spans](const arg_parser_arg& arg, auto is_known, const wchar_t* kind) {
+            for (auto& value : arg.get_values())
+            {
+                tokenize(value, spans);
+                for (size_t i = 0; i < spans.size(); ++i)
+                {
+                    // the tokenizer splits on '-' for core ranges, in a name it is just a character
+                    const size_t first = i;
+                    while (spans[i].m_delimiter == L'-' && i + 1 < spans.size()) ++i;
+                    const wchar_t* begin = spans[first].m_text.data();
+                    const std::wstring_view name(begin, spans[i].m_text.data() + spans[i].m_text.size() - begin);
+                    // braces leave empty tokens and the token after ':' is a sampling frequency
+                    if (name.empty() || (first > 0 && spans[first - 1].m_delimiter == L':')) continue;
+                    // a PMU qualified event such as arm_spe_0/ld=1,st=1/ is checked by the driver;
+                    // skip to the token that closes it
+                    if (name.find(L'/') != std::wstring_view::npos)
+                    {
+                        size_t slashes = std::count(name.begin(), name.end(), L'/');
+                        while (slashes % 2 != 0 && i + 1 < spans.size())
+                        {
+                            ++i;
+                            slashes += std::count(spans[i].m_text.begin(), spans[i].m_text.end(), L'/');
+                        }
+                        continue;
+                    }
+                    if (!is_known(name))
+                        throw_invalid_arg(value, L"Error: unknown " + std::wstring(kind) + L" `" + std::wstring(name) + L"`, see `wperf list`.");
+                }
+            }
+        };
+        if (events_arg.m_is_parsed && !event_config_arg.m_is_parsed)
+            check_names(events_arg, [](std::wstring_view name) { return is_raw_event(name) || find_event(name) != nullptr; }, L"event");
+        if (metrics_arg.m_is_parsed && !metric_config_arg.m_is_parsed)
+            check_names(metrics_arg, [](std::wstring_view name) { return find_metric(name) != nullptr; }, L"metric");
+        if (m_command == COMMAND_CLASS::MAN)
+            check_names(man_command, [](std::wstring_view name) { return find_event(name) != nullptr || find_metric(name) != nullptr; }, L"event or metric");
+
+        check_timeline_outputs();
+    }
+
+    std::vector<std::pair<const arg_parser_arg*, std::filesystem::path>> arg_parser::get_timeline_output_paths() const
+    {
+        std::vector<std::pair<const arg_parser_arg*, std::filesystem::path>> paths;
+        if (!timeline_opt.m_is_parsed) return paths;
+
+        const std::wstring prefix = output_prefix_arg.m_is_parsed ? output_prefix_arg.get_values().back() : L"";
+        for (const arg_parser_arg* flag : { &output_csv_filename_arg, &output_filename_arg })
+        {
+            if (flag->m_is_parsed) paths.emplace_back(flag, resolve_output_path(prefix, flag->get_values().back()));
+        }
+        return paths;
+    }
+
+    void arg_parser::check_timeline_outputs() const
+    {
+        std::wstring message;
+        const std::wstring* first_failed = nullptr;
+        for (auto& [flag, path] : get_timeline_output_paths())
+        {
+            if (can_create_file(path)) continue;
+            message += L"\n\t" + path.wstring() + L" (" + flag->get_name() + L")";
+            if (first_failed == nullptr) first_failed = &flag->get_values().back();
+        }
+        if (first_failed != nullptr)
+            throw_invalid_arg(*first_failed, L"Error: the following timeline outputs cannot be created:" + message);
+    }
+
+    timeline_outputs arg_parser::open_timeline_outputs() const
+    {
+        timeline_outputs outputs;
+        std::wstring message;
+        const std::wstring* first_failed = nullptr;
+        for (auto& [flag, path] : get_timeline_output_paths())
+        {
+            timeline_output& output = flag == &output_csv_filename_arg ? outputs.m_csv : outputs.m_json;
+            try
+            {
+                output.m_sink = std::make_unique<file_sink>(path);
+                output.m_path = path;
+            }
+            catch (const std::exception&)
+            {
+                message += L"\n\t" + path.wstring() + L" (" + flag->get_name() + L")";
+                if (first_failed == nullptr) first_failed = &flag->get_values().back();
+            }
+        }
+        if (first_failed != nullptr)
+            throw_invalid_arg(*first_failed, L"Error: the following timeline outputs cannot be opened:" + message);
+        return outputs;
     }
 
     void arg_parser::print_help() const
     {
-        std::wcout << L"NAME:\n" 
+        ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::PRINT_HELP);
+        utf8_writer output(*m_output_sink);
+        output << L"NAME:\n"
 
             << L"\twperf - Performance analysis tools for Windows on Arm\n\n"
             << L"\tUsage: wperf <command> [options]\n\n"
             << L"SYNOPSIS:\n\n";
         for (auto& command : m_commands_list)
         {
-            std::wcout << L"\t" << command->get_all_flags_string() << L"\n" << command->get_usage_text() << L"\n" ;
+            output << L"\t" << command->get_all_flags_string() << L"\n" << command->get_usage_text() << L"\n" ;
         }
 
-        std::wcout << L"OPTIONS:\n\n";
+        output << L"OPTIONS:\n\n";
         for (auto& flag : m_flags_list)
         {
-            std::wcout << L" " << flag->get_help() << L"\n";
+            output << L" " << flag->get_help() << L"\n";
         }
-        std::wcout << L"EXAMPLES:\n\n";
+        output << L"EXAMPLES:\n\n";
         for (auto& command : m_commands_list)
         {
             if (command->get_examples().empty()) continue;
-            std::wcout << L"  " << command->get_examples() <<L"\n";
+            output << L"  " << command->get_examples() <<L"\n";
         }
     }
 
-    #pragma region error handling
-    void arg_parser::throw_invalid_arg(const std::wstring& arg, const std::wstring& additional_message) const
+    COMMAND_CLASS arg_parser::sniff_command(
+        _In_ const int argc,
+        _In_reads_(argc) const wchar_t* argv[]
+    ) noexcept
     {
-        std::wstring command = L"wperf";
-        for (int i = 1; i < m_arg_array.size(); ++i) {
-            if (i > 0) {
-                command.append(L" ");
+        if (argc < 2 || argv == nullptr || argv[1] == nullptr)
+            return COMMAND_CLASS::NO_COMMAND;
+
+        const wchar_t* token = argv[1];
+        for (auto& command : k_command_tokens)
+        {
+            if (std::wcscmp(token, command.m_token) == 0)
+                return command.m_command;
+        }
+        return COMMAND_CLASS::NO_COMMAND;
+    }
+
+    void arg_parser::set_output_sink(output_sink& sink)
+    {
+        m_output_sink = &sink;
+    }
+
+    void arg_parser::set_error_sink(output_sink& sink)
+    {
+        m_error_sink = &sink;
+    }
+
+    output_sink& arg_parser::get_output_sink() const
+    {
+        return *m_output_sink;
+    }
+
+    output_sink& arg_parser::get_error_sink() const
+    {
+        return *m_error_sink;
+    }
+
+    const parse_stats& arg_parser::get_stats() const
+    {
+        return m_stats;
+    }
+
+    const symbol_matcher& arg_parser::get_symbol_matcher() const
+    {
+        return m_symbol_matcher;
+    }
+
+    void arg_parser::validate_paths() const
+    {
+        validate_paths(probe_file_system, &path_probe_cache::instance());
+    }
+
+    void arg_parser::validate_paths(const path_probe& probe, path_probe_cache* cache) const
+    {
+        ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::VALIDATION);
+
+        // -E and the spawned command may also be plain names (custom events, a program on PATH),
+        // they are only checked once they look like a path.
+        auto is_qualified = [](const std::wstring& value) {
+            return value.find_first_of(L"\\/") != std::wstring::npos;
+        };
+
+        std::vector<std::wstring> paths;
+        std::vector<const arg_parser_arg*> owners;
+        auto add_path = [&](const arg_parser_arg& flag, const std::wstring& value) {
+            if (std::find(paths.begin(), paths.end(), value) != paths.end()) return;
+            paths.push_back(value);
+            owners.push_back(&flag);
+        };
+
+        for (const arg_parser_arg* flag : { &pe_file_arg, &pdb_file_arg, &metric_config_arg, &output_prefix_arg })
+        {
+            for (auto& value : flag->get_values()) add_path(*flag, value);
+        }
+        for (auto& value : event_config_arg.get_values())
+        {
+            if (is_qualified(value)) add_path(event_config_arg, value);
+        }
+        if (extra_args_arg.m_is_parsed && extra_args_arg.get_value_count() > 0 && is_qualified(extra_args_arg.get_value(0)))
+            add_path(extra_args_arg, extra_args_arg.get_value(0));
+
+        if (paths.empty()) return;
+
+        std::vector<std::wstring> missing = probe_paths(paths, probe, cache);
+        if (missing.empty()) return;
+
+        std::wstring message = L"Error: the following paths do not exist:";
+        for (auto& path : missing)
+        {
+            const size_t index = std::find(paths.begin(), paths.end(), path) - paths.begin();
+            message += L"\n\t" + path + L" (" + owners[index]->get_name() + L")";
+        }
+        throw_invalid_arg(missing.front(), message);
+    }
+
+    timeline_schedule arg_parser::get_timeline_schedule() const
+    {
+        timeline_schedule schedule;
+        if (timeout_arg.m_is_parsed) schedule.m_window = timeout_arg.get<std::chrono::nanoseconds>();
+        if (!timeline_opt.m_is_parsed) return schedule;
+
+        schedule.m_interval = interval_arg.m_is_parsed ? interval_arg.get<std::chrono::nanoseconds>() : timeline_schedule::DEFAULT_INTERVAL;
+        schedule.m_iterations = iteration_arg.m_is_parsed ? static_cast<size_t>(iteration_arg.get<long long>()) : 0;
+        return schedule;
+    }
+
+    launch_options arg_parser::get_launch_options() const
+    {
+        return get_launch_options(cpu_topology::host());
+    }
+
+    launch_options arg_parser::get_launch_options(const cpu_topology& topology) const
+    {
+        if (!extra_args_arg.m_is_parsed || extra_args_arg.get_value_count() == 0)
+            throw_invalid_arg(L"--", L"Error: no command to launch after `--`.");
+
+        launch_options options;
+        options.m_argv = extra_args_arg.get_argv();
+        options.m_command_line = extra_args_arg.get_command_line();
+        options.m_cores = resolve_cores(topology);
+        if (record_spawn_delay_arg.m_is_parsed)
+            options.m_spawn_delay = std::chrono::milliseconds(record_spawn_delay_arg.get<long long>());
+        return options;
+    }
+
+    std::vector<unsigned> arg_parser::resolve_cores() const
+    {
+        return resolve_cores(cpu_topology::host());
+    }
+
+    std::vector<unsigned> arg_parser::resolve_cores(const cpu_topology& topology) const
+    {
+        std::vector<unsigned> cores;
+        std::wstring message;
+        const std::wstring* first_invalid = nullptr;
+        for (auto& value : cores_arg.get_values())
+        {
+            for (size_t begin = 0; begin <= value.size();)
+            {
+                const size_t end = (std::min)(value.find(L',', begin), value.size());
+                const std::wstring_view item = std::wstring_view(value).substr(begin, end - begin);
+                const size_t selected = cores.size();
+                if (!topology.select(item, cores))
+                {
+                    message += L"\n\t" + std::wstring(item) + L" does not exist";
+                    if (first_invalid == nullptr) first_invalid = &value;
+                }
+                else if (cores.size() == selected)
+                {
+                    message += L"\n\t" + std::wstring(item) + L" has no online cores";
+                    if (first_invalid == nullptr) first_invalid = &value;
+                }
+                begin = end + 1;
             }
-            command.append(m_arg_array.at(i));
         }
+        std::sort(cores.begin(), cores.end());
+        cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
 
-        std::size_t pos = command.find(arg);
-        if (pos == 0 || pos == std::wstring::npos) {
-            pos = command.length();
+        for (unsigned core : cores)
+        {
+            if (topology.is_online(core)) continue;
+            message += L"\n\tcore " + std::to_wstring(core) + L" is offline";
+            if (first_invalid == nullptr) first_invalid = &cores_arg.get_values().front();
         }
+        if (first_invalid != nullptr)
+            throw_invalid_arg(*first_invalid, L"Error: the following cores cannot be used:" + message);
+        return cores;
+    }
 
-        std::wstring indicator(pos, L'~');
-        indicator += L'^';
+    #pragma region error handling
+    std::wstring arg_parser::get_command_line() const
+    {
+        // m_arg_array starts after the program name, so every token it holds follows a space
+        std::wstring command = L"wperf";
+        for (auto& token : m_arg_array) {
+            command.append(L" ");
+            command.append(token);
+        }
+        return command;
+    }
 
-        /*
-        TODO: THIS function should change to use GetErrorOutputStream before migrating to wperf
+    bool arg_parser::is_json_requested() const
+    {
+        return json_opt.is_parsed() || std::any_of(m_arg_array.begin(), m_arg_array.end(),
+            [this](const std::wstring& token) { return json_opt.is_match(token); });
+    }
 
-         */
+    void arg_parser::throw_invalid_arg(const std::wstring& arg, const std::wstring& additional_message) const
+    {
+        if (is_json_requested())
+        {
+            std::string buffer;
+            json_writer json(buffer);
+            write_error_json(json, arg, additional_message);
+            buffer.push_back('\n');
+            utf8_writer error_output(*m_error_sink);
+            error_output << buffer;
+            error_output.flush();
+            throw std::invalid_argument("INVALID_ARGUMENT");
+        }
 
-        std::wostringstream error_message;
-        error_message << L"Invalid argument detected:\n"
+        const std::wstring command = get_command_line();
+        std::wstring indicator(find_error_position(command, arg), L'~');
+        indicator += L'^';
+
+        utf8_writer error_output(*m_error_sink);
+        error_output << L"Invalid argument detected:\n"
             << command << L"\n"
             << indicator << L"\n";
         if (!additional_message.empty()) {
-            error_message << additional_message << L"\n";
+            error_output << additional_message << L"\n";
         }
-        std::wcerr << error_message.str();
+        error_output.flush();
         throw std::invalid_argument("INVALID_ARGUMENT");
     }
 
+    void arg_parser::write_error_json(json_writer& json, const std::wstring& arg, const std::wstring& additional_message) const
+    {
+        const std::wstring command = get_command_line();
+        json.begin_object()
+            .key("error").begin_object()
+                .key("command_line").value(command)
+                .key("argument").value(arg)
+                .key("position").value(find_error_position(command, arg))
+                .key("message").value(additional_message)
+            .end_object()
+            .end_object();
+    }
+
+    void arg_parser::write_json(json_writer& json) const
+    {
+        // plugin commands share COMMAND_CLASS::PLUGIN, only the parsed command knows its own name
+        json.begin_object().key("command");
+        if (m_command_arg != nullptr)
+            json.value(m_command_arg->m_name);
+        else
+            json.null();
+
+        json.key("flags").begin_object();
+        for (auto& flag : m_flags_list)
+        {
+            if (!flag->m_is_parsed) continue;
+            json.key(flag->m_name);
+            // the declared arity picks the type: a variadic flag is an array even when it took nothing
+            if (flag->m_arg_count == 0 && !flag->m_is_variadic)
+            {
+                json.value(true);
+                continue;
+            }
+            json.begin_array();
+            for (size_t i = 0; i < flag->get_value_count(); ++i)
+            {
+                const std::wstring& value = flag->get_value(i);
+                unsigned long long number;
+                if (flag->m_uint_values && ArgParserArg::validators::detail::parse_uint(value, number))
+                    json.value(number);
+                else
+                    json.value(value);
+            }
+            json.end_array();
+        }
+        json.end_object().end_object();
+    }
+
+    void arg_parser::write_help_json(json_writer& json) const
+    {
+        ARG_PARSER_STATS_PHASE(m_stats, PARSE_PHASE::PRINT_HELP);
+        const auto write_aliases = [&json](const arg_parser_arg& arg) {
+            json.key("aliases").begin_array();
+            for (auto& alias : arg.m_aliases)
+            {
+                if (!alias.empty()) json.value(alias);
+            }
+            json.end_array();
+        };
+
+        json.begin_object().key("commands").begin_array();
+        for (auto& command : m_commands_list)
+        {
+            json.begin_object().key("name").value(command->m_name);
+            write_aliases(*command);
+            json.key("description").value(command->m_description)
+                .key("usage").value(command->m_useage_text)
+                .key("examples").begin_array();
+            for (auto& example : command->m_examples)
+                json.value(example);
+            json.end_array().end_object();
+        }
+        json.end_array().key("flags").begin_array();
+        for (auto& flag : m_flags_list)
+        {
+            json.begin_object().key("name").value(flag->m_name);
+            write_aliases(*flag);
+            json.key("description").value(flag->m_description)
+                .key("arg_count").value(flag->m_arg_count)
+                .end_object();
+        }
+        json.end_array().end_object();
+    }
+
     #pragma endregion
 
     wstring arg_parser_arg_command::get_usage_text() const
@@ -36,8 +36,22 @@
 #include <array>
 #include <string>
 #include <set>
+#include <memory>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include "arg-parser-arg.h"
+#include "arg-parser-catalogue.h"
+#include "arg-parser-constraints.h"
+#include "arg-parser-json.h"
+#include "arg-parser-launcher.h"
+#include "arg-parser-output.h"
+#include "arg-parser-stats.h"
+#include "arg-parser-path-validator.h"
+#include "arg-parser-scheduler.h"
+#include "arg-parser-symbol-matcher.h"
+#include "arg-parser-timeline.h"
+#include "arg-parser-topology.h"
 
 using namespace std;
 
@@ -56,28 +70,151 @@ namespace ArgParser {
         VERSION,
         LIST,
         MAN,
-        NO_COMMAND
+        NO_COMMAND,
+        // a command registered at runtime through plugin_registry, see arg_parser::get_command_arg
+        PLUGIN,
+        DAEMON
     };
+
+    // The name and aliases of every built-in command, its name first. The command specs of
+    // arg_parser take theirs from here and arg_parser::sniff_command matches against the same
+    // table, so the two cannot drift apart.
+    struct command_token {
+        const wchar_t* m_token;
+        COMMAND_CLASS m_command;
+    };
+    inline constexpr command_token k_command_tokens[] = {
+        { L"stat", COMMAND_CLASS::STAT },
+        { L"record", COMMAND_CLASS::RECORD },
+        { L"sample", COMMAND_CLASS::SAMPLE },
+        { L"list", COMMAND_CLASS::LIST },
+        { L"-l", COMMAND_CLASS::LIST },
+        { L"man", COMMAND_CLASS::MAN },
+        { L"test", COMMAND_CLASS::TEST },
+        { L"detect", COMMAND_CLASS::DETECT },
+        { L"-h", COMMAND_CLASS::HELP },
+        { L"--help", COMMAND_CLASS::HELP },
+        { L"--version", COMMAND_CLASS::VERSION },
+        { L"--daemon", COMMAND_CLASS::DAEMON }
+    };
+    // The first token of command in k_command_tokens, and the ones after it
+    std::wstring command_name(COMMAND_CLASS command);
+    std::vector<std::wstring> command_aliases(COMMAND_CLASS command);
+
     class arg_parser_arg_command : public arg_parser_arg_opt {
 
     public:
         arg_parser_arg_command(
-            const std::wstring name,
-            const std::vector<std::wstring> alias,
-            const std::wstring description,
-            const std::wstring useage_text,
+            std::wstring name,
+            std::vector<std::wstring> alias,
+            std::wstring description,
+            std::wstring useage_text,
             const COMMAND_CLASS command,
-            const wstr_vec examples
-            ) : arg_parser_arg_opt(name, alias, description), m_examples(examples), m_command(command), m_useage_text(useage_text) {};
-        const COMMAND_CLASS m_command = COMMAND_CLASS::NO_COMMAND;
-        const wstr_vec m_examples;
-        const std::wstring m_useage_text;
+            wstr_vec examples,
+            const int arg_count = 0
+            ) : arg_parser_arg_opt(std::move(name), std::move(alias), std::move(description)), m_examples(std::move(examples)), m_command(command), m_useage_text(std::move(useage_text))
+        {
+            // values that directly follow the command, for example the names given to `man`
+            m_arg_count = arg_count;
+        };
+        COMMAND_CLASS m_command = COMMAND_CLASS::NO_COMMAND;
+        wstr_vec m_examples;
+        std::wstring m_useage_text;
 
         wstring get_usage_text() const override;
 
         wstring get_examples() const;
 
     };
+    // arg_builder counterpart for commands:
+    //
+    //   arg_parser_arg_command man_command = command_builder(L"man", COMMAND_CLASS::MAN)
+    //       .description(L"...").usage(L"wperf man <event|metric>").example(L"> wperf man ld_spec").arg_count(1).build();
+    class command_builder {
+    public:
+        command_builder(std::wstring_view name, COMMAND_CLASS command) : m_name(name), m_command(command) {}
+
+        command_builder& alias(std::wstring_view alias)
+        {
+            m_aliases.emplace_back(alias);
+            return *this;
+        }
+        command_builder& description(std::wstring_view description)
+        {
+            m_description.assign(description);
+            return *this;
+        }
+        command_builder& usage(std::wstring_view usage)
+        {
+            m_usage.assign(usage);
+            return *this;
+        }
+        command_builder& example(std::wstring_view example)
+        {
+            m_examples.emplace_back(example);
+            return *this;
+        }
+        command_builder& arg_count(int arg_count)
+        {
+            m_arg_count = arg_count;
+            return *this;
+        }
+
+        // Moves the collected spec into a new command; the builder is left empty.
+        arg_parser_arg_command build()
+        {
+            return arg_parser_arg_command(std::move(m_name), std::move(m_aliases), std::move(m_description),
+                std::move(m_usage), m_command, std::move(m_examples), m_arg_count);
+        }
+
+    private:
+        std::wstring m_name;
+        wstr_vec m_aliases;
+        std::wstring m_description;
+        std::wstring m_usage;
+        COMMAND_CLASS m_command;
+        wstr_vec m_examples;
+        int m_arg_count = 0;
+    };
+
+    // Commands and flags a plugin adds to the parser at runtime. They are collected here and handed
+    // to arg_parser::register_plugins in one go, so the parser rebuilds its lookup index once however
+    // many of them there are. add_command and add_flag throw std::invalid_argument when a name or
+    // alias is already taken in the registry; clashes with the parser's own names are reported by
+    // register_plugins.
+    //
+    //   plugin_registry registry;
+    //   registry.add_command(command_builder(L"trace", COMMAND_CLASS::PLUGIN).description(L"...").build());
+    //   auto& depth = registry.add_flag(arg_builder<arg_parser_arg_pos>(L"--depth").validator<validators::is_uint>().build());
+    //   parser.register_plugins(std::move(registry));
+    //
+    // The returned references stay valid after registration, the parser takes over the same objects.
+    class plugin_registry {
+    public:
+        arg_parser_arg_command& add_command(arg_parser_arg_command command);
+        template <class Arg>
+        Arg& add_flag(Arg flag)
+        {
+            static_assert(std::is_base_of_v<arg_parser_arg, Arg>, "plugin flags are arg_parser_arg types");
+            static_assert(!std::is_base_of_v<arg_parser_arg_command, Arg>, "commands are added with add_command");
+            auto owned = std::make_unique<Arg>(std::move(flag));
+            Arg& added = *owned;
+            adopt_flag(std::move(owned));
+            return added;
+        }
+
+    private:
+        friend class arg_parser;
+
+        void adopt_flag(std::unique_ptr<arg_parser_arg> flag);
+        void reserve_names(const arg_parser_arg& arg);
+
+        std::vector<std::unique_ptr<arg_parser_arg_command>> m_commands;
+        std::vector<std::unique_ptr<arg_parser_arg>> m_flags;
+        // views into the names of the owned args, which stay where they are
+        std::unordered_set<std::wstring_view> m_names;
+    };
+
     #pragma region arg structs
 
 
@@ -92,13 +229,72 @@ namespace ArgParser {
             _In_ const int argc,
             _In_reads_(argc) const wchar_t* argv[]
         );
+        // UTF-8 argv, transcoded once into the same token storage as the wide overload.
+        void parse(
+            _In_ const int argc,
+            _In_reads_(argc) const char* argv[]
+        );
         void print_help() const;
+        // Where print_help and parse errors are written, stdout and stderr unless replaced. Sinks
+        // are not owned and must outlive the parser, or be replaced before they go away.
+        void set_output_sink(output_sink& sink);
+        void set_error_sink(output_sink& sink);
+        output_sink& get_output_sink() const;
+        output_sink& get_error_sink() const;
+        // Back to the state of a freshly constructed parser, keeping its allocations where it can;
+        // tokens, command, flag values and the compiled --symbol patterns are all dropped.
+        void reset();
+        // Takes over the commands and flags of registry, which parse, reset and print in help like
+        // the built-in ones. Throws std::invalid_argument and registers nothing when one of their
+        // names is already used by the parser. The lookup index is rebuilt once per call.
+        void register_plugins(plugin_registry&& registry);
+        // The command the last parse selected, nullptr before; tells COMMAND_CLASS::PLUGIN commands apart
+        const arg_parser_arg_command* get_command_arg() const;
+        // Classifies argv by its first token only, without constructing or allocating anything.
+        // Returns NO_COMMAND when the first token is not a built-in command; plugin commands are
+        // registered on a parser instance and are never sniffed.
+        static COMMAND_CLASS sniff_command(
+            _In_ const int argc,
+            _In_reads_(argc) const wchar_t* argv[]
+        ) noexcept;
+        const parse_stats& get_stats() const;
+        // JSON forms of the parse result, the help catalogue and a parse error, used with --json
+        void write_json(json_writer& json) const;
+        void write_help_json(json_writer& json) const;
+        void write_error_json(json_writer& json, const std::wstring& arg, const std::wstring& additional_message) const;
+        // --symbol patterns compiled at parse time, matches everything when --symbol is not given
+        const symbol_matcher& get_symbol_matcher() const;
+        // Checks that the files named by path flags exist, probing them concurrently and
+        // reporting every missing path in one error. The default overload uses the file system
+        // and the process-wide probe cache.
+        void validate_paths() const;
+        void validate_paths(const path_probe& probe, path_probe_cache* cache) const;
+        // The CPUs -c selects, sorted and without duplicates, with the topology selectors expanded.
+        // Checks that every CPU exists and is online, reporting all that are not in one error.
+        // Like validate_paths this looks at the host, so parse leaves it to the caller. The default
+        // overload uses cpu_topology::host(); empty when -c is not given.
+        std::vector<unsigned> resolve_cores() const;
+        std::vector<unsigned> resolve_cores(const cpu_topology& topology) const;
+        // Creates the files timeline mode writes its rows to, --output-csv and --output resolved
+        // under --output-prefix, and hands them to the caller. parse only checks that they can be
+        // created, so a bad path fails before anything is measured without touching the disk; like
+        // validate_paths this step is left to the caller. A sink is null unless -t is given with
+        // its flag. Reports every file that cannot be opened in one error.
+        timeline_outputs open_timeline_outputs() const;
+        // The windows --timeout, -t, -i and -n describe, for timeline_scheduler. Without -t this is
+        // a single window; -i defaults to a minute and a missing -n or --timeout runs until cancelled.
+        timeline_schedule get_timeline_schedule() const;
+        // What record spawns: the command after --, the -c cores as resolve_cores gives them and
+        // --record_spawn_delay in milliseconds. m_argv points into the parser and is valid until it
+        // parses again. Reports a missing command like a parse error.
+        launch_options get_launch_options() const;
+        launch_options get_launch_options(const cpu_topology& topology) const;
     #pragma endregion
 
     #pragma region Commands
         arg_parser_arg_command list_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"list",
-            { L"-l" },
+            command_name(COMMAND_CLASS::LIST),
+            command_aliases(COMMAND_CLASS::LIST),
             L"List supported events and metrics. Enable verbose mode for more details.",
             L"wperf list [-v] [--json] [--force-lock]",
             COMMAND_CLASS::LIST,
@@ -107,40 +303,40 @@ namespace ArgParser {
             }
         );
         arg_parser_arg_command test_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"test",
-            { L"" },
+            command_name(COMMAND_CLASS::TEST),
+            command_aliases(COMMAND_CLASS::TEST),
             L"Configuration information about driver and application.",
             L"wperf test [--json] [OPTIONS]",
             COMMAND_CLASS::TEST,
             {}
         );
         arg_parser_arg_command help_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"-h",
-            { L"--help" },
+            command_name(COMMAND_CLASS::HELP),
+            command_aliases(COMMAND_CLASS::HELP),
             L"Run wperf help command.",
             L"wperf help",
             COMMAND_CLASS::HELP,
             {}
         );
         arg_parser_arg_command version_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"--version",
-            { L"" },
+            command_name(COMMAND_CLASS::VERSION),
+            command_aliases(COMMAND_CLASS::VERSION),
             L"Display version.",
             L"wperf --version",
             COMMAND_CLASS::VERSION,
             {}
         );
         arg_parser_arg_command detect_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"detect",
-            { L"" },
+            command_name(COMMAND_CLASS::DETECT),
+            command_aliases(COMMAND_CLASS::DETECT),
             L"List installed WindowsPerf-like Kernel Drivers (match GUID).",
             L"wperf detect [--json] [OPTIONS]",
             COMMAND_CLASS::DETECT,
             {}
         );
         arg_parser_arg_command sample_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"sample",
-            { L"" },
+            command_name(COMMAND_CLASS::SAMPLE),
+            command_aliases(COMMAND_CLASS::SAMPLE),
             L"Sampling mode, for determining the frequencies of event occurrences produced by program locations at the function, basic block, and /or instruction levels.",
             L"wperf sample [-e] [--timeout] [-c] [-C] [-E] [-q] [--json] [--output] [--config] [--image_name] [--pe_file] [--pdb_file] [--sample-display-long] [--force-lock] [--sample-display-row] [--symbol] [--record_spawn_delay] [--annotate] [--disassemble]",
              COMMAND_CLASS::SAMPLE,
@@ -149,21 +345,21 @@ namespace ArgParser {
             }
         );
         arg_parser_arg_command record_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"record",
-            { L"" },
+            command_name(COMMAND_CLASS::RECORD),
+            command_aliases(COMMAND_CLASS::RECORD),
             L"Same as sample but also automatically spawns the process and pins it to the core specified by `-c`. Process name is defined by COMMAND.User can pass verbatim arguments to the process with[ARGS].",
             L"wperf record [-e] [--timeout] [-c] [-C] [-E] [-q] [--json] [--output] [--config] [--image_name] [--pe_file] [--pdb_file] [--sample-display-long] [--force-lock] [--sample-display-row] [--symbol] [--record_spawn_delay] [--annotate] [--disassemble] --COMMAND[ARGS]",
             COMMAND_CLASS::RECORD,
             {
                 L"> wperf record -e ld_spec:100000 -c 1 --timeout 30 -- python_d.exe -c 10**10**100 Launch `python_d.exe - c 10 * *10 * *100` process and start sampling event `ld_spec` with frequency `100000` on core #1 for 30 seconds. Hint: add `--annotate` or `--disassemble` to `wperf record` command line parameters to increase sampling \"resolution\"."
     #ifdef ENABLE_SPE
-               ,L"(> wperf record -e arm_spe_0/ld=1/ -c 8 --cpython\PCbuild\arm64\python_d.exe -c 10**10**100 Launch `python_d.exe -c 10**10**100` process on core no. 8 and start SPE sampling, enable collection of load sampled operations, including atomic operations that return a value to a register. Hint: add `--annotate` or `--disassemble` to `wperf record` command."
+               ,L"> wperf record -e arm_spe_0/ld=1/ -c 8 -- cpython\\PCbuild\\arm64\\python_d.exe -c 10**10**100 Launch `python_d.exe -c 10**10**100` process on core no. 8 and start SPE sampling, enable collection of load sampled operations, including atomic operations that return a value to a register. Hint: add `--annotate` or `--disassemble` to `wperf record` command."
     #endif
             }
         );
         arg_parser_arg_command count_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"stat",
-            { L"" },
+            command_name(COMMAND_CLASS::STAT),
+            command_aliases(COMMAND_CLASS::STAT),
             L"Counting mode, for obtaining aggregate counts of occurrences of special events.",
             L"wperf stat [-e] [-m] [-t] [-i] [-n] [-c] [-C] [-E] [-k] [--dmc] [-q] [--json] [--output][--config] [--force-lock] --COMMAND[ARGS]",
             COMMAND_CLASS::STAT,
@@ -174,14 +370,22 @@ namespace ArgParser {
             }
         );
         arg_parser_arg_command man_command = arg_parser_arg_command::arg_parser_arg_command(
-            L"man",
-            { L"" },
+            command_name(COMMAND_CLASS::MAN),
+            command_aliases(COMMAND_CLASS::MAN),
             L"Plain text information about one or more specified event(s), metric(s), and or group metric(s).",
-            L"wperf man [--json]",
+            L"wperf man <event|metric>[,...] [--json]",
             COMMAND_CLASS::MAN,
             {
-            }
-        );
+                L"> wperf man ld_spec,imix Describe event `ld_spec` and metric `imix`."
+            },
+            1
+        );
+        arg_parser_arg_command daemon_command = command_builder(command_name(COMMAND_CLASS::DAEMON), COMMAND_CLASS::DAEMON)
+            .description(L"Parse command lines sent over a Unix domain socket, see arg-parser-daemon.h for the protocol, until stopped with Ctrl + C.")
+            .usage(L"wperf --daemon <SOCKET>")
+            .example(L"> wperf --daemon wperf.sock Serve parse requests on `wperf.sock` in the current directory.")
+            .arg_count(1)
+            .build();
 
     #pragma endregion
 
@@ -241,23 +445,25 @@ namespace ArgParser {
             L"Enable timeline mode (count multiple times with specified interval). Use `-i` to specify timeline interval, and `-n` to specify number of counts.",
             {}
         );
+        // hidden: not listed in print_help
+        arg_parser_arg_opt parser_stats_opt = arg_builder<arg_parser_arg_opt>(L"--parser-stats")
+            .description(L"Print parser instrumentation counters as JSON.")
+            .build();
 
 
     #pragma endregion
 
     #pragma region Flags with arguments
-        arg_parser_arg_pos extra_args_arg = arg_parser_arg_pos::arg_parser_arg_pos(
+        arg_parser_arg_passthrough extra_args_arg = arg_parser_arg_passthrough::arg_parser_arg_passthrough(
             L"--",
             {},
-            L"-- Process name is defined by COMMAND. User can pass verbatim arguments to the process with[ARGS].",
-            {},
-            -1
+            L"-- Process name is defined by COMMAND. User can pass verbatim arguments to the process with[ARGS]."
         );
 
         arg_parser_arg_pos cores_arg = arg_parser_arg_pos::arg_parser_arg_pos(
             L"-c",
             { L"--cores" },
-            L"Specify comma separated list of CPU cores, and or ranges of CPU cores, to count on, or one CPU to sample on.",
+            L"Specify comma separated list of CPU cores, and or ranges of CPU cores, to count on, or one CPU to sample on. Cores can also be selected by topology: `all`, `online`, `node<N>`, `cluster<N>`, `smt-siblings-of:<CORE>` and `cache-domain-of:<CORE>`, which select only online cores.",
             {}
         );
 
@@ -346,7 +552,7 @@ namespace ArgParser {
             {}
         );
         arg_parser_arg_pos iteration_arg = arg_parser_arg_pos::arg_parser_arg_pos(
-            L"-i",
+            L"-n",
             {},
             L"Number of consecutive counts in timeline mode (disabled by default).",
             {}
@@ -383,7 +589,8 @@ namespace ArgParser {
            &list_command,
            &test_command,
            &detect_command,
-           &man_command
+           &man_command,
+           &daemon_command
         };
     
         std::vector<arg_parser_arg*> m_flags_list = {
@@ -418,6 +625,11 @@ namespace ArgParser {
            &extra_args_arg
         };
 
+        // probed after m_flags_list, but never printed by print_help
+        std::vector<arg_parser_arg*> m_hidden_flags_list = {
+           &parser_stats_opt
+        };
+
         wstr_vec m_arg_array;
 
     #pragma endregion
@@ -425,7 +637,46 @@ namespace ArgParser {
     #pragma region Protected Methods
     protected:
         void throw_invalid_arg(const std::wstring& arg, const std::wstring& additional_message = L"") const;
+        std::wstring get_command_line() const;
+        // --json anywhere on the command line, also before the flag loop has reached it
+        bool is_json_requested() const;
+        // Parses the tokens both parse overloads ingested into m_arg_array from first_token on
+        void parse_tokens(size_t first_token);
+        // Selects the command at first_token and returns the position of the first flag after it
+        size_t parse_command(size_t first_token);
+        void parse_flags(size_t position);
+        // The flag a token names, through m_flag_index; nullptr if none
+        arg_parser_arg* match_flag(std::wstring_view token) const;
+        // Rebuilds m_command_index and m_flag_index from the command and flag lists
+        void build_index();
+        // Whether validate_parsed_args reads the flag, so a change to it has to be validated again
+        bool is_validated_flag(const arg_parser_arg* flag) const;
+        // Applies m_constraints to the parsed flags, reporting every broken rule in one error
+        void check_flag_rules();
+        // Checks and conversions that need the whole command line, run once after the flag loop;
+        // starts with check_flag_rules
+        void validate_parsed_args();
+        // The timeline outputs open_timeline_outputs creates, with the flag that names each
+        std::vector<std::pair<const arg_parser_arg*, std::filesystem::path>> get_timeline_output_paths() const;
+        // Checks for validate_parsed_args that every timeline output can be created, reporting all that cannot in one error
+        void check_timeline_outputs() const;
     #pragma endregion
+
+        mutable parse_stats m_stats;
+        symbol_matcher m_symbol_matcher;
+        // the cross-flag rules of the built-in flags, checked by validate_parsed_args
+        flag_constraints m_constraints;
+        output_sink* m_output_sink = &get_stdout_sink();
+        output_sink* m_error_sink = &get_stderr_sink();
+
+        // Every name and alias to its command or flag, so a token costs one lookup however many
+        // plugins are registered. The keys view the names stored in the args themselves; where
+        // built-in names overlap, the first list entry wins as it did when the lists were probed.
+        std::unordered_map<std::wstring_view, arg_parser_arg_command*> m_command_index;
+        std::unordered_map<std::wstring_view, arg_parser_arg*> m_flag_index;
+        const arg_parser_arg_command* m_command_arg = nullptr;
+        // owns the commands and flags taken over by register_plugins
+        std::vector<std::unique_ptr<arg_parser_arg>> m_plugin_args;
     };
 
 }
@@ -28,14 +28,46 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include <iostream>
+#include <cstdio>
+#include <windows.h>
 #include "arg-parser.h"
+#include "arg-parser-catalogue.h"
+#include "arg-parser-daemon.h"
+#include "arg-parser-json.h"
+#include "arg-parser-output.h"
+#include "arg-parser-tokenizer.h"
+#include "arg-parser-utf8.h"
+
+// The daemon Ctrl + C and closing the console stop, so its socket file does not outlive it
+static ArgParser::daemon_server* g_daemon = nullptr;
+
+static BOOL WINAPI stop_daemon(DWORD)
+{
+    g_daemon->stop();
+    return TRUE;
+}
+
+static void write_greeting(ArgParser::utf8_writer& output, const wchar_t* command, bool annotate)
+{
+    output << L"Hello " << command << (annotate ? L"annotate" : L"no annotate") << L" World!\n";
+}
 
 int wmain(
     _In_ const int argc,
     _In_reads_(argc) const wchar_t* argv[]
 )
 {
+    // `--version` needs neither the flag spec nor the console code page, so it is answered before
+    // either is set up; tools/cold-start.ps1 keeps this path within its startup budget
+    if (argc == 2 && ArgParser::arg_parser::sniff_command(argc, argv) == ArgParser::COMMAND_CLASS::VERSION)
+    {
+        ArgParser::utf8_writer output(ArgParser::get_stdout_sink());
+        write_greeting(output, argv[1], false);
+        return 0;
+    }
+
+    // all output is written as UTF-8, see ArgParser::utf8_writer
+    SetConsoleOutputCP(CP_UTF8);
     ArgParser::arg_parser parser;
     parser.parse(argc, argv);
     if (parser.m_command == ArgParser::COMMAND_CLASS::HELP)
@@ -43,5 +75,75 @@ int wmain(
         parser.print_help();
         return 0;
     }
-    std::wcout << L"Hello " << argv[1]<< (parser.annotate_opt.is_set() ? L"annotate" : L"no annotate") << L" World!\n";
+    // `wperf --daemon <socket>` parses command lines sent over a Unix domain socket until it is stopped
+    if (parser.m_command == ArgParser::COMMAND_CLASS::DAEMON)
+    {
+        ArgParser::daemon_server server(ArgParser::wide_to_utf8(parser.daemon_command.get_values().front()));
+        try
+        {
+            server.listen();
+        }
+        catch (const std::exception& err)
+        {
+            ArgParser::utf8_writer error_output(ArgParser::get_stderr_sink());
+            error_output << "Error: " << err.what() << "\n";
+            return 1;
+        }
+        g_daemon = &server;
+        SetConsoleCtrlHandler(stop_daemon, TRUE);
+        server.run();
+        SetConsoleCtrlHandler(stop_daemon, FALSE);
+        return 0;
+    }
+    parser.validate_paths();
+    // -q: nothing is written to stdout, errors still go to stderr
+    ArgParser::output_sink& stdout_sink = parser.quite_opt.is_set() ? ArgParser::get_null_sink() : ArgParser::get_stdout_sink();
+    parser.set_output_sink(stdout_sink);
+    ArgParser::utf8_writer output(stdout_sink);
+    std::string json_buffer;
+    ArgParser::json_writer json(json_buffer);
+    if (parser.m_command == ArgParser::COMMAND_CLASS::LIST)
+    {
+        if (parser.json_opt.is_set())
+        {
+            ArgParser::write_catalogue(json);
+            output << json_buffer << "\n";
+        }
+        else
+        {
+            ArgParser::write_catalogue(output);
+        }
+        return 0;
+    }
+    if (parser.m_command == ArgParser::COMMAND_CLASS::MAN)
+    {
+        // names were checked against the catalogue during parsing
+        std::vector<ArgParser::token_span<wchar_t>> names;
+        ArgParser::tokenize(parser.man_command.get_values().front(), names);
+        if (parser.json_opt.is_set()) json.begin_array();
+        for (auto& name : names)
+        {
+            if (name.m_text.empty()) continue;
+            if (parser.json_opt.is_set())
+                ArgParser::write_manual(name.m_text, json);
+            else
+                ArgParser::write_manual(name.m_text, output);
+        }
+        if (parser.json_opt.is_set())
+        {
+            json.end_array();
+            output << json_buffer << "\n";
+        }
+        return 0;
+    }
+    if (parser.json_opt.is_set())
+    {
+        parser.write_json(json);
+        output << json_buffer << "\n";
+    }
+    if (parser.parser_stats_opt.is_set())
+    {
+        output << parser.get_stats().to_json() << L"\n";
+    }
+    write_greeting(output, argv[1], parser.annotate_opt.is_set());
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+# BSD 3-Clause License
+#
+# Copyright (c) 2024, Arm Limited
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice, this
+#    list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# 3. Neither the name of the copyright holder nor the names of its
+#    contributors may be used to endorse or promote products derived from
+#    this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+<#
+.SYNOPSIS
+    Cold-start benchmark for parser.exe.
+
+.DESCRIPTION
+    Measures exec-to-exit time of `--version`, `-h` and a typical `stat` command line, and
+    fails when the median of a scenario is over its budget in cold-start-budget.json
+    (milliseconds). The first run of each scenario only warms the file cache and is not counted.
+
+.EXAMPLE
+    pwsh -File tools\cold-start.ps1 -Exe x64\Release\parser.exe -Output test-results\cold-start.json
+#>
+param(
+    [string]$Exe = "x64\Release\parser.exe",
+    [int]$Runs = 50,
+    [string]$Budget = (Join-Path $PSScriptRoot "cold-start-budget.json"),
+    [string]$Output = ""
+)
+
+$ErrorActionPreference = "Stop"
+
+$scenarios = [ordered]@{
+    "version" = "--version"
+    "help"    = "-h"
+    "stat"    = "stat -e ld_spec,vfp_spec -c 0 --timeout 1 -t -n 2"
+}
+
+$exePath = (Resolve-Path $Exe).Path
+$budgets = Get-Content $Budget -Raw | ConvertFrom-Json
+
+function Measure-Run([string]$arguments) {
+    $info = New-Object System.Diagnostics.ProcessStartInfo
+    $info.FileName = $exePath
+    $info.Arguments = $arguments
+    $info.UseShellExecute = $false
+    $info.RedirectStandardOutput = $true
+    $info.RedirectStandardError = $true
+    $info.CreateNoWindow = $true
+
+    $watch = [System.Diagnostics.Stopwatch]::StartNew()
+    $process = [System.Diagnostics.Process]::Start($info)
+    $stdout = $process.StandardOutput.ReadToEndAsync()
+    $stderr = $process.StandardError.ReadToEndAsync()
+    $process.WaitForExit()
+    $watch.Stop()
+    [void]$stdout.Result
+    [void]$stderr.Result
+
+    if ($process.ExitCode -ne 0) {
+        throw "parser.exe $arguments exited with $($process.ExitCode)"
+    }
+    return $watch.Elapsed.TotalMilliseconds
+}
+
+function Get-Percentile([double[]]$sorted, [double]$percentile) {
+    $index = [Math]::Min($sorted.Length - 1, [int][Math]::Floor($sorted.Length * $percentile))
+    return $sorted[$index]
+}
+
+$results = [ordered]@{}
+$failed = $false
+foreach ($name in $scenarios.Keys) {
+    [void](Measure-Run $scenarios[$name])
+    $times = @(1..$Runs | ForEach-Object { Measure-Run $scenarios[$name] }) | Sort-Object
+    $median = Get-Percentile $times 0.5
+    $p90 = Get-Percentile $times 0.9
+    $limit = $budgets.$name
+
+    $status = "ok"
+    if ($null -ne $limit -and $median -gt $limit) {
+        $status = "OVER BUDGET"
+        $failed = $true
+    }
+    $results[$name] = [ordered]@{ median_ms = $median; p90_ms = $p90; budget_ms = $limit }
+    "{0,-8} median {1,7:N2} ms  p90 {2,7:N2} ms  budget {3,4} ms  {4}" -f $name, $median, $p90, $limit, $status
+}
+
+if ($Output) {
+    $directory = Split-Path -Parent $Output
+    if ($directory) { [void](New-Item -ItemType Directory -Force -Path $directory) }
+    $results | ConvertTo-Json | Set-Content -Path $Output -Encoding utf8
+}
+
+if ($failed) { exit 1 }